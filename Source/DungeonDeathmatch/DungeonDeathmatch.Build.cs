@@ -20,6 +20,7 @@ public class DungeonDeathmatch : ModuleRules
             "Slate",
             "SlateCore",
             "AIModule",
+            "NavigationSystem",
             "OnlineSubsystem",
             "OnlineSubsystemSteam",
             "RHI",
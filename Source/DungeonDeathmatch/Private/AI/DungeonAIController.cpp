@@ -5,11 +5,13 @@
 #include "DungeonCharacter.h"
 #include "PlayerCharacter.h"
 #include "AIGlobals.h"
+#include "DungeonRoomRouteComponent.h"
 
 #include <BehaviorTree/BlackboardComponent.h>
 #include <BehaviorTree/Blackboard/BlackboardKeyAllTypes.h>
 #include <BehaviorTree/BehaviorTree.h>
 #include <BehaviorTree/BehaviorTreeComponent.h>
+#include <Navigation/PathFollowingComponent.h>
 #include <Perception/AIPerceptionComponent.h>
 #include <Perception/AISenseConfig_Sight.h>
 #include <Perception/AISenseConfig_Hearing.h>
@@ -19,6 +21,12 @@ ADungeonAIController::ADungeonAIController()
 {
 	PrimaryActorTick.bCanEverTick = true;
 
+	RoomRouteIndex = 0;
+	RoomRouteAcceptanceRadius = -1.0f;
+	bIsFollowingRoomRoute = false;
+	bDidRoomRouteSucceed = false;
+	bIsRequestingRoomRouteMove = false;
+
 	BlackboardComponent = CreateDefaultSubobject<UBlackboardComponent>(TEXT("BlackboardComponent"));
 
 	BehaviorTreeComponent = CreateDefaultSubobject<UBehaviorTreeComponent>(TEXT("BehaviorTreeComponent"));
@@ -265,3 +273,99 @@ void ADungeonAIController::OnTargetLost()
 	BlackboardComponent->SetValueAsObject(BLACKBOARD_KEYNAME_COMBATTARGET, nullptr);
 	SetAIState(EAIState::Patrol);
 }
+
+bool ADungeonAIController::MoveToLocationViaRooms(const FVector& Goal, float AcceptanceRadius)
+{
+	StopRoomRoute();
+	if (!GetPawn())
+	{
+		return false;
+	}
+
+	if (!RoomRouteComponent.IsValid())
+	{
+		RoomRouteComponent = UDungeonRoomRouteComponent::FindInWorld(GetWorld());
+	}
+
+	if (RoomRouteComponent.IsValid())
+	{
+		if (!RoomRouteComponent->FindRoomRoute(GetPawn()->GetActorLocation(), Goal, RoomRoute))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ADungeonAIController::MoveToLocationViaRooms - %s found no room route to %s"), *GetPawn()->GetName(), *Goal.ToString());
+			return false;
+		}
+	}
+	else
+	{
+		RoomRoute.Reset();
+		RoomRoute.Add(Goal);
+	}
+
+	RoomRouteIndex = 0;
+	RoomRouteAcceptanceRadius = AcceptanceRadius;
+	bIsFollowingRoomRoute = true;
+	bDidRoomRouteSucceed = false;
+	MoveToNextRoomRouteWaypoint();
+	return bIsFollowingRoomRoute || bDidRoomRouteSucceed;
+}
+
+void ADungeonAIController::StopRoomRoute()
+{
+	if (bIsFollowingRoomRoute)
+	{
+		bIsFollowingRoomRoute = false;
+		StopMovement();
+	}
+	RoomRoute.Reset();
+	RoomRouteIndex = 0;
+}
+
+void ADungeonAIController::OnMoveCompleted(FAIRequestID RequestID, const FPathFollowingResult& Result)
+{
+	Super::OnMoveCompleted(RequestID, Result);
+
+	if (!bIsFollowingRoomRoute || bIsRequestingRoomRouteMove)
+	{
+		return;
+	}
+
+	if (!Result.IsSuccess())
+	{
+		FinishRoomRoute(false);
+		return;
+	}
+
+	RoomRouteIndex++;
+	MoveToNextRoomRouteWaypoint();
+}
+
+void ADungeonAIController::MoveToNextRoomRouteWaypoint()
+{
+	while (RoomRouteIndex < RoomRoute.Num())
+	{
+		const bool bIsGoal = RoomRouteIndex == RoomRoute.Num() - 1;
+		bIsRequestingRoomRouteMove = true;
+		EPathFollowingRequestResult::Type RequestResult = MoveToLocation(RoomRoute[RoomRouteIndex], bIsGoal ? RoomRouteAcceptanceRadius : RoomRouteWaypointRadius, true, true, true);
+		bIsRequestingRoomRouteMove = false;
+
+		if (RequestResult == EPathFollowingRequestResult::RequestSuccessful)
+		{
+			return;
+		}
+		if (RequestResult == EPathFollowingRequestResult::Failed)
+		{
+			FinishRoomRoute(false);
+			return;
+		}
+		RoomRouteIndex++;
+	}
+	FinishRoomRoute(true);
+}
+
+void ADungeonAIController::FinishRoomRoute(bool bSucceeded)
+{
+	bIsFollowingRoomRoute = false;
+	bDidRoomRouteSucceed = bSucceeded;
+	RoomRoute.Reset();
+	RoomRouteIndex = 0;
+}
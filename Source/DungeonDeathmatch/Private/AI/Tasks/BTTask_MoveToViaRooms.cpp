@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTTask_MoveToViaRooms.h"
+#include "DungeonAIController.h"
+
+#include <BehaviorTree/BehaviorTreeComponent.h>
+#include <BehaviorTree/BlackboardComponent.h>
+#include <BehaviorTree/Blackboard/BlackboardKeyType_Object.h>
+#include <BehaviorTree/Blackboard/BlackboardKeyType_Vector.h>
+
+UBTTask_MoveToViaRooms::UBTTask_MoveToViaRooms()
+{
+	NodeName = "Move To Via Rooms";
+	bNotifyTick = true;
+	AcceptanceRadius = 50.0f;
+
+	BlackboardKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_MoveToViaRooms, BlackboardKey), AActor::StaticClass());
+	BlackboardKey.AddVectorFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_MoveToViaRooms, BlackboardKey));
+}
+
+EBTNodeResult::Type UBTTask_MoveToViaRooms::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	Super::ExecuteTask(OwnerComp, NodeMemory);
+
+	ADungeonAIController* Controller = Cast<ADungeonAIController>(OwnerComp.GetAIOwner());
+	UBlackboardComponent* BlackboardComponent = OwnerComp.GetBlackboardComponent();
+	if (!Controller || !BlackboardComponent)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	FVector Goal;
+	if (BlackboardKey.SelectedKeyType == UBlackboardKeyType_Object::StaticClass())
+	{
+		AActor* GoalActor = Cast<AActor>(BlackboardComponent->GetValue<UBlackboardKeyType_Object>(BlackboardKey.GetSelectedKeyID()));
+		if (!GoalActor)
+		{
+			return EBTNodeResult::Failed;
+		}
+		Goal = GoalActor->GetActorLocation();
+	}
+	else
+	{
+		Goal = BlackboardComponent->GetValue<UBlackboardKeyType_Vector>(BlackboardKey.GetSelectedKeyID());
+	}
+
+	if (!Controller->MoveToLocationViaRooms(Goal, AcceptanceRadius))
+	{
+		return EBTNodeResult::Failed;
+	}
+	return Controller->IsFollowingRoomRoute() ? EBTNodeResult::InProgress : EBTNodeResult::Succeeded;
+}
+
+EBTNodeResult::Type UBTTask_MoveToViaRooms::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	ADungeonAIController* Controller = Cast<ADungeonAIController>(OwnerComp.GetAIOwner());
+	if (Controller)
+	{
+		Controller->StopRoomRoute();
+	}
+	return Super::AbortTask(OwnerComp, NodeMemory);
+}
+
+void UBTTask_MoveToViaRooms::TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds)
+{
+	Super::TickTask(OwnerComp, NodeMemory, DeltaSeconds);
+
+	ADungeonAIController* Controller = Cast<ADungeonAIController>(OwnerComp.GetAIOwner());
+	if (!Controller)
+	{
+		FinishLatentTask(OwnerComp, EBTNodeResult::Failed);
+	}
+	else if (!Controller->IsFollowingRoomRoute())
+	{
+		FinishLatentTask(OwnerComp, Controller->DidRoomRouteSucceed() ? EBTNodeResult::Succeeded : EBTNodeResult::Failed);
+	}
+}
+
+FString UBTTask_MoveToViaRooms::GetStaticDescription() const
+{
+	return FString::Printf(TEXT("Move to %s through the dungeon's doorways."), *BlackboardKey.SelectedKeyName.ToString());
+}
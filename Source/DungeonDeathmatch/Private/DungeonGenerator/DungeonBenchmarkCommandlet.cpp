@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonBenchmarkCommandlet.h"
+#include "DungeonLayoutBuilder.h"
+
+#include <Async/Async.h>
+#include <HAL/PlatformMemory.h>
+#include <HAL/PlatformProcess.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+
+#define BYTES_PER_MEGABYTE (1024.0 * 1024.0)
+
+/** Seconds between memory samples while a run builds */
+#define MEMORY_SAMPLE_INTERVAL 0.001f
+
+UDungeonBenchmarkCommandlet::UDungeonBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 UDungeonBenchmarkCommandlet::Main(const FString& Params)
+{
+	TArray<int32> RoomCounts = ParseIntList(Params, TEXT("Rooms="), { 10, 50, 200 });
+	TArray<int32> RoomGridSizes = ParseIntList(Params, TEXT("RoomGridSizes="), { 50, 100 });
+	TArray<int32> TileCounts = ParseIntList(Params, TEXT("Tiles="), { 100, 10000, 100000 });
+
+	int32 NumSeeds = 5;
+	FParse::Value(*Params, TEXT("Seeds="), NumSeeds);
+	NumSeeds = FMath::Max(NumSeeds, 1);
+
+	int32 FirstSeed = 0;
+	FParse::Value(*Params, TEXT("FirstSeed="), FirstSeed);
+
+	// Benchmark the random rejection placement strategy instead of the default Poisson-disc one
+	const bool bRandomPlacement = FParse::Param(*Params, TEXT("RandomPlacement"));
+
+	FString OutputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"), TEXT("DungeonBenchmark.csv"));
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	FString Csv = TEXT("Seed,NumberOfRooms,RoomGridSize,NumberOfTiles,TileGridSize,PlacementStrategy,RoomsMs,ConnectionsMs,SpawnsMs,CorridorsMs,TilesMs,TotalMs,PlacementAttempts,PlacementSeeds,FailedPlacements,RoomsPlaced,Connections,CorridorTiles,ReroutedCorridors,FailedCorridors,TilesGenerated,MemoryDeltaMB,RunPeakMemoryMB\n");
+
+	const FDungeonGenerationParams DefaultParams;
+	int32 NumRuns = 0;
+	for (int32 NumberOfRooms : RoomCounts)
+	{
+		for (int32 RoomGridSize : RoomGridSizes)
+		{
+			for (int32 NumberOfTiles : TileCounts)
+			{
+				// Give the tile layout four cells per tile so growth isn't limited by the grid
+				int32 TileGridSize = FMath::CeilToInt(FMath::Sqrt(NumberOfTiles * 4.0f));
+
+				for (int32 SeedIndex = 0; SeedIndex < NumSeeds; SeedIndex++)
+				{
+					FDungeonGenerationParams RunParams = DefaultParams;
+					RunParams.Seed = FirstSeed + SeedIndex;
+					RunParams.NumberOfRooms = NumberOfRooms;
+					RunParams.RoomDungeonGridSize = FIntVector(RoomGridSize, RoomGridSize, DefaultParams.RoomDungeonGridSize.Z);
+					RunParams.NumberOfTiles = NumberOfTiles;
+					RunParams.DungeonGridSize = FIntVector(TileGridSize, TileGridSize, 1);
+					RunParams.RoomPlacementStrategy = bRandomPlacement ? ERoomPlacementStrategy::RandomRejection : ERoomPlacementStrategy::PoissonDisc;
+
+					uint64 UsedMemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+					// The process peak only ever grows over the sweep, so the run's peak is sampled while the builder works on a
+					// worker thread
+					FDungeonLayoutBuilder Builder(RunParams);
+					TFuture<void> BuildResult = Async<void>(EAsyncExecution::Thread, [&Builder]() { Builder.Build(); });
+					uint64 RunPeakMemory = UsedMemoryBefore;
+					while (!BuildResult.IsReady())
+					{
+						RunPeakMemory = FMath::Max(RunPeakMemory, FPlatformMemory::GetStats().UsedPhysical);
+						FPlatformProcess::Sleep(MEMORY_SAMPLE_INTERVAL);
+					}
+					BuildResult.Wait();
+
+					uint64 UsedMemoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+					RunPeakMemory = FMath::Max(RunPeakMemory, UsedMemoryAfter);
+					double MemoryDelta = ((double)UsedMemoryAfter - (double)UsedMemoryBefore) / BYTES_PER_MEGABYTE;
+
+					const FDungeonGenerationStats& Stats = Builder.GetStats();
+					const FDungeonLayout& Layout = Builder.GetLayout();
+					double TotalTime = Stats.RoomsTime + Stats.ConnectionsTime + Stats.SpawnsTime + Stats.CorridorsTime + Stats.TilesTime;
+
+					Csv += FString::Printf(TEXT("%d,%d,%d,%d,%d,%s,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d,%d,%d,%d,%d,%d,%d,%d,%.2f,%.2f\n"),
+						RunParams.Seed, NumberOfRooms, RoomGridSize, NumberOfTiles, TileGridSize, bRandomPlacement ? TEXT("RandomRejection") : TEXT("PoissonDisc"),
+						Stats.RoomsTime * 1000.0, Stats.ConnectionsTime * 1000.0, Stats.SpawnsTime * 1000.0, Stats.CorridorsTime * 1000.0, Stats.TilesTime * 1000.0, TotalTime * 1000.0,
+						Stats.PlacementAttempts, Stats.PlacementSeeds, Stats.FailedPlacements, Layout.Rooms.Num(), Layout.Connections.Num(), Layout.Corridors.Num(), Stats.ReroutedCorridors, Stats.FailedCorridors, Layout.Tiles.Num(),
+						MemoryDelta, RunPeakMemory / BYTES_PER_MEGABYTE);
+					NumRuns++;
+				}
+			}
+		}
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *OutputPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UDungeonBenchmarkCommandlet::Main - Failed to write benchmark results to %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("UDungeonBenchmarkCommandlet::Main - Wrote %d benchmark runs to %s"), NumRuns, *OutputPath);
+	return 0;
+}
+
+TArray<int32> UDungeonBenchmarkCommandlet::ParseIntList(const FString& Params, const TCHAR* Switch, const TArray<int32>& Defaults)
+{
+	FString ListString;
+	// Don't stop at the first comma, the whole list is the value
+	if (!FParse::Value(*Params, Switch, ListString, false))
+	{
+		return Defaults;
+	}
+
+	TArray<FString> Entries;
+	ListString.ParseIntoArray(Entries, TEXT(","), true);
+
+	TArray<int32> Values;
+	for (const FString& Entry : Entries)
+	{
+		Values.Add(FMath::Max(FCString::Atoi(*Entry), 1));
+	}
+	return Values.Num() > 0 ? Values : Defaults;
+}
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonBrickOccupancy.h"
+
+FDungeonBrickOccupancy::FDungeonBrickOccupancy()
+{
+	Reset();
+}
+
+void FDungeonBrickOccupancy::Reset()
+{
+	Bricks.Empty();
+	BoundsMin = FIntVector(MAX_int32, MAX_int32, MAX_int32);
+	BoundsMax = FIntVector(MIN_int32, MIN_int32, MIN_int32);
+}
+
+bool FDungeonBrickOccupancy::IsCellOccupied(const FIntVector& Cell) const
+{
+	const FBrick* Brick = Bricks.Find(GetBrickKey(GetBrickCoordinate(Cell)));
+	if (!Brick)
+	{
+		return false;
+	}
+	const int32 X = Cell.X & (OCCUPANCY_BRICK_SIZE - 1);
+	const int32 Y = Cell.Y & (OCCUPANCY_BRICK_SIZE - 1);
+	const int32 Z = Cell.Z & (OCCUPANCY_BRICK_SIZE - 1);
+	return (Brick->Slices[Z] >> (Y * 8 + X)) & 1;
+}
+
+bool FDungeonBrickOccupancy::IsBoxOccupied(const FIntVector& Min, const FIntVector& Max) const
+{
+	// Nothing outside of the occupied bounds can be occupied, so clamping to them skips probing empty space around the box
+	const FIntVector ClampedMin = FIntVector(FMath::Max(Min.X, BoundsMin.X), FMath::Max(Min.Y, BoundsMin.Y), FMath::Max(Min.Z, BoundsMin.Z));
+	const FIntVector ClampedMax = FIntVector(FMath::Min(Max.X, BoundsMax.X), FMath::Min(Max.Y, BoundsMax.Y), FMath::Min(Max.Z, BoundsMax.Z));
+	if (ClampedMin.X >= ClampedMax.X || ClampedMin.Y >= ClampedMax.Y || ClampedMin.Z >= ClampedMax.Z)
+	{
+		return false;
+	}
+
+	const FIntVector BrickMin = GetBrickCoordinate(ClampedMin);
+	const FIntVector BrickMax = GetBrickCoordinate(ClampedMax - FIntVector(1, 1, 1));
+	for (int32 BrickZ = BrickMin.Z; BrickZ <= BrickMax.Z; BrickZ++)
+	{
+		for (int32 BrickY = BrickMin.Y; BrickY <= BrickMax.Y; BrickY++)
+		{
+			for (int32 BrickX = BrickMin.X; BrickX <= BrickMax.X; BrickX++)
+			{
+				const FIntVector BrickCoordinate = FIntVector(BrickX, BrickY, BrickZ);
+				const FBrick* Brick = Bricks.Find(GetBrickKey(BrickCoordinate));
+				if (!Brick)
+				{
+					continue;
+				}
+
+				FIntVector LocalMin;
+				FIntVector LocalMax;
+				GetBrickLocalBox(BrickCoordinate, ClampedMin, ClampedMax, LocalMin, LocalMax);
+				const uint64 Mask = GetSliceMask(LocalMin.X, LocalMax.X, LocalMin.Y, LocalMax.Y);
+				for (int32 Z = LocalMin.Z; Z < LocalMax.Z; Z++)
+				{
+					if (Brick->Slices[Z] & Mask)
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void FDungeonBrickOccupancy::FillBox(const FIntVector& Min, const FIntVector& Max)
+{
+	if (Min.X >= Max.X || Min.Y >= Max.Y || Min.Z >= Max.Z)
+	{
+		return;
+	}
+
+	const FIntVector BrickMin = GetBrickCoordinate(Min);
+	const FIntVector BrickMax = GetBrickCoordinate(Max - FIntVector(1, 1, 1));
+	for (int32 BrickZ = BrickMin.Z; BrickZ <= BrickMax.Z; BrickZ++)
+	{
+		for (int32 BrickY = BrickMin.Y; BrickY <= BrickMax.Y; BrickY++)
+		{
+			for (int32 BrickX = BrickMin.X; BrickX <= BrickMax.X; BrickX++)
+			{
+				const FIntVector BrickCoordinate = FIntVector(BrickX, BrickY, BrickZ);
+				FBrick& Brick = Bricks.FindOrAdd(GetBrickKey(BrickCoordinate));
+
+				FIntVector LocalMin;
+				FIntVector LocalMax;
+				GetBrickLocalBox(BrickCoordinate, Min, Max, LocalMin, LocalMax);
+				const uint64 Mask = GetSliceMask(LocalMin.X, LocalMax.X, LocalMin.Y, LocalMax.Y);
+				for (int32 Z = LocalMin.Z; Z < LocalMax.Z; Z++)
+				{
+					Brick.Slices[Z] |= Mask;
+				}
+			}
+		}
+	}
+
+	BoundsMin = FIntVector(FMath::Min(BoundsMin.X, Min.X), FMath::Min(BoundsMin.Y, Min.Y), FMath::Min(BoundsMin.Z, Min.Z));
+	BoundsMax = FIntVector(FMath::Max(BoundsMax.X, Max.X), FMath::Max(BoundsMax.Y, Max.Y), FMath::Max(BoundsMax.Z, Max.Z));
+}
+
+bool FDungeonBrickOccupancy::GetOccupiedBounds(FIntVector& OutMin, FIntVector& OutMax) const
+{
+	OutMin = BoundsMin;
+	OutMax = BoundsMax;
+	return Bricks.Num() > 0;
+}
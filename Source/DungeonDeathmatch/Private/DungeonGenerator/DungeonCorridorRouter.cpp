@@ -0,0 +1,282 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonCorridorRouter.h"
+
+#include <Algo/Reverse.h>
+#include <Async/ParallelFor.h>
+
+namespace
+{
+	/** Orders open set entries by estimated total cost, tie breaking on the cell so the search order is deterministic */
+	struct FOpenSetPredicate
+	{
+		bool operator()(const TPair<float, int32>& A, const TPair<float, int32>& B) const
+		{
+			return A.Key != B.Key ? A.Key < B.Key : A.Value < B.Value;
+		}
+	};
+
+	const FIntVector NeighborOffsets[6] =
+	{
+		FIntVector(1, 0, 0),
+		FIntVector(-1, 0, 0),
+		FIntVector(0, 1, 0),
+		FIntVector(0, -1, 0),
+		FIntVector(0, 0, 1),
+		FIntVector(0, 0, -1)
+	};
+}
+
+FDungeonCorridorRouter::FDungeonCorridorRouter()
+{
+	Origin = FIntVector(0, 0, 0);
+	Dimensions = FIntVector(0, 0, 0);
+	ReuseCost = 0.5f;
+	VerticalCost = 4.0f;
+	NumRerouted = 0;
+	NumFailed = 0;
+}
+
+void FDungeonCorridorRouter::Init(const FIntVector& InOrigin, const FIntVector& InDimensions, const FDungeonRoomSet& Rooms, float InReuseCost, float InVerticalCost)
+{
+	Origin = InOrigin;
+	Dimensions = FIntVector(FMath::Max(InDimensions.X, 1), FMath::Max(InDimensions.Y, 1), FMath::Max(InDimensions.Z, 1));
+	ReuseCost = FMath::Clamp(InReuseCost, 0.01f, 1.0f);
+	VerticalCost = FMath::Max(InVerticalCost, 1.0f);
+	NumRerouted = 0;
+	NumFailed = 0;
+
+	const int32 NumCells = Dimensions.X * Dimensions.Y * Dimensions.Z;
+	CellRooms.Init(INDEX_NONE, NumCells);
+	CorridorCells.SetNumZeroed(NumCells);
+	RoomAnchorCells.SetNum(Rooms.Num());
+
+	for (int32 RoomIndex = 0; RoomIndex < Rooms.Num(); RoomIndex++)
+	{
+		const FIntVector& RoomSize = Rooms.Sizes[RoomIndex];
+		FIntVector LocalMin = Rooms.Locations[RoomIndex] - Origin;
+		FIntVector LocalMax = LocalMin + RoomSize;
+		for (int32 Z = FMath::Max(LocalMin.Z, 0); Z < FMath::Min(LocalMax.Z, Dimensions.Z); Z++)
+		{
+			for (int32 Y = FMath::Max(LocalMin.Y, 0); Y < FMath::Min(LocalMax.Y, Dimensions.Y); Y++)
+			{
+				for (int32 X = FMath::Max(LocalMin.X, 0); X < FMath::Min(LocalMax.X, Dimensions.X); X++)
+				{
+					CellRooms[GetCellIndex(X, Y, Z)] = RoomIndex;
+				}
+			}
+		}
+
+		FIntVector Anchor = LocalMin + FIntVector(RoomSize.X / 2, RoomSize.Y / 2, 0);
+		RoomAnchorCells[RoomIndex] = GetCellIndex(FMath::Clamp(Anchor.X, 0, Dimensions.X - 1), FMath::Clamp(Anchor.Y, 0, Dimensions.Y - 1), FMath::Clamp(Anchor.Z, 0, Dimensions.Z - 1));
+	}
+}
+
+void FDungeonCorridorRouter::RouteConnections(const TArray<FDungeonGraphEdge>& Connections, int32 WaveSize, TArray<TArray<FIntVector>>& OutPaths)
+{
+	WaveSize = FMath::Max(WaveSize, 1);
+	const int32 NumCells = CellRooms.Num();
+
+	TArray<FSearchScratch> Scratches;
+	Scratches.SetNum(FMath::Min(WaveSize, Connections.Num()));
+	for (FSearchScratch& Scratch : Scratches)
+	{
+		Scratch.Costs.SetNumUninitialized(NumCells);
+		Scratch.Parents.SetNumUninitialized(NumCells);
+		Scratch.VisitedStamps.SetNumZeroed(NumCells);
+	}
+
+	TArray<TArray<int32>> WavePaths;
+	WavePaths.SetNum(Scratches.Num());
+	TArray<uint32> WaveCells;
+	WaveCells.SetNumZeroed(NumCells);
+
+	OutPaths.Empty(Connections.Num());
+	uint32 WaveStamp = 0;
+	for (int32 WaveStart = 0; WaveStart < Connections.Num(); WaveStart += WaveSize)
+	{
+		const int32 WaveCount = FMath::Min(WaveSize, Connections.Num() - WaveStart);
+		WaveStamp++;
+
+		// Corridors are only read while the wave is searched, so every path of the wave sees the same state
+		ParallelFor(WaveCount, [this, &Connections, &Scratches, &WavePaths, WaveStart](int32 PathIndex)
+		{
+			const FDungeonGraphEdge& Connection = Connections[WaveStart + PathIndex];
+			WavePaths[PathIndex].Reset();
+			FindPath(Connection.A, Connection.B, Scratches[PathIndex], WavePaths[PathIndex]);
+		});
+
+		for (int32 PathIndex = 0; PathIndex < WaveCount; PathIndex++)
+		{
+			TArray<int32>& Path = WavePaths[PathIndex];
+			if (PathIndex > 0 && ConflictsWithWave(Path, WaveStamp, WaveCells))
+			{
+				const FDungeonGraphEdge& Connection = Connections[WaveStart + PathIndex];
+				Path.Reset();
+				FindPath(Connection.A, Connection.B, Scratches[0], Path);
+				NumRerouted++;
+			}
+
+			if (Path.Num() == 0)
+			{
+				NumFailed++;
+			}
+			MergePath(Path, WaveStamp, WaveCells);
+
+			TArray<FIntVector>& OutPath = OutPaths[OutPaths.AddDefaulted()];
+			OutPath.Reserve(Path.Num());
+			for (int32 Cell : Path)
+			{
+				OutPath.Add(GetCellLocal(Cell) + Origin);
+			}
+		}
+	}
+}
+
+int32 FDungeonCorridorRouter::GetRoomAt(const FIntVector& Cell) const
+{
+	FIntVector Local = Cell - Origin;
+	if (Local.X < 0 || Local.Y < 0 || Local.Z < 0 || Local.X >= Dimensions.X || Local.Y >= Dimensions.Y || Local.Z >= Dimensions.Z)
+	{
+		return INDEX_NONE;
+	}
+	return CellRooms[GetCellIndex(Local.X, Local.Y, Local.Z)];
+}
+
+bool FDungeonCorridorRouter::FindPath(int32 RoomA, int32 RoomB, FSearchScratch& Scratch, TArray<int32>& OutPath) const
+{
+	if (!RoomAnchorCells.IsValidIndex(RoomA) || !RoomAnchorCells.IsValidIndex(RoomB))
+	{
+		return false;
+	}
+
+	if (++Scratch.Stamp == 0)
+	{
+		FMemory::Memzero(Scratch.VisitedStamps.GetData(), Scratch.VisitedStamps.Num() * sizeof(uint32));
+		Scratch.Stamp = 1;
+	}
+	const uint32 Stamp = Scratch.Stamp;
+
+	const int32 StartCell = RoomAnchorCells[RoomA];
+	const int32 GoalCell = RoomAnchorCells[RoomB];
+	FOpenSetPredicate Predicate;
+
+	Scratch.OpenSet.Reset();
+	Scratch.Costs[StartCell] = 0.0f;
+	Scratch.Parents[StartCell] = INDEX_NONE;
+	Scratch.VisitedStamps[StartCell] = Stamp;
+	Scratch.OpenSet.HeapPush(TPair<float, int32>(GetHeuristic(StartCell, GoalCell), StartCell), Predicate);
+
+	while (Scratch.OpenSet.Num() > 0)
+	{
+		TPair<float, int32> Current;
+		Scratch.OpenSet.HeapPop(Current, Predicate, false);
+		const int32 Cell = Current.Value;
+		const float Cost = Scratch.Costs[Cell];
+
+		// Skip entries that were superseded by a cheaper route to the same cell
+		if (Current.Key > Cost + GetHeuristic(Cell, GoalCell))
+		{
+			continue;
+		}
+
+		if (Cell == GoalCell)
+		{
+			for (int32 PathCell = GoalCell; PathCell != INDEX_NONE; PathCell = Scratch.Parents[PathCell])
+			{
+				OutPath.Add(PathCell);
+			}
+			Algo::Reverse(OutPath);
+			return true;
+		}
+
+		const FIntVector Local = GetCellLocal(Cell);
+		for (int32 NeighborIndex = 0; NeighborIndex < 6; NeighborIndex++)
+		{
+			const FIntVector Neighbor = Local + NeighborOffsets[NeighborIndex];
+			if (Neighbor.X < 0 || Neighbor.Y < 0 || Neighbor.Z < 0 || Neighbor.X >= Dimensions.X || Neighbor.Y >= Dimensions.Y || Neighbor.Z >= Dimensions.Z)
+			{
+				continue;
+			}
+
+			const int32 NeighborCell = GetCellIndex(Neighbor.X, Neighbor.Y, Neighbor.Z);
+			const int32 NeighborRoom = CellRooms[NeighborCell];
+			if (NeighborRoom != INDEX_NONE && NeighborRoom != RoomA && NeighborRoom != RoomB)
+			{
+				continue;
+			}
+
+			// Corridors only enter and leave rooms through their walls, doorways and portals are never in a floor or ceiling
+			if (NeighborIndex >= 4 && NeighborRoom != CellRooms[Cell])
+			{
+				continue;
+			}
+
+			float StepCost = NeighborIndex >= 4 ? VerticalCost : 1.0f;
+			if (CorridorCells[NeighborCell])
+			{
+				StepCost *= ReuseCost;
+			}
+
+			const float NeighborCost = Cost + StepCost;
+			if (Scratch.VisitedStamps[NeighborCell] != Stamp || NeighborCost < Scratch.Costs[NeighborCell])
+			{
+				Scratch.VisitedStamps[NeighborCell] = Stamp;
+				Scratch.Costs[NeighborCell] = NeighborCost;
+				Scratch.Parents[NeighborCell] = Cell;
+				Scratch.OpenSet.HeapPush(TPair<float, int32>(NeighborCost + GetHeuristic(NeighborCell, GoalCell), NeighborCell), Predicate);
+			}
+		}
+	}
+
+	return false;
+}
+
+void FDungeonCorridorRouter::MergePath(const TArray<int32>& Path, uint32 WaveStamp, TArray<uint32>& WaveCells)
+{
+	for (int32 Cell : Path)
+	{
+		if (CellRooms[Cell] == INDEX_NONE)
+		{
+			CorridorCells[Cell] = 1;
+			WaveCells[Cell] = WaveStamp;
+		}
+	}
+}
+
+bool FDungeonCorridorRouter::ConflictsWithWave(const TArray<int32>& Path, uint32 WaveStamp, const TArray<uint32>& WaveCells) const
+{
+	for (int32 Cell : Path)
+	{
+		if (CellRooms[Cell] != INDEX_NONE)
+		{
+			continue;
+		}
+
+		const FIntVector Local = GetCellLocal(Cell);
+		for (int32 NeighborIndex = 0; NeighborIndex < 4; NeighborIndex++)
+		{
+			const FIntVector Neighbor = Local + NeighborOffsets[NeighborIndex];
+			if (Neighbor.X < 0 || Neighbor.Y < 0 || Neighbor.X >= Dimensions.X || Neighbor.Y >= Dimensions.Y)
+			{
+				continue;
+			}
+			if (WaveCells[GetCellIndex(Neighbor.X, Neighbor.Y, Neighbor.Z)] == WaveStamp)
+			{
+				return true;
+			}
+		}
+		if (WaveCells[Cell] == WaveStamp)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+float FDungeonCorridorRouter::GetHeuristic(int32 Cell, int32 GoalCell) const
+{
+	// Scaled by the reuse discount so the estimate never exceeds the real cost, which keeps routes optimal
+	const FIntVector Delta = GetCellLocal(GoalCell) - GetCellLocal(Cell);
+	return (FMath::Abs(Delta.X) + FMath::Abs(Delta.Y) + FMath::Abs(Delta.Z) * VerticalCost) * ReuseCost;
+}
@@ -1,10 +1,22 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "DungeonGenerator.h"
+#include "Chest.h"
 #include "DungeonGenerator/DungeonTile.h"
-
+#include "DungeonLayoutBuilder.h"
+#include "DungeonNavigationComponent.h"
+#include "DungeonPortalCullingComponent.h"
+#include "DungeonRoomRouteComponent.h"
+
+#include <Async/Async.h>
+#include <Components/CapsuleComponent.h>
+#include <Components/HierarchicalInstancedStaticMeshComponent.h>
 #include <DrawDebugHelpers.h>
+#include <EngineUtils.h>
+#include <GameFramework/PlayerStart.h>
 #include <Kismet/GameplayStatics.h>
+#include <Misc/Parse.h>
+#include <Net/UnrealNetwork.h>
 
 // Sets default values
 ADungeonGenerator::ADungeonGenerator()
@@ -12,6 +24,20 @@ ADungeonGenerator::ADungeonGenerator()
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	// Only the seed and params are replicated, every client builds and spawns the dungeon itself
+	bReplicates = true;
+	bAlwaysRelevant = true;
+
+	PortalCullingComponent = CreateDefaultSubobject<UDungeonPortalCullingComponent>(TEXT("PortalCullingComponent"));
+	RoomRouteComponent = CreateDefaultSubobject<UDungeonRoomRouteComponent>(TEXT("RoomRouteComponent"));
+	NavigationComponent = CreateDefaultSubobject<UDungeonNavigationComponent>(TEXT("NavigationComponent"));
+
+	Seed = 0;
+	bRandomizeSeed = true;
+	bGenerateOnBeginPlay = false;
+	bUseLayoutCache = true;
+	GenerationRequestId = 0;
+
 	RoomDungeonGridSize = FIntVector(50, 50, 10);
 	NumberOfRooms = 50;
 	DungeonTileSize = FVector(500.0f, 500.0f, 500.0f);
@@ -19,16 +45,47 @@ ADungeonGenerator::ADungeonGenerator()
 	RoomSizeMax = FIntVector(10, 10, 4);
 	MinRoomDistance = 5;
 	MainRoomSizeFactor = 1.2f;
+	RoomPlacementStrategy = ERoomPlacementStrategy::PoissonDisc;
 	MaxPlacementAttempts = 1000;
 
 	bAddExtraConnections = true;
 	AdditionalConnectionsRatio = 0.25f;
+	MaxRoomConnections = 4;
+	MaxLoopLength = 8;
+	bCarveCorridors = true;
+	CorridorReuseCost = 0.5f;
+	CorridorVerticalCost = 4.0f;
+	MaxStairsHeight = 1;
+	NumPlayerStarts = 8;
+	NumChests = 16;
+	MinChestDistance = 1;
+	NumAISpawns = 8;
+	PlayerStartClass = APlayerStart::StaticClass();
+
+	bUseInstancedTileMeshes = true;
+	bPoolTileActors = true;
+	TilePoolSlack = 0.25f;
+	bTimeSliceTileSpawning = true;
+	TileSpawnBudgetMs = 4.0f;
+	NextPendingTileSpawn = 0;
 }
 
 // Called when the game starts or when spawned
 void ADungeonGenerator::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if (bGenerateOnBeginPlay && HasAuthority())
+	{
+		GenerateDungeonAsync();
+	}
+}
+
+void ADungeonGenerator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ADungeonGenerator, ReplicatedLayout);
 }
 
 // Called every frame
@@ -36,208 +93,334 @@ void ADungeonGenerator::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	if (IsSpawningTiles())
+	{
+		bool bIsDone = SpawnPendingTiles();
+		OnDungeonSpawnProgress.Broadcast(this, GetTileSpawnProgress());
+		if (bIsDone)
+		{
+			PendingTileSpawns.Empty();
+			NextPendingTileSpawn = 0;
+			NavigationComponent->ReleaseAllRegions();
+			OnDungeonSpawned.Broadcast(this);
+		}
+	}
 }
 
 void ADungeonGenerator::GenerateDungeon()
 {
 	UE_LOG(LogTemp, Warning, TEXT("Generating Dungeon!"));
 	DestroyDungeon();
-	GenerateTileLayout();
-	SpawnTileLayout();
+	UpdateSeed();
+
+	FDungeonGenerationParams Params = GetGenerationParams();
+	Params.bGenerateRooms = false;
+
+	FDungeonLayoutBuilder Builder(Params);
+	BuildLayout(Builder);
+	ReplicateLayout(Params, (int32)Builder.GetLayout().GetChecksum());
+	ApplyLayout(Builder.ConsumeLayout());
+
+	BeginTileSpawning();
 }
 
 void ADungeonGenerator::GenerateRoomBasedDungeon()
 {
-	FDateTime GenerationStartTime = FDateTime::Now();
 	UE_LOG(LogTemp, Warning, TEXT("Generating Dungeon!"));
+	DestroyDungeon();
+	UpdateSeed();
 
-	GenerateRooms();
-	BuildConnections();
+	FDungeonGenerationParams Params = GetGenerationParams();
+	Params.bGenerateTiles = false;
 
-	FDateTime GenerationEndTime = FDateTime::Now();
-	UE_LOG(LogTemp, Warning, TEXT("Generated %d rooms with %d connections in %f seconds"), Rooms.Num(), Connections.Num(), (GenerationEndTime - GenerationStartTime).GetTotalSeconds());
+	FDungeonLayoutBuilder Builder(Params);
+	BuildLayout(Builder);
+
+	const FDungeonGenerationStats& Stats = Builder.GetStats();
+	ReplicateLayout(Params, (int32)Builder.GetLayout().GetChecksum());
+	ApplyLayout(Builder.ConsumeLayout());
+	UE_LOG(LogTemp, Warning, TEXT("Generated %d rooms with %d connections, %d placements, %d corridor tiles and %d vertical connectors in %f seconds (rooms: %f seconds, connections: %f seconds, placements: %f seconds, corridors: %f seconds)"), Rooms.Num(), Connections.Num(), Placements.Num(), Corridors.Num(), VerticalConnectors.Num(), Stats.RoomsTime + Stats.ConnectionsTime + Stats.SpawnsTime + Stats.CorridorsTime, Stats.RoomsTime, Stats.ConnectionsTime, Stats.SpawnsTime, Stats.CorridorsTime);
 
 	DrawDebugDungeon();
+	BeginTileSpawning();
+}
+
+void ADungeonGenerator::GenerateDungeonAsync()
+{
+	UE_LOG(LogTemp, Warning, TEXT("Generating Dungeon asynchronously!"));
+	DestroyDungeon();
+	UpdateSeed();
+
+	StartAsyncGeneration(GetGenerationParams(), false, 0);
 }
 
-void ADungeonGenerator::GenerateRooms()
+void ADungeonGenerator::OnRep_ReplicatedLayout()
 {
-	Rooms.Empty();
-	RoomDungeonGrid.Empty();
-	RoomSizeTotal = FIntVector(0, 0, 0);
-	if (RoomSizeMax.Size() > DungeonGridSize.Size())
+	if (HasAuthority())
 	{
-		UE_LOG(LogTemp, Warning, TEXT("ADungeonGenerator::GenerateRoomBasedDungeon - Max room size exceeds dungeon grid size, aborting"));
 		return;
 	}
-	for (int RoomIndex = 0; RoomIndex < NumberOfRooms; RoomIndex++)
-	{
-		GenerateRoom();
-	}
-	RoomSizeAverage = RoomSizeTotal / NumberOfRooms;
+
+	UE_LOG(LogTemp, Log, TEXT("ADungeonGenerator::OnRep_ReplicatedLayout - Rebuilding dungeon %d from seed %d"), ReplicatedLayout.GenerationIndex, ReplicatedLayout.Params.Seed);
+	DestroyDungeon();
+	Seed = ReplicatedLayout.Params.Seed;
+
+	StartAsyncGeneration(ReplicatedLayout.Params, true, ReplicatedLayout.Checksum);
 }
 
-void ADungeonGenerator::GenerateRoom()
+void ADungeonGenerator::StartAsyncGeneration(const FDungeonGenerationParams& Params, bool bVerifyChecksum, int32 ExpectedChecksum, bool bAllowCache)
 {
-	FIntVector RoomSize = FIntVector(FMath::RandRange(RoomSizeMin.X, RoomSizeMax.X), FMath::RandRange(RoomSizeMin.Y, RoomSizeMax.Y), FMath::RandRange(RoomSizeMin.Z, RoomSizeMax.Z));
-	RoomSizeTotal += RoomSize;
-	FIntVector RoomLocation;
-	bool LocationValid = false;
-	int PlacementAttempts = 0;
-	while (!LocationValid && PlacementAttempts < MaxPlacementAttempts)
-	{
-		LocationValid = true;
-		FVector MaxRoomPoint = FVector(RoomDungeonGridSize.X - RoomSize.X, RoomDungeonGridSize.Y - RoomSize.Y, RoomDungeonGridSize.Z - RoomSize.Z);
-		FVector RandomDungeonLocation = FMath::RandPointInBox(FBox(-MaxRoomPoint, MaxRoomPoint));
-		RoomLocation = FIntVector(RandomDungeonLocation.X, RandomDungeonLocation.Y, RandomDungeonLocation.Z);
+	TSharedPtr<FDungeonLayoutBuilder, ESPMode::ThreadSafe> Builder = MakeShareable(new FDungeonLayoutBuilder(Params));
+	ActiveBuilder = Builder;
 
-		int RoomXMin = RoomLocation.X - MinRoomDistance;
-		int RoomXMax = RoomLocation.X + RoomSize.X + MinRoomDistance;
+	const int32 RequestId = GenerationRequestId;
+	const bool bUseCache = bAllowCache && ShouldUseLayoutCache();
+	TWeakObjectPtr<ADungeonGenerator> WeakThis(this);
 
-		int RoomYMin = RoomLocation.Y - MinRoomDistance;
-		int RoomYMax = RoomLocation.Y + RoomSize.Y + MinRoomDistance;
-
-		int RoomZMin = RoomLocation.Z - MinRoomDistance;
-		int RoomZMax = RoomLocation.Z + RoomSize.Z + MinRoomDistance;
+	// Only the pure data stages run on the worker, spawning is marshalled back to the game thread
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Builder, WeakThis, RequestId, bUseCache, bVerifyChecksum, ExpectedChecksum]()
+	{
+		double GenerationStartTime = FPlatformTime::Seconds();
+		if (bUseCache)
+		{
+			Builder->BuildCached();
+		}
+		else
+		{
+			Builder->Build();
+		}
+		double GenerationTime = FPlatformTime::Seconds() - GenerationStartTime;
 
-		for (int RoomX = RoomXMin; RoomX < RoomXMax; RoomX++)
+		AsyncTask(ENamedThreads::GameThread, [Builder, WeakThis, RequestId, GenerationTime, bVerifyChecksum, ExpectedChecksum]()
 		{
-			if (!LocationValid) break;
-			for (int RoomY = RoomYMin; RoomY < RoomYMax; RoomY++)
+			ADungeonGenerator* Generator = WeakThis.Get();
+			if (Generator && Generator->GenerationRequestId == RequestId)
 			{
-				if (!LocationValid) break;
-				for (int RoomZ = RoomZMin; RoomZ < RoomZMax; RoomZ++)
-				{
-					FIntVector RoomGridCell = FIntVector(RoomX, RoomY, RoomZ);
-					if (RoomDungeonGrid.Find(RoomGridCell))
-					{
-						LocationValid = false;
-						break;
-					}
-				}
+				Generator->OnAsyncGenerationComplete(*Builder, GenerationTime, bVerifyChecksum, ExpectedChecksum);
 			}
-		}
-		PlacementAttempts++;
-		if (PlacementAttempts >= MaxPlacementAttempts)
+		});
+	});
+}
+
+void ADungeonGenerator::OnAsyncGenerationComplete(FDungeonLayoutBuilder& Builder, double GenerationTime, bool bVerifyChecksum, int32 ExpectedChecksum)
+{
+	ActiveBuilder.Reset();
+
+	int32 Checksum = (int32)Builder.GetLayout().GetChecksum();
+	if (bVerifyChecksum && Checksum != ExpectedChecksum)
+	{
+		// A cached layout may have been written by a build with different generation code, so try once more without the cache
+		if (Builder.GetStats().bLoadedFromCache)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("ADungeonGenerator::GenerateRoom - Exceeded max room placement attempts, room placement is invalid"));
+			UE_LOG(LogTemp, Warning, TEXT("ADungeonGenerator::OnAsyncGenerationComplete - Cached layout checksum %d does not match the server's checksum %d for seed %d, rebuilding it"), Checksum, ExpectedChecksum, Builder.GetParams().Seed);
+			StartAsyncGeneration(Builder.GetParams(), true, ExpectedChecksum, false);
+			return;
 		}
+
+		// Spawning a layout that differs from the server's would leave this client walking through walls, so refuse it
+		UE_LOG(LogTemp, Error, TEXT("ADungeonGenerator::OnAsyncGenerationComplete - Layout checksum %d does not match the server's checksum %d for seed %d"), Checksum, ExpectedChecksum, Builder.GetParams().Seed);
+		return;
 	}
 
-	FDungeonRoom Room = FDungeonRoom(RoomLocation, RoomSize);
-	Rooms.Add(Room);
+	ReplicateLayout(Builder.GetParams(), Checksum);
+	ApplyLayout(Builder.ConsumeLayout());
+	UE_LOG(LogTemp, Warning, TEXT("Generated %d rooms with %d connections, %d corridor tiles and %d tiles in %f seconds on a worker thread%s"), Rooms.Num(), Connections.Num(), Corridors.Num(), Tiles.Num(), GenerationTime, Builder.GetStats().bLoadedFromCache ? TEXT(" (from the layout cache)") : TEXT(""));
 
-	int RoomXMin = RoomLocation.X;
-	int RoomXMax = RoomLocation.X + RoomSize.X;
+	DrawDebugDungeon();
+	OnDungeonGenerated.Broadcast(this);
 
-	int RoomYMin = RoomLocation.Y;
-	int RoomYMax = RoomLocation.Y + RoomSize.Y;
+	BeginTileSpawning();
+}
 
-	int RoomZMin = RoomLocation.Z;
-	int RoomZMax = RoomLocation.Z + RoomSize.Z;
+void ADungeonGenerator::BuildLayout(FDungeonLayoutBuilder& Builder)
+{
+	if (ShouldUseLayoutCache())
+	{
+		Builder.BuildCached();
+	}
+	else
+	{
+		Builder.Build();
+	}
 
-	for (int RoomX = RoomXMin; RoomX < RoomXMax; RoomX++)
+	if (Builder.GetStats().bLoadedFromCache)
 	{
-		for (int RoomY = RoomYMin; RoomY < RoomYMax; RoomY++)
-		{
-			for (int RoomZ = RoomZMin; RoomZ < RoomZMax; RoomZ++)
-			{
-				FIntVector RoomGridCell = FIntVector(RoomX, RoomY, RoomZ);
-				RoomDungeonGrid.Add(TTuple<FIntVector, bool>(RoomGridCell, true));
-			}
-		}
+		UE_LOG(LogTemp, Log, TEXT("ADungeonGenerator::BuildLayout - Loaded layout for seed %d from the layout cache"), Builder.GetParams().Seed);
 	}
 }
 
-void ADungeonGenerator::BuildConnections()
+bool ADungeonGenerator::ShouldUseLayoutCache() const
 {
-	Connections.Empty();
+	return bUseLayoutCache && !bRandomizeSeed;
+}
 
-	// Initially making connections from every room to every other room for now
-	for (FDungeonRoom Room : Rooms)
+bool ADungeonGenerator::IsGenerating() const
+{
+	return ActiveBuilder.IsValid();
+}
+
+float ADungeonGenerator::GetGenerationProgress() const
+{
+	return ActiveBuilder.IsValid() ? ActiveBuilder->GetProgress() : 1.0f;
+}
+
+bool ADungeonGenerator::IsSpawningTiles() const
+{
+	return PendingTileSpawns.Num() > 0;
+}
+
+float ADungeonGenerator::GetTileSpawnProgress() const
+{
+	return PendingTileSpawns.Num() > 0 ? (float)NextPendingTileSpawn / PendingTileSpawns.Num() : 1.0f;
+}
+
+FDungeonGenerationParams ADungeonGenerator::GetGenerationParams() const
+{
+	FDungeonGenerationParams Params;
+	Params.Seed = Seed;
+	Params.RoomDungeonGridSize = RoomDungeonGridSize;
+	Params.NumberOfRooms = NumberOfRooms;
+	Params.RoomSizeMin = RoomSizeMin;
+	Params.RoomSizeMax = RoomSizeMax;
+	Params.MinRoomDistance = MinRoomDistance;
+	Params.RoomPlacementStrategy = RoomPlacementStrategy;
+	Params.MaxPlacementAttempts = MaxPlacementAttempts;
+	Params.bAddExtraConnections = bAddExtraConnections;
+	Params.AdditionalConnectionsRatio = AdditionalConnectionsRatio;
+	Params.MaxRoomConnections = MaxRoomConnections;
+	Params.MaxLoopLength = MaxLoopLength;
+	Params.bCarveCorridors = bCarveCorridors;
+	Params.CorridorReuseCost = CorridorReuseCost;
+	Params.CorridorVerticalCost = CorridorVerticalCost;
+	Params.MaxStairsHeight = MaxStairsHeight;
+	Params.NumPlayerStarts = NumPlayerStarts;
+	Params.NumChests = NumChests;
+	Params.MinChestDistance = MinChestDistance;
+	Params.NumAISpawns = NumAISpawns;
+	Params.DungeonGridSize = DungeonGridSize;
+	Params.NumberOfTiles = NumberOfTiles;
+	return Params;
+}
+
+bool ADungeonGenerator::ParseCommandletGenerationParams(const FString& CommandLine, FDungeonGenerationParams& OutParams)
+{
+	UClass* GeneratorClass = ADungeonGenerator::StaticClass();
+	FString GeneratorClassPath;
+	if (FParse::Value(*CommandLine, TEXT("Generator="), GeneratorClassPath))
 	{
-		for (FDungeonRoom OtherRoom : Rooms)
+		GeneratorClass = LoadClass<ADungeonGenerator>(nullptr, *GeneratorClassPath);
+		if (!GeneratorClass)
 		{
-			if (Room != OtherRoom)
-			{
-				FDungeonConnection Connection = FDungeonConnection(Room, OtherRoom);
-				Connections.HeapPush(Connection, FDungeonConnectionPredicate());
-			}
+			UE_LOG(LogTemp, Error, TEXT("ADungeonGenerator::ParseCommandletGenerationParams - Failed to load generator class %s"), *GeneratorClassPath);
+			return false;
 		}
 	}
 
-	// Create minimum spanning tree from connections
-	TArray<FDungeonConnection> TempConnections = Connections;
-	TArray<FDungeonConnection> DungeonConnections;
-	TArray<FDungeonConnectionSet> ConnectionSets;
-	for (int ConnectionIndex = 0; ConnectionIndex < Connections.Num(); ConnectionIndex++)
+	OutParams = GeneratorClass->GetDefaultObject<ADungeonGenerator>()->GetGenerationParams();
+	FString Mode = TEXT("All");
+	FParse::Value(*CommandLine, TEXT("Mode="), Mode);
+	if (Mode == TEXT("Tiles"))
+	{
+		OutParams.bGenerateRooms = false;
+	}
+	else if (Mode == TEXT("Rooms"))
+	{
+		OutParams.bGenerateTiles = false;
+	}
+	else if (Mode != TEXT("All"))
 	{
-		FDungeonConnection NextConnection;
-		TempConnections.HeapPop(NextConnection, FDungeonConnectionPredicate());
+		UE_LOG(LogTemp, Error, TEXT("ADungeonGenerator::ParseCommandletGenerationParams - Unknown mode %s, expected Tiles, Rooms or All"), *Mode);
+		return false;
+	}
+	return true;
+}
 
-		bool CycleDetected = false;
-		FDungeonConnectionSet RoomOneSet;
-		RoomOneSet.Set.Add(NextConnection.GetRoomOne());
-		FDungeonConnectionSet RoomTwoSet;
-		RoomTwoSet.Set.Add(NextConnection.GetRoomTwo());
+void ADungeonGenerator::UpdateSeed()
+{
+	if (bRandomizeSeed)
+	{
+		Seed = FMath::Rand();
+	}
+}
 
-		for (FDungeonConnectionSet ConnectionSet : ConnectionSets)
-		{
-			if (ConnectionSet.Set.Contains(NextConnection.GetRoomOne()))
-			{
-				RoomOneSet = ConnectionSet;
-			}
-			if (ConnectionSet.Set.Contains(NextConnection.GetRoomTwo()))
-			{
-				RoomTwoSet = ConnectionSet;
-			}
-			if (RoomOneSet == RoomTwoSet)
-			{
-				CycleDetected = true;
-				break;
-			}
-		}
+void ADungeonGenerator::ReplicateLayout(const FDungeonGenerationParams& Params, int32 Checksum)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
 
-		if (!CycleDetected)
-		{
-			ConnectionSets.Remove(RoomOneSet);
-			ConnectionSets.Remove(RoomTwoSet);
-			FDungeonConnectionSet UnionedSet = RoomOneSet.Union(RoomTwoSet);
-			ConnectionSets.Add(UnionedSet);
+	ReplicatedLayout.Params = Params;
+	ReplicatedLayout.Checksum = Checksum;
+	ReplicatedLayout.GenerationIndex++;
+}
 
-			DungeonConnections.Add(NextConnection);
-		}
+void ADungeonGenerator::ApplyLayout(FDungeonLayout&& Layout)
+{
+	Layout.CreateRoomOutput(Rooms, Connections);
+	Tiles = MoveTemp(Layout.Tiles);
+	Corridors = MoveTemp(Layout.Corridors);
+	VerticalConnectors = MoveTemp(Layout.VerticalConnectors);
+	Placements = MoveTemp(Layout.Placements);
+	PortalGraph = MoveTemp(Layout.PortalGraph);
+	RoomSizeAverage = Layout.RoomSizeAverage;
+
+	PortalCullingComponent->SetPortalGraph(&PortalGraph, DungeonTileSize);
+	RoomRouteComponent->SetPortalGraph(&PortalGraph, DungeonTileSize);
+
+	// Player starts have to be in place before tile spawning picks its origin from them
+	SpawnPlacements();
+}
 
-		if (DungeonConnections.Num() == Rooms.Num() - 1)
+TArray<FTransform> ADungeonGenerator::GetPlacementTransforms(EDungeonPlacementType Type) const
+{
+	TArray<FTransform> Transforms;
+	for (const FDungeonPlacement& Placement : Placements)
+	{
+		if (Placement.Type == Type)
 		{
-			break;
+			Transforms.Add(FTransform(FRotator(0.0f, Placement.Yaw, 0.0f), Placement.Location * DungeonTileSize, FVector::OneVector));
 		}
 	}
+	return Transforms;
+}
+
+void ADungeonGenerator::SpawnPlacements()
+{
+	UWorld* World = GetWorld();
+	if (!HasAuthority() || !World || !World->IsGameWorld())
+	{
+		return;
+	}
+
+	// Player start locations are the center of their capsule, so they are lifted off the floor by its half height
+	float PlayerStartHeight = 0.0f;
+	if (PlayerStartClass)
+	{
+		PlayerStartHeight = PlayerStartClass->GetDefaultObject<APlayerStart>()->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	}
 
-	// Add a percentage of connections back (based on room total for now)
-	if (bAddExtraConnections)
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	for (const FDungeonPlacement& Placement : Placements)
 	{
-		int AdditionalConnections = NumberOfRooms * AdditionalConnectionsRatio;
+		const FRotator Rotation = FRotator(0.0f, Placement.Yaw, 0.0f);
+		const FVector Location = Placement.Location * DungeonTileSize;
+		AActor* PlacementActor = nullptr;
+		if (Placement.Type == EDungeonPlacementType::PlayerStart && PlayerStartClass)
+		{
+			PlacementActor = World->SpawnActor<APlayerStart>(PlayerStartClass, Location + FVector(0.0f, 0.0f, PlayerStartHeight), Rotation, SpawnParams);
+		}
+		else if (Placement.Type == EDungeonPlacementType::Chest && ChestClass)
+		{
+			PlacementActor = World->SpawnActor<AChest>(ChestClass, Location, Rotation, SpawnParams);
+		}
 
-		for (int ConnectionIndex = 0; ConnectionIndex < AdditionalConnections; ConnectionIndex++)
+		if (PlacementActor)
 		{
-			// Pick a random room and add the shortest edge for that room not already connected
-			FDungeonRoom& Room = Rooms[FMath::RandRange(0, Rooms.Num() - 1)];
-			FDungeonConnection NextConnection;
-			bool ConnectionAlreadyMade = true;
-			while (ConnectionAlreadyMade)
-			{
-				TempConnections.HeapPop(NextConnection, FDungeonConnectionPredicate());
-				if (NextConnection.Contains(Room))
-				{
-					ConnectionAlreadyMade = DungeonConnections.Contains(NextConnection);
-				}
-			}
-			DungeonConnections.Add(NextConnection);
+			PlacementActors.Add(PlacementActor);
 		}
 	}
-
-	Connections = DungeonConnections;
 }
 
 void ADungeonGenerator::DrawDebugDungeon()
@@ -250,14 +433,14 @@ void ADungeonGenerator::DrawDebugDungeon()
 		{
 			DebugColor = FColor::Red;
 		}
-		FVector RoomCenter = FVector(Room.Location.X * DungeonTileSize.X, Room.Location.Y * DungeonTileSize.Y, Room.Location.Z * DungeonTileSize.Z);
+		FVector RoomCenter = (FVector(Room.Location) + FVector(Room.Size) * 0.5f) * DungeonTileSize;
 		FVector RoomExtent = FVector((Room.Size.X * DungeonTileSize.X) / 2, (Room.Size.Y * DungeonTileSize.Y) / 2, (Room.Size.Z * DungeonTileSize.Z) / 2);
 		DrawDebugBox(GetWorld(), RoomCenter, RoomExtent, FRotator::ZeroRotator.Quaternion(), DebugColor, false, 10000.0f, 0, 25.0f);
 	}
 	for (FDungeonConnection Connection : Connections)
 	{
-		FVector FromRoomLocation = FVector(Connection.GetRoomOne().Location.X * DungeonTileSize.X, Connection.GetRoomOne().Location.Y * DungeonTileSize.Y, Connection.GetRoomOne().Location.Z * DungeonTileSize.Z);
-		FVector ToRoomLocation = FVector(Connection.GetRoomTwo().Location.X * DungeonTileSize.X, Connection.GetRoomTwo().Location.Y * DungeonTileSize.Y, Connection.GetRoomTwo().Location.Z * DungeonTileSize.Z);
+		FVector FromRoomLocation = (FVector(Connection.GetRoomOne().Location) + FVector(Connection.GetRoomOne().Size) * 0.5f) * DungeonTileSize;
+		FVector ToRoomLocation = (FVector(Connection.GetRoomTwo().Location) + FVector(Connection.GetRoomTwo().Size) * 0.5f) * DungeonTileSize;
 		DrawDebugLine(GetWorld(), FromRoomLocation, ToRoomLocation, FColor::Orange, false, 10000.0f, 0, 25.0f);
 	}
 }
@@ -266,16 +449,63 @@ void ADungeonGenerator::DestroyDungeon()
 {
 	FlushPersistentDebugLines(GetWorld());
 
-	for (TTuple<FIntVector, FTileData>& Tile : Tiles)
+	// Drop the result of any asynchronous generation still in flight
+	GenerationRequestId++;
+	ActiveBuilder.Reset();
+
+	for (FDungeonTileGraph* TileGraph : { &Tiles, &Corridors })
+	{
+		for (FTileData& Tile : TileGraph->GetTiles())
+		{
+			if (Tile.TileActor)
+			{
+				ReleaseTileActor(Tile.TileActor);
+				Tile.TileActor = nullptr;
+			}
+		}
+	}
+
+	for (ADungeonTile* ConnectorActor : VerticalConnectorActors)
 	{
-		ADungeonTile* TileActor = Tile.Value.TileActor;
-		if (TileActor)
+		if (ConnectorActor)
 		{
-			GetWorld()->DestroyActor(TileActor);
+			ReleaseTileActor(ConnectorActor);
 		}
 	}
+	VerticalConnectorActors.Empty();
+
+	for (AActor* PlacementActor : PlacementActors)
+	{
+		if (PlacementActor && !PlacementActor->IsPendingKill())
+		{
+			PlacementActor->Destroy();
+		}
+	}
+	PlacementActors.Empty();
 
 	Tiles.Empty();
+	Corridors.Empty();
+	VerticalConnectors.Empty();
+	Placements.Empty();
+	PendingTileSpawns.Empty();
+	NextPendingTileSpawn = 0;
+	NavigationComponent->Reset();
+	TrimTilePools();
+
+	PortalCullingComponent->SetPortalGraph(nullptr, DungeonTileSize);
+	RoomRouteComponent->SetPortalGraph(nullptr, DungeonTileSize);
+	PortalGraph.Empty();
+
+	// Regions change with every layout, so the per region mesh components can't be reused
+	for (UHierarchicalInstancedStaticMeshComponent* TileMeshComponent : TileMeshComponents)
+	{
+		if (TileMeshComponent)
+		{
+			TileMeshComponent->DestroyComponent();
+		}
+	}
+	TileMeshComponents.Empty();
+	TileMeshComponentIndices.Empty();
 }
 
 TSubclassOf<ADungeonTile> ADungeonGenerator::GetTileClass(ETileType Type)
@@ -295,218 +525,343 @@ TSubclassOf<ADungeonTile> ADungeonGenerator::GetTileClass(ETileType Type)
 	return ADungeonTile::StaticClass();
 }
 
-void ADungeonGenerator::GenerateTileLayout()
+void ADungeonGenerator::SpawnTileLayout()
 {
-	int32 TilesGenerated = 0;
-	FTileData OriginTile = FTileData();
-	FIntVector OriginTileLocation = FIntVector(DungeonGridSize.X / 2, DungeonGridSize.Y / 2, DungeonGridSize.Z / 2);
-	Tiles.Add(TTuple<FIntVector, FTileData>(OriginTileLocation, OriginTile));
-	TQueue<FTileData> TileQueue;
-	TileQueue.Enqueue(OriginTile);
-	TilesGenerated++;
+	double SpawnStartTime = FPlatformTime::Seconds();
 
-	while (TilesGenerated < NumberOfTiles)
+	// Every tile is in place within this frame, so the whole dungeon is handed to the navmesh at once
+	NavigationComponent->BeginDeferredUpdates(PortalGraph.GetNumRegions());
+
+	int32 NumTileActors = 0;
+	for (FTileData& Tile : Tiles.GetTiles())
+	{
+		SpawnTile(Tile, GetTileLocation(Tile.Coordinate), TileSize, INDEX_NONE);
+		NumTileActors += Tile.TileActor ? 1 : 0;
+	}
+	for (FTileData& Tile : Corridors.GetTiles())
 	{
-		FTileData ActiveTile;
-		TileQueue.Dequeue(ActiveTile);
+		SpawnTile(Tile, GetCorridorTileLocation(Tile.Coordinate), DungeonTileSize, GetTileRegion(Corridors, Tile));
+		NumTileActors += Tile.TileActor ? 1 : 0;
+	}
+	SpawnVerticalConnectors();
+	NavigationComponent->ReleaseAllRegions();
+
+	UE_LOG(LogTemp, Log, TEXT("ADungeonGenerator::SpawnTileLayout - Spawned %d tiles (%d actors, %d instanced mesh components) in %f seconds"), Tiles.Num() + Corridors.Num(), NumTileActors, TileMeshComponents.Num(), FPlatformTime::Seconds() - SpawnStartTime);
+}
 
-		const FIntVector* pActiveTileLocation = Tiles.FindKey(ActiveTile);
-		if (!pActiveTileLocation)
+void ADungeonGenerator::BeginTileSpawning()
+{
+	PendingTileSpawns.Empty();
+	NextPendingTileSpawn = 0;
+
+	// Editor worlds don't tick, so only game worlds can spawn over several frames
+	UWorld* World = GetWorld();
+	if (!bTimeSliceTileSpawning || !World || !World->IsGameWorld() || Tiles.Num() + Corridors.Num() == 0)
+	{
+		SpawnTileLayout();
+		OnDungeonSpawned.Broadcast(this);
+		return;
+	}
+
+	NavigationComponent->BeginDeferredUpdates(PortalGraph.GetNumRegions());
+
+	PendingTileSpawns.Reserve(Tiles.Num() + Corridors.Num());
+	for (int32 TileIndex = 0; TileIndex < Tiles.Num(); TileIndex++)
+	{
+		PendingTileSpawns.Add({ &Tiles, TileIndex, GetTileLocation(Tiles[TileIndex].Coordinate), GetTileRegion(Tiles, Tiles[TileIndex]) });
+	}
+	for (int32 TileIndex = 0; TileIndex < Corridors.Num(); TileIndex++)
+	{
+		PendingTileSpawns.Add({ &Corridors, TileIndex, GetCorridorTileLocation(Corridors[TileIndex].Coordinate), GetTileRegion(Corridors, Corridors[TileIndex]) });
+	}
+	for (const FPendingTileSpawn& PendingTile : PendingTileSpawns)
+	{
+		NavigationComponent->AddPendingTile(PendingTile.Region);
+	}
+
+	// There are only a few connectors, so they are spawned right away and join the navmesh with their region
+	SpawnVerticalConnectors();
+
+	// Spawn outward from where players start, so the area around them is ready first
+	const FVector Origin = GetTileSpawnOrigin();
+	PendingTileSpawns.Sort([Origin](const FPendingTileSpawn& A, const FPendingTileSpawn& B)
+	{
+		return FVector::DistSquared(A.Location, Origin) < FVector::DistSquared(B.Location, Origin);
+	});
+}
+
+void ADungeonGenerator::SpawnVerticalConnectors()
+{
+	for (const FDungeonVerticalConnector& Connector : VerticalConnectors)
+	{
+		const bool bIsStairs = Connector.Type == EVerticalConnectorType::Stairs;
+		TSubclassOf<ADungeonTile> TileClass = bIsStairs ? StairsTileClass : ShaftTileClass;
+		if (!TileClass)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("ADungeonGenerator::GenerateTileLayout - Could not get active tile location"));
 			continue;
 		}
-		TArray<ECardinalDirection> AvailableConnectionDirections;
-		for (TTuple<ECardinalDirection, bool>& DirectionMapping : ActiveTile.Directions)
-		{
-			bool IsOutsideOfGrid = false;
-
-			switch (DirectionMapping.Key)
-			{
-			case ECardinalDirection::North:
-				DirectionMapping.Value = Tiles.Contains(*pActiveTileLocation + FIntVector(1, 0, 0));
-				IsOutsideOfGrid = (pActiveTileLocation->X + 1 >= DungeonGridSize.X);
-				break;
-			case ECardinalDirection::South:
-				DirectionMapping.Value = Tiles.Contains(*pActiveTileLocation + FIntVector(-1, 0, 0));
-				IsOutsideOfGrid = (pActiveTileLocation->X - 1 < 0);
-				break;
-			case ECardinalDirection::East:
-				DirectionMapping.Value = Tiles.Contains(*pActiveTileLocation + FIntVector(0, 1, 0));
-				IsOutsideOfGrid = (pActiveTileLocation->Y + 1 >= DungeonGridSize.Y);
-				break;
-			case ECardinalDirection::West:
-				DirectionMapping.Value = Tiles.Contains(*pActiveTileLocation + FIntVector(0, -1, 0));
-				IsOutsideOfGrid = (pActiveTileLocation->Y + 1 >= DungeonGridSize.Y);
-				break;
-			default:
-				break;
-			}
 
-			// TODO: Should the direction mapping be updated or should we just continue?
-			if (IsOutsideOfGrid || DirectionMapping.Value)
+		static const float ExitYaws[4] = { 0.0f, 180.0f, 90.0f, -90.0f };
+		const FRotator Rotation = FRotator(0.0f, bIsStairs ? ExitYaws[(uint8)Connector.ExitDirection] : 0.0f, 0.0f);
+		for (int32 Floor = 0; Floor < Connector.Height; Floor++)
+		{
+			const FIntVector Cell = Connector.Bottom + FIntVector(0, 0, Floor);
+			const int32 Region = PortalGraph.FindRegion(Cell);
+			ADungeonTile* ConnectorActor = AcquireTileActor(TileClass, FTransform(Rotation, GetCorridorTileLocation(Cell), FVector::OneVector));
+			NavigationComponent->DeferActor(Region, ConnectorActor);
+			if (Region != INDEX_NONE)
 			{
-				//UE_LOG(LogTemp, Warning, TEXT("ADungeonGenerator::GenerateTileLayout - Tried to place tile at out of bounds location"));
-				continue;
+				PortalCullingComponent->RegisterRegionActor(Region, ConnectorActor);
 			}
-			AvailableConnectionDirections.Add(DirectionMapping.Key);
+			VerticalConnectorActors.Add(ConnectorActor);
 		}
+	}
+}
+
+bool ADungeonGenerator::SpawnPendingTiles()
+{
+	const double EndTime = FPlatformTime::Seconds() + TileSpawnBudgetMs / 1000.0;
+	do
+	{
+		const FPendingTileSpawn& PendingTile = PendingTileSpawns[NextPendingTileSpawn++];
+		FTileData& TileData = (*PendingTile.TileGraph)[PendingTile.TileIndex];
+		SpawnTile(TileData, PendingTile.Location, PendingTile.TileGraph == &Corridors ? DungeonTileSize : TileSize, PendingTile.Region);
+		NavigationComponent->OnTileSpawned(PendingTile.Region);
+	}
+	while (NextPendingTileSpawn < PendingTileSpawns.Num() && FPlatformTime::Seconds() < EndTime);
+
+	return NextPendingTileSpawn >= PendingTileSpawns.Num();
+}
+
+FVector ADungeonGenerator::GetTileSpawnOrigin() const
+{
+	TActorIterator<APlayerStart> PlayerStartIterator(GetWorld());
+	if (PlayerStartIterator)
+	{
+		return PlayerStartIterator->GetActorLocation();
+	}
+	return GetTileLocation(FIntVector(DungeonGridSize.X / 2, DungeonGridSize.Y / 2, DungeonGridSize.Z / 2));
+}
+
+void ADungeonGenerator::SpawnTile(FTileData& TileData, const FVector& Location, const FVector& Size, int32 Region)
+{
+	FRotator SpawnRotation;
+	TSubclassOf<ADungeonTile> TileClass;
+	GetTileClassAndRotation(TileData.GetConnection(), TileClass, SpawnRotation);
+	if (!TileClass)
+	{
+		return;
+	}
 
-		if (AvailableConnectionDirections.Num() > 0)
+	FTransform SpawnTransform = FTransform(SpawnRotation, Location, FVector::OneVector);
+	const ADungeonTile* TileDefaults = TileClass->GetDefaultObject<ADungeonTile>();
+	if (bUseInstancedTileMeshes && TileDefaults->CanBeInstanced())
+	{
+		GetTileMeshComponent(TileClass, Region)->AddInstanceWorldSpace(SpawnTransform);
+	}
+	else
+	{
+		TileData.TileActor = AcquireTileActor(TileClass, SpawnTransform);
+		NavigationComponent->DeferActor(Region, TileData.TileActor);
+		if (Region != INDEX_NONE)
 		{
-			ECardinalDirection NewTileDirection = AvailableConnectionDirections[FMath::RandRange(0, AvailableConnectionDirections.Num() - 1)];
-			FTileData NewTile;
-			ActiveTile.Directions[NewTileDirection] = true;
+			PortalCullingComponent->RegisterRegionActor(Region, TileData.TileActor);
+		}
+	}
 
-			FIntVector NewTileLocation = *pActiveTileLocation;
+	DrawDebugBox(GetWorld(), Location, Size / 2, FRotator::ZeroRotator.Quaternion(), FColor::Green, false, 10.0f);
+}
 
-			switch (NewTileDirection)
-			{
-			case ECardinalDirection::North:
-				NewTile.Directions[ECardinalDirection::South] = true;
-				NewTileLocation.X++;
-				break;
-			case ECardinalDirection::South:
-				NewTile.Directions[ECardinalDirection::North] = true;
-				NewTileLocation.X--;
-				break;
-			case ECardinalDirection::East:
-				NewTile.Directions[ECardinalDirection::West] = true;
-				NewTileLocation.Y++;
-				break;
-			case ECardinalDirection::West:
-				NewTile.Directions[ECardinalDirection::East] = true;
-				NewTileLocation.Y--;
-				break;
-			default:
-				break;
-			}
+ADungeonTile* ADungeonGenerator::AcquireTileActor(TSubclassOf<ADungeonTile> TileClass, const FTransform& Transform)
+{
+	FDungeonTilePool& Pool = TilePools.FindOrAdd(TileClass);
+	Pool.NumActive++;
+	Pool.HighWaterMark = FMath::Max(Pool.HighWaterMark, Pool.NumActive);
+
+	while (Pool.FreeTiles.Num() > 0)
+	{
+		ADungeonTile* TileActor = Pool.FreeTiles.Pop(false);
+		TilePoolStats.NumPooled--;
+		if (TileActor && !TileActor->IsPendingKill())
+		{
+			TileActor->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+			TileActor->SetTileActive(true);
+			TilePoolStats.NumReused++;
+			return TileActor;
+		}
+	}
 
-			FVector SpawnOffset = FVector(TileSize.X * DungeonGridSize.X / 2, TileSize.Y * DungeonGridSize.Y / 2, TileSize.Z * DungeonGridSize.Z / 2);
-			FVector ActiveLocationVector = FVector(pActiveTileLocation->X * TileSize.X, pActiveTileLocation->Y * TileSize.Y, pActiveTileLocation->Z * TileSize.Z) - SpawnOffset;
-			FVector NewLocationVector = FVector(NewTileLocation.X * TileSize.X, NewTileLocation.Y * TileSize.Y, NewTileLocation.Z * TileSize.Z) - SpawnOffset;
-			FVector DrawDebugOffset = FVector(0, 0, 100);
+	FActorSpawnParameters SpawnParams = FActorSpawnParameters();
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	TilePoolStats.NumSpawned++;
+	return GetWorld()->SpawnActor<ADungeonTile>(TileClass, Transform, SpawnParams);
+}
 
-			if (Tiles.Find(NewTileLocation))
-			{
-				UE_LOG(LogTemp, Warning, TEXT("ADungeonGenerator::GenerateTileLayout - Tile %d overwrote tile at (%d, %d, %d)"), TilesGenerated + 1, NewTileLocation.X, NewTileLocation.Y, NewTileLocation.Z);
-				DrawDebugPoint(GetWorld(), NewLocationVector + DrawDebugOffset, 100.0, FColor::Red);
-				return;
-			}
+void ADungeonGenerator::ReleaseTileActor(ADungeonTile* TileActor)
+{
+	FDungeonTilePool* Pool = TilePools.Find(TileActor->GetClass());
+	if (Pool)
+	{
+		Pool->NumActive = FMath::Max(Pool->NumActive - 1, 0);
+	}
+
+	// Editor worlds are saved with their actors, so hidden pooled tiles must not be left behind in them
+	UWorld* World = GetWorld();
+	if (!bPoolTileActors || !Pool || !World || !World->IsGameWorld() || TileActor->IsPendingKill())
+	{
+		TileActor->Destroy();
+		return;
+	}
 
-			DrawDebugPoint(GetWorld(), NewLocationVector + DrawDebugOffset, 150.0, FColor::Cyan);
-			DrawDebugLine(GetWorld(), ActiveLocationVector + DrawDebugOffset, NewLocationVector + DrawDebugOffset, FColor::Red, false, 10.0);
+	TileActor->SetTileActive(false);
+	Pool->FreeTiles.Add(TileActor);
+	TilePoolStats.NumReleased++;
+	TilePoolStats.NumPooled++;
+}
 
-			Tiles.Add(TTuple<FIntVector, FTileData>(NewTileLocation, NewTile));
-			const FIntVector* ActiveTileKey = Tiles.FindKey(ActiveTile);
-			if (ActiveTileKey)
+void ADungeonGenerator::TrimTilePools()
+{
+	for (TTuple<UClass*, FDungeonTilePool>& TilePool : TilePools)
+	{
+		FDungeonTilePool& Pool = TilePool.Value;
+		const int32 MaxFreeTiles = FMath::CeilToInt(Pool.HighWaterMark * (1.0f + TilePoolSlack)) - Pool.NumActive;
+		while (Pool.FreeTiles.Num() > FMath::Max(MaxFreeTiles, 0))
+		{
+			ADungeonTile* TileActor = Pool.FreeTiles.Pop(false);
+			if (TileActor)
 			{
-				FIntVector TempKey = *ActiveTileKey;
-				Tiles.Remove(*ActiveTileKey);
-				Tiles.Add(TTuple<FIntVector, FTileData>(TempKey, ActiveTile));
+				TileActor->Destroy();
 			}
+			TilePoolStats.NumPooled--;
+			TilePoolStats.NumTrimmed++;
+		}
 
-			//TODO: Check adjacent tiles and mark as connected?
-
-			TileQueue.Enqueue(NewTile);
-			TileQueue.Enqueue(ActiveTile);
+		// Only the next dungeon's usage counts towards the next trim, so pools shrink again after an unusually large dungeon
+		Pool.HighWaterMark = Pool.NumActive;
+	}
+}
 
-			TilesGenerated++;
-		}
-		else
+void ADungeonGenerator::EmptyTilePools()
+{
+	for (TTuple<UClass*, FDungeonTilePool>& TilePool : TilePools)
+	{
+		for (ADungeonTile* TileActor : TilePool.Value.FreeTiles)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("ADungeonGenerator::GenerateTileLayout - Failed to generate a connection for tile (%d, %d, %d)"), pActiveTileLocation->X, pActiveTileLocation->Y, pActiveTileLocation->Z);
+			if (TileActor)
+			{
+				TileActor->Destroy();
+			}
+			TilePoolStats.NumTrimmed++;
 		}
+		TilePool.Value.FreeTiles.Empty();
 	}
-	UE_LOG(LogTemp, Warning, TEXT("ADungeonGenerator::GenerateTileLayout - Generated %d tiles"), TilesGenerated);
+	TilePoolStats.NumPooled = 0;
 }
 
-void ADungeonGenerator::SpawnTileLayout()
+FVector ADungeonGenerator::GetTileLocation(const FIntVector& Coordinate) const
 {
 	FVector SpawnOffset = FVector(TileSize.X * DungeonGridSize.X / 2, TileSize.Y * DungeonGridSize.Y / 2, TileSize.Z * DungeonGridSize.Z / 2);
+	return FVector(Coordinate.X * TileSize.X, Coordinate.Y * TileSize.Y, Coordinate.Z * TileSize.Z) - SpawnOffset;
+}
+
+FVector ADungeonGenerator::GetCorridorTileLocation(const FIntVector& Coordinate) const
+{
+	// Room grid cells span [Coordinate, Coordinate + 1) * DungeonTileSize, tiles sit in the middle of the cell's floor
+	return FVector(Coordinate.X + 0.5f, Coordinate.Y + 0.5f, Coordinate.Z) * DungeonTileSize;
+}
+
+int32 ADungeonGenerator::GetTileRegion(const FDungeonTileGraph& TileGraph, const FTileData& TileData) const
+{
+	// Only corridors are part of the portal graph, the tile style layout is never culled
+	return &TileGraph == &Corridors ? PortalGraph.FindCorridorRegion(TileData.Coordinate) : INDEX_NONE;
+}
 
-	for (TTuple<FIntVector, FTileData>& Tile : Tiles)
+UHierarchicalInstancedStaticMeshComponent* ADungeonGenerator::GetTileMeshComponent(TSubclassOf<ADungeonTile> TileClass, int32 Region)
+{
+	const TPair<UClass*, int32> ComponentKey = TPair<UClass*, int32>(TileClass, Region);
+	const int32* ComponentIndex = TileMeshComponentIndices.Find(ComponentKey);
+	if (!ComponentIndex)
 	{
-		FVector SpawnLocation = FVector(Tile.Key.X * TileSize.X, Tile.Key.Y * TileSize.Y, Tile.Key.Z * TileSize.Z) - SpawnOffset;
-		FRotator SpawnRotation;
-		TSubclassOf<ADungeonTile> TileClass = ADungeonTile::StaticClass();
-		switch (Tile.Value.GetConnection())
+		UHierarchicalInstancedStaticMeshComponent* MeshComponent = NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+		MeshComponent->SetStaticMesh(TileClass->GetDefaultObject<ADungeonTile>()->GetTileMesh());
+		NavigationComponent->DeferComponent(Region, MeshComponent);
+		MeshComponent->RegisterComponent();
+		if (Region != INDEX_NONE)
 		{
-		case ETileConnection::N:
-			TileClass = DeadEndTileClass;
-			SpawnRotation = FRotator(0, 0, 0);
-			break;
-		case ETileConnection::S:
-			TileClass = DeadEndTileClass;
-			SpawnRotation = FRotator(0, 180, 0);
-			break;
-		case ETileConnection::E:
-			TileClass = DeadEndTileClass;
-			SpawnRotation = FRotator(0, 90, 0);
-			break;
-		case ETileConnection::W:
-			TileClass = DeadEndTileClass;
-			SpawnRotation = FRotator(0, -90, 0);
-			break;
-		case ETileConnection::NS:
-			TileClass = CorridorTileClass;
-			SpawnRotation = FRotator(0, 0, 0);
-			break;
-		case ETileConnection::NE:
-			TileClass = CornerTileClass;
-			SpawnRotation = FRotator(0, 0, 0);
-			break;
-		case ETileConnection::NW:
-			TileClass = CornerTileClass;
-			SpawnRotation = FRotator(0, -90, 0);
-			break;
-		case ETileConnection::SE:
-			TileClass = CornerTileClass;
-			SpawnRotation = FRotator(0, 90, 0);
-			break;
-		case ETileConnection::SW:
-			TileClass = CornerTileClass;
-			SpawnRotation = FRotator(0, 180, 0);
-			break;
-		case ETileConnection::EW:
-			TileClass = CorridorTileClass;
-			SpawnRotation = FRotator(0, 90, 0);
-			break;
-		case ETileConnection::NSE:
-			TileClass = ThreeWayTileClass;
-			SpawnRotation = FRotator(0, 90, 0);
-			break;
-		case ETileConnection::NSW:
-			TileClass = ThreeWayTileClass;
-			SpawnRotation = FRotator(0, -90, 0);
-			break;
-		case ETileConnection::SEW:
-			TileClass = ThreeWayTileClass;
-			SpawnRotation = FRotator(0, 180, 0);
-			break;
-		case ETileConnection::NEW:
-			TileClass = ThreeWayTileClass;
-			SpawnRotation = FRotator(0, 0, 0);
-			break;
-		case ETileConnection::NSEW:
-			TileClass = FourWayTileClass;
-			SpawnRotation = FRotator(0, 0, 0);
-			break;
-		default:
-			break;
+			PortalCullingComponent->RegisterRegionComponent(Region, MeshComponent);
 		}
-
-		FTransform SpawnTransform = FTransform(SpawnRotation, SpawnLocation, FVector::OneVector);
-		FActorSpawnParameters SpawnParams = FActorSpawnParameters();
-		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		Tile.Value.TileActor = GetWorld()->SpawnActor<ADungeonTile>(TileClass, SpawnTransform, SpawnParams);
-
-		DrawDebugBox(GetWorld(), SpawnLocation, FVector(TileSize.X / 2, TileSize.Y / 2, TileSize.Z / 2), FRotator::ZeroRotator.Quaternion(), FColor::Green, false, 10.0f);
+		ComponentIndex = &TileMeshComponentIndices.Add(ComponentKey, TileMeshComponents.Add(MeshComponent));
 	}
+	return TileMeshComponents[*ComponentIndex];
 }
 
-FVector ADungeonGenerator::GetRandomPointInSphere(float Radius)
+void ADungeonGenerator::GetTileClassAndRotation(ETileConnection Connection, TSubclassOf<ADungeonTile>& OutTileClass, FRotator& OutRotation) const
 {
-	return (FMath::VRand() * FMath::RandRange(0.0f, Radius));
+	OutTileClass = ADungeonTile::StaticClass();
+	OutRotation = FRotator(0, 0, 0);
+	switch (Connection)
+	{
+	case ETileConnection::N:
+		OutTileClass = DeadEndTileClass;
+		OutRotation = FRotator(0, 0, 0);
+		break;
+	case ETileConnection::S:
+		OutTileClass = DeadEndTileClass;
+		OutRotation = FRotator(0, 180, 0);
+		break;
+	case ETileConnection::E:
+		OutTileClass = DeadEndTileClass;
+		OutRotation = FRotator(0, 90, 0);
+		break;
+	case ETileConnection::W:
+		OutTileClass = DeadEndTileClass;
+		OutRotation = FRotator(0, -90, 0);
+		break;
+	case ETileConnection::NS:
+		OutTileClass = CorridorTileClass;
+		OutRotation = FRotator(0, 0, 0);
+		break;
+	case ETileConnection::NE:
+		OutTileClass = CornerTileClass;
+		OutRotation = FRotator(0, 0, 0);
+		break;
+	case ETileConnection::NW:
+		OutTileClass = CornerTileClass;
+		OutRotation = FRotator(0, -90, 0);
+		break;
+	case ETileConnection::SE:
+		OutTileClass = CornerTileClass;
+		OutRotation = FRotator(0, 90, 0);
+		break;
+	case ETileConnection::SW:
+		OutTileClass = CornerTileClass;
+		OutRotation = FRotator(0, 180, 0);
+		break;
+	case ETileConnection::EW:
+		OutTileClass = CorridorTileClass;
+		OutRotation = FRotator(0, 90, 0);
+		break;
+	case ETileConnection::NSE:
+		OutTileClass = ThreeWayTileClass;
+		OutRotation = FRotator(0, 90, 0);
+		break;
+	case ETileConnection::NSW:
+		OutTileClass = ThreeWayTileClass;
+		OutRotation = FRotator(0, -90, 0);
+		break;
+	case ETileConnection::SEW:
+		OutTileClass = ThreeWayTileClass;
+		OutRotation = FRotator(0, 180, 0);
+		break;
+	case ETileConnection::NEW:
+		OutTileClass = ThreeWayTileClass;
+		OutRotation = FRotator(0, 0, 0);
+		break;
+	case ETileConnection::NSEW:
+		OutTileClass = FourWayTileClass;
+		OutRotation = FRotator(0, 0, 0);
+		break;
+	default:
+		break;
+	}
 }
-
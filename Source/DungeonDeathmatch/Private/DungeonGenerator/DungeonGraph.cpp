@@ -0,0 +1,499 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonGraph.h"
+
+namespace
+{
+	struct FGraphPoint
+	{
+		double X;
+		double Y;
+		double Z;
+	};
+
+	struct FTriangle
+	{
+		int32 V[3];
+		double CenterX;
+		double CenterY;
+		double RadiusSq;
+	};
+
+	struct FTetrahedron
+	{
+		int32 V[4];
+		double CenterX;
+		double CenterY;
+		double CenterZ;
+		double RadiusSq;
+	};
+
+	/** Deterministic sub-cell offset used to break up the co-circular and co-spherical point sets that integer room grids produce */
+	double GetJitter(int32 Index, uint32 Axis)
+	{
+		uint32 Hash = (uint32)Index * 0x9E3779B1u + Axis * 0x85EBCA77u;
+		Hash ^= Hash >> 16;
+		Hash *= 0x7FEB352Du;
+		Hash ^= Hash >> 15;
+		Hash *= 0x846CA68Bu;
+		Hash ^= Hash >> 16;
+		return ((double)(Hash & 0xFFFF) / 65535.0 - 0.5) * 1e-3;
+	}
+
+	uint64 MakeEdgeKey(int32 A, int32 B)
+	{
+		if (A > B)
+		{
+			Swap(A, B);
+		}
+		return ((uint64)(uint32)A << 32) | (uint64)(uint32)B;
+	}
+
+	uint64 MakeFaceKey(int32 A, int32 B, int32 C)
+	{
+		if (A > B) Swap(A, B);
+		if (B > C) Swap(B, C);
+		if (A > B) Swap(A, B);
+		return ((uint64)(uint32)A << 42) | ((uint64)(uint32)B << 21) | (uint64)(uint32)C;
+	}
+
+	/** Sorts the keys and removes every key that appears more than once, leaving only the boundary of the cavity */
+	void RemoveSharedKeys(TArray<uint64>& Keys)
+	{
+		Keys.Sort();
+		int32 WriteIndex = 0;
+		int32 ReadIndex = 0;
+		while (ReadIndex < Keys.Num())
+		{
+			int32 RunEnd = ReadIndex + 1;
+			while (RunEnd < Keys.Num() && Keys[RunEnd] == Keys[ReadIndex])
+			{
+				RunEnd++;
+			}
+			if (RunEnd - ReadIndex == 1)
+			{
+				Keys[WriteIndex++] = Keys[ReadIndex];
+			}
+			ReadIndex = RunEnd;
+		}
+		Keys.SetNum(WriteIndex, false);
+	}
+
+	FTriangle MakeTriangle(const TArray<FGraphPoint>& Points, int32 A, int32 B, int32 C)
+	{
+		FTriangle Triangle;
+		Triangle.V[0] = A;
+		Triangle.V[1] = B;
+		Triangle.V[2] = C;
+
+		const FGraphPoint& PA = Points[A];
+		const FGraphPoint& PB = Points[B];
+		const FGraphPoint& PC = Points[C];
+
+		double Denominator = 2.0 * (PA.X * (PB.Y - PC.Y) + PB.X * (PC.Y - PA.Y) + PC.X * (PA.Y - PB.Y));
+		if (FMath::Abs(Denominator) < 1e-12)
+		{
+			// Degenerate triangle, make sure it is removed by the next insertion
+			Triangle.CenterX = (PA.X + PB.X + PC.X) / 3.0;
+			Triangle.CenterY = (PA.Y + PB.Y + PC.Y) / 3.0;
+			Triangle.RadiusSq = TNumericLimits<double>::Max();
+			return Triangle;
+		}
+
+		double LengthSqA = PA.X * PA.X + PA.Y * PA.Y;
+		double LengthSqB = PB.X * PB.X + PB.Y * PB.Y;
+		double LengthSqC = PC.X * PC.X + PC.Y * PC.Y;
+
+		Triangle.CenterX = (LengthSqA * (PB.Y - PC.Y) + LengthSqB * (PC.Y - PA.Y) + LengthSqC * (PA.Y - PB.Y)) / Denominator;
+		Triangle.CenterY = (LengthSqA * (PC.X - PB.X) + LengthSqB * (PA.X - PC.X) + LengthSqC * (PB.X - PA.X)) / Denominator;
+
+		double DeltaX = PA.X - Triangle.CenterX;
+		double DeltaY = PA.Y - Triangle.CenterY;
+		Triangle.RadiusSq = DeltaX * DeltaX + DeltaY * DeltaY;
+		return Triangle;
+	}
+
+	FTetrahedron MakeTetrahedron(const TArray<FGraphPoint>& Points, int32 A, int32 B, int32 C, int32 D)
+	{
+		FTetrahedron Tetrahedron;
+		Tetrahedron.V[0] = A;
+		Tetrahedron.V[1] = B;
+		Tetrahedron.V[2] = C;
+		Tetrahedron.V[3] = D;
+
+		const FGraphPoint& PA = Points[A];
+		double UX = Points[B].X - PA.X, UY = Points[B].Y - PA.Y, UZ = Points[B].Z - PA.Z;
+		double VX = Points[C].X - PA.X, VY = Points[C].Y - PA.Y, VZ = Points[C].Z - PA.Z;
+		double WX = Points[D].X - PA.X, WY = Points[D].Y - PA.Y, WZ = Points[D].Z - PA.Z;
+
+		// Cross products V x W, W x U, U x V
+		double VWX = VY * WZ - VZ * WY, VWY = VZ * WX - VX * WZ, VWZ = VX * WY - VY * WX;
+		double WUX = WY * UZ - WZ * UY, WUY = WZ * UX - WX * UZ, WUZ = WX * UY - WY * UX;
+		double UVX = UY * VZ - UZ * VY, UVY = UZ * VX - UX * VZ, UVZ = UX * VY - UY * VX;
+
+		double Denominator = 2.0 * (UX * VWX + UY * VWY + UZ * VWZ);
+		if (FMath::Abs(Denominator) < 1e-12)
+		{
+			// Flat tetrahedron, make sure it is removed by the next insertion
+			Tetrahedron.CenterX = PA.X;
+			Tetrahedron.CenterY = PA.Y;
+			Tetrahedron.CenterZ = PA.Z;
+			Tetrahedron.RadiusSq = TNumericLimits<double>::Max();
+			return Tetrahedron;
+		}
+
+		double LengthSqU = UX * UX + UY * UY + UZ * UZ;
+		double LengthSqV = VX * VX + VY * VY + VZ * VZ;
+		double LengthSqW = WX * WX + WY * WY + WZ * WZ;
+
+		double CenterX = (LengthSqU * VWX + LengthSqV * WUX + LengthSqW * UVX) / Denominator;
+		double CenterY = (LengthSqU * VWY + LengthSqV * WUY + LengthSqW * UVY) / Denominator;
+		double CenterZ = (LengthSqU * VWZ + LengthSqV * WUZ + LengthSqW * UVZ) / Denominator;
+
+		Tetrahedron.CenterX = PA.X + CenterX;
+		Tetrahedron.CenterY = PA.Y + CenterY;
+		Tetrahedron.CenterZ = PA.Z + CenterZ;
+		Tetrahedron.RadiusSq = CenterX * CenterX + CenterY * CenterY + CenterZ * CenterZ;
+		return Tetrahedron;
+	}
+
+	/** Copies the input points with a deterministic jitter and returns the insertion order, sorted along X for the sweep */
+	void PreparePoints(const TArray<FVector>& InPoints, TArray<FGraphPoint>& OutPoints, TArray<int32>& OutInsertionOrder)
+	{
+		OutPoints.Reset(InPoints.Num() + 4);
+		OutInsertionOrder.Reset(InPoints.Num());
+		for (int32 PointIndex = 0; PointIndex < InPoints.Num(); PointIndex++)
+		{
+			FGraphPoint Point;
+			Point.X = InPoints[PointIndex].X + GetJitter(PointIndex, 0);
+			Point.Y = InPoints[PointIndex].Y + GetJitter(PointIndex, 1);
+			Point.Z = InPoints[PointIndex].Z + GetJitter(PointIndex, 2);
+			OutPoints.Add(Point);
+			OutInsertionOrder.Add(PointIndex);
+		}
+
+		OutInsertionOrder.Sort([&OutPoints](const int32 A, const int32 B)
+		{
+			return OutPoints[A].X < OutPoints[B].X;
+		});
+	}
+}
+
+FDungeonUnionFind::FDungeonUnionFind(int32 NumElements /*= 0*/)
+{
+	Reset(NumElements);
+}
+
+void FDungeonUnionFind::Reset(int32 NumElements)
+{
+	Parents.SetNumUninitialized(NumElements);
+	Ranks.SetNumZeroed(NumElements);
+	for (int32 Element = 0; Element < NumElements; Element++)
+	{
+		Parents[Element] = Element;
+	}
+	NumSets = NumElements;
+}
+
+int32 FDungeonUnionFind::Find(int32 Element)
+{
+	int32 Root = Element;
+	while (Parents[Root] != Root)
+	{
+		Root = Parents[Root];
+	}
+
+	// Compress the path so every visited element points straight at the root
+	while (Parents[Element] != Root)
+	{
+		int32 Next = Parents[Element];
+		Parents[Element] = Root;
+		Element = Next;
+	}
+
+	return Root;
+}
+
+bool FDungeonUnionFind::Union(int32 A, int32 B)
+{
+	int32 RootA = Find(A);
+	int32 RootB = Find(B);
+	if (RootA == RootB)
+	{
+		return false;
+	}
+
+	if (Ranks[RootA] < Ranks[RootB])
+	{
+		Swap(RootA, RootB);
+	}
+	Parents[RootB] = RootA;
+	if (Ranks[RootA] == Ranks[RootB])
+	{
+		Ranks[RootA]++;
+	}
+	NumSets--;
+	return true;
+}
+
+TArray<FDungeonGraphEdge> FDungeonGraph::Triangulate(const TArray<FVector>& Points, bool bTetrahedralize)
+{
+	if (Points.Num() < 4)
+	{
+		return BuildCompleteGraph(Points);
+	}
+
+	if (bTetrahedralize)
+	{
+		// A tetrahedralization of points that all lie on one floor is flat, so use the planar triangulation instead
+		float MinZ = Points[0].Z;
+		float MaxZ = Points[0].Z;
+		for (const FVector& Point : Points)
+		{
+			MinZ = FMath::Min(MinZ, Point.Z);
+			MaxZ = FMath::Max(MaxZ, Point.Z);
+		}
+		if (MaxZ - MinZ > KINDA_SMALL_NUMBER)
+		{
+			return Tetrahedralize3D(Points);
+		}
+	}
+
+	return Triangulate2D(Points);
+}
+
+TArray<FDungeonGraphEdge> FDungeonGraph::BuildCompleteGraph(const TArray<FVector>& Points)
+{
+	TArray<FDungeonGraphEdge> Edges;
+	Edges.Reserve(Points.Num() * (Points.Num() - 1) / 2);
+	for (int32 IndexA = 0; IndexA < Points.Num(); IndexA++)
+	{
+		for (int32 IndexB = IndexA + 1; IndexB < Points.Num(); IndexB++)
+		{
+			Edges.Add(FDungeonGraphEdge(IndexA, IndexB, FVector::Distance(Points[IndexA], Points[IndexB])));
+		}
+	}
+	return Edges;
+}
+
+int32 FDungeonGraph::BuildMinimumSpanningTree(int32 NumNodes, TArray<FDungeonGraphEdge> CandidateEdges, TArray<FDungeonGraphEdge>& OutTreeEdges, TArray<FDungeonGraphEdge>& OutRemainingEdges)
+{
+	CandidateEdges.Sort();
+
+	FDungeonUnionFind UnionFind(NumNodes);
+	OutTreeEdges.Reset(FMath::Max(NumNodes - 1, 0));
+	OutRemainingEdges.Reset(CandidateEdges.Num());
+
+	for (const FDungeonGraphEdge& Edge : CandidateEdges)
+	{
+		if (UnionFind.GetNumSets() > 1 && UnionFind.Union(Edge.A, Edge.B))
+		{
+			OutTreeEdges.Add(Edge);
+		}
+		else
+		{
+			OutRemainingEdges.Add(Edge);
+		}
+	}
+
+	return UnionFind.GetNumSets();
+}
+
+TArray<FDungeonGraphEdge> FDungeonGraph::Triangulate2D(const TArray<FVector>& InPoints)
+{
+	TArray<FGraphPoint> Points;
+	TArray<int32> InsertionOrder;
+	PreparePoints(InPoints, Points, InsertionOrder);
+
+	const int32 NumPoints = InPoints.Num();
+
+	// Super triangle enclosing every point
+	double MinX = Points[0].X, MaxX = Points[0].X, MinY = Points[0].Y, MaxY = Points[0].Y;
+	for (int32 PointIndex = 1; PointIndex < NumPoints; PointIndex++)
+	{
+		MinX = FMath::Min(MinX, Points[PointIndex].X);
+		MaxX = FMath::Max(MaxX, Points[PointIndex].X);
+		MinY = FMath::Min(MinY, Points[PointIndex].Y);
+		MaxY = FMath::Max(MaxY, Points[PointIndex].Y);
+	}
+	double CenterX = (MinX + MaxX) * 0.5;
+	double CenterY = (MinY + MaxY) * 0.5;
+	double Scale = FMath::Max3(MaxX - MinX, MaxY - MinY, 1.0) * 100.0;
+	Points.Add({ CenterX - Scale, CenterY - Scale, 0.0 });
+	Points.Add({ CenterX + 5.0 * Scale, CenterY - Scale, 0.0 });
+	Points.Add({ CenterX - Scale, CenterY + 5.0 * Scale, 0.0 });
+
+	TArray<FTriangle> OpenTriangles;
+	TArray<FTriangle> ClosedTriangles;
+	OpenTriangles.Add(MakeTriangle(Points, NumPoints, NumPoints + 1, NumPoints + 2));
+
+	TArray<uint64> CavityEdges;
+	for (int32 PointIndex : InsertionOrder)
+	{
+		const FGraphPoint& Point = Points[PointIndex];
+		CavityEdges.Reset();
+
+		for (int32 TriangleIndex = OpenTriangles.Num() - 1; TriangleIndex >= 0; TriangleIndex--)
+		{
+			const FTriangle& Triangle = OpenTriangles[TriangleIndex];
+			double DeltaX = Point.X - Triangle.CenterX;
+
+			// Points are inserted in X order, so a circumcircle entirely to the left can never be invalidated again
+			if (DeltaX > 0.0 && DeltaX * DeltaX > Triangle.RadiusSq)
+			{
+				ClosedTriangles.Add(Triangle);
+				OpenTriangles.RemoveAtSwap(TriangleIndex, 1, false);
+				continue;
+			}
+
+			double DeltaY = Point.Y - Triangle.CenterY;
+			if (DeltaX * DeltaX + DeltaY * DeltaY <= Triangle.RadiusSq)
+			{
+				CavityEdges.Add(MakeEdgeKey(Triangle.V[0], Triangle.V[1]));
+				CavityEdges.Add(MakeEdgeKey(Triangle.V[1], Triangle.V[2]));
+				CavityEdges.Add(MakeEdgeKey(Triangle.V[2], Triangle.V[0]));
+				OpenTriangles.RemoveAtSwap(TriangleIndex, 1, false);
+			}
+		}
+
+		RemoveSharedKeys(CavityEdges);
+		for (uint64 EdgeKey : CavityEdges)
+		{
+			OpenTriangles.Add(MakeTriangle(Points, (int32)(EdgeKey >> 32), (int32)(EdgeKey & 0xFFFFFFFF), PointIndex));
+		}
+	}
+
+	ClosedTriangles.Append(OpenTriangles);
+
+	TArray<uint64> EdgeKeys;
+	EdgeKeys.Reserve(ClosedTriangles.Num() * 3);
+	for (const FTriangle& Triangle : ClosedTriangles)
+	{
+		if (Triangle.V[0] >= NumPoints || Triangle.V[1] >= NumPoints || Triangle.V[2] >= NumPoints)
+		{
+			continue;
+		}
+		EdgeKeys.Add(MakeEdgeKey(Triangle.V[0], Triangle.V[1]));
+		EdgeKeys.Add(MakeEdgeKey(Triangle.V[1], Triangle.V[2]));
+		EdgeKeys.Add(MakeEdgeKey(Triangle.V[2], Triangle.V[0]));
+	}
+
+	TArray<FDungeonGraphEdge> Edges;
+	AddUniqueEdges(EdgeKeys, InPoints, Edges);
+	return Edges;
+}
+
+TArray<FDungeonGraphEdge> FDungeonGraph::Tetrahedralize3D(const TArray<FVector>& InPoints)
+{
+	TArray<FGraphPoint> Points;
+	TArray<int32> InsertionOrder;
+	PreparePoints(InPoints, Points, InsertionOrder);
+
+	const int32 NumPoints = InPoints.Num();
+
+	// Super tetrahedron enclosing every point
+	double MinX = Points[0].X, MaxX = Points[0].X, MinY = Points[0].Y, MaxY = Points[0].Y, MinZ = Points[0].Z, MaxZ = Points[0].Z;
+	for (int32 PointIndex = 1; PointIndex < NumPoints; PointIndex++)
+	{
+		MinX = FMath::Min(MinX, Points[PointIndex].X);
+		MaxX = FMath::Max(MaxX, Points[PointIndex].X);
+		MinY = FMath::Min(MinY, Points[PointIndex].Y);
+		MaxY = FMath::Max(MaxY, Points[PointIndex].Y);
+		MinZ = FMath::Min(MinZ, Points[PointIndex].Z);
+		MaxZ = FMath::Max(MaxZ, Points[PointIndex].Z);
+	}
+	double CenterX = (MinX + MaxX) * 0.5;
+	double CenterY = (MinY + MaxY) * 0.5;
+	double CenterZ = (MinZ + MaxZ) * 0.5;
+	double Scale = FMath::Max(FMath::Max3(MaxX - MinX, MaxY - MinY, MaxZ - MinZ), 1.0) * 100.0;
+	Points.Add({ CenterX - Scale, CenterY - Scale, CenterZ - Scale });
+	Points.Add({ CenterX + 7.0 * Scale, CenterY - Scale, CenterZ - Scale });
+	Points.Add({ CenterX - Scale, CenterY + 7.0 * Scale, CenterZ - Scale });
+	Points.Add({ CenterX - Scale, CenterY - Scale, CenterZ + 7.0 * Scale });
+
+	TArray<FTetrahedron> OpenTetrahedra;
+	TArray<FTetrahedron> ClosedTetrahedra;
+	OpenTetrahedra.Add(MakeTetrahedron(Points, NumPoints, NumPoints + 1, NumPoints + 2, NumPoints + 3));
+
+	TArray<uint64> CavityFaces;
+	for (int32 PointIndex : InsertionOrder)
+	{
+		const FGraphPoint& Point = Points[PointIndex];
+		CavityFaces.Reset();
+
+		for (int32 TetrahedronIndex = OpenTetrahedra.Num() - 1; TetrahedronIndex >= 0; TetrahedronIndex--)
+		{
+			const FTetrahedron& Tetrahedron = OpenTetrahedra[TetrahedronIndex];
+			double DeltaX = Point.X - Tetrahedron.CenterX;
+
+			if (DeltaX > 0.0 && DeltaX * DeltaX > Tetrahedron.RadiusSq)
+			{
+				ClosedTetrahedra.Add(Tetrahedron);
+				OpenTetrahedra.RemoveAtSwap(TetrahedronIndex, 1, false);
+				continue;
+			}
+
+			double DeltaY = Point.Y - Tetrahedron.CenterY;
+			double DeltaZ = Point.Z - Tetrahedron.CenterZ;
+			if (DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ <= Tetrahedron.RadiusSq)
+			{
+				const int32* V = Tetrahedron.V;
+				CavityFaces.Add(MakeFaceKey(V[0], V[1], V[2]));
+				CavityFaces.Add(MakeFaceKey(V[0], V[1], V[3]));
+				CavityFaces.Add(MakeFaceKey(V[0], V[2], V[3]));
+				CavityFaces.Add(MakeFaceKey(V[1], V[2], V[3]));
+				OpenTetrahedra.RemoveAtSwap(TetrahedronIndex, 1, false);
+			}
+		}
+
+		RemoveSharedKeys(CavityFaces);
+		for (uint64 FaceKey : CavityFaces)
+		{
+			int32 A = (int32)(FaceKey >> 42);
+			int32 B = (int32)((FaceKey >> 21) & 0x1FFFFF);
+			int32 C = (int32)(FaceKey & 0x1FFFFF);
+			OpenTetrahedra.Add(MakeTetrahedron(Points, A, B, C, PointIndex));
+		}
+	}
+
+	ClosedTetrahedra.Append(OpenTetrahedra);
+
+	TArray<uint64> EdgeKeys;
+	EdgeKeys.Reserve(ClosedTetrahedra.Num() * 6);
+	for (const FTetrahedron& Tetrahedron : ClosedTetrahedra)
+	{
+		const int32* V = Tetrahedron.V;
+		if (V[0] >= NumPoints || V[1] >= NumPoints || V[2] >= NumPoints || V[3] >= NumPoints)
+		{
+			continue;
+		}
+		EdgeKeys.Add(MakeEdgeKey(V[0], V[1]));
+		EdgeKeys.Add(MakeEdgeKey(V[0], V[2]));
+		EdgeKeys.Add(MakeEdgeKey(V[0], V[3]));
+		EdgeKeys.Add(MakeEdgeKey(V[1], V[2]));
+		EdgeKeys.Add(MakeEdgeKey(V[1], V[3]));
+		EdgeKeys.Add(MakeEdgeKey(V[2], V[3]));
+	}
+
+	TArray<FDungeonGraphEdge> Edges;
+	AddUniqueEdges(EdgeKeys, InPoints, Edges);
+	return Edges;
+}
+
+void FDungeonGraph::AddUniqueEdges(const TArray<uint64>& EdgeKeys, const TArray<FVector>& Points, TArray<FDungeonGraphEdge>& OutEdges)
+{
+	TArray<uint64> SortedKeys = EdgeKeys;
+	SortedKeys.Sort();
+
+	OutEdges.Reserve(OutEdges.Num() + SortedKeys.Num() / 2);
+	for (int32 KeyIndex = 0; KeyIndex < SortedKeys.Num(); KeyIndex++)
+	{
+		if (KeyIndex > 0 && SortedKeys[KeyIndex] == SortedKeys[KeyIndex - 1])
+		{
+			continue;
+		}
+		int32 A = (int32)(SortedKeys[KeyIndex] >> 32);
+		int32 B = (int32)(SortedKeys[KeyIndex] & 0xFFFFFFFF);
+		OutEdges.Add(FDungeonGraphEdge(A, B, FVector::Distance(Points[A], Points[B])));
+	}
+}
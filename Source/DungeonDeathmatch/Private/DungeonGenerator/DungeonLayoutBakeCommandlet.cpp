@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonLayoutBakeCommandlet.h"
+#include "DungeonGenerator.h"
+#include "DungeonLayoutBuilder.h"
+#include "DungeonLayoutCache.h"
+
+UDungeonLayoutBakeCommandlet::UDungeonLayoutBakeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 UDungeonLayoutBakeCommandlet::Main(const FString& Params)
+{
+	FString SeedsString;
+	// Don't stop at the first comma, the whole list is the value
+	if (!FParse::Value(*Params, TEXT("Seeds="), SeedsString, false))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UDungeonLayoutBakeCommandlet::Main - Missing -Seeds=, expected a comma separated list of seeds"));
+		return 1;
+	}
+
+	TArray<FString> SeedEntries;
+	SeedsString.ParseIntoArray(SeedEntries, TEXT(","), true);
+
+	FDungeonGenerationParams BaseParams;
+	if (!ADungeonGenerator::ParseCommandletGenerationParams(Params, BaseParams))
+	{
+		return 1;
+	}
+
+	int32 NumBaked = 0;
+	int32 NumFailed = 0;
+	for (const FString& SeedEntry : SeedEntries)
+	{
+		FDungeonGenerationParams SeedParams = BaseParams;
+		SeedParams.Seed = FCString::Atoi(*SeedEntry);
+
+		double BakeStartTime = FPlatformTime::Seconds();
+		FDungeonLayoutBuilder Builder(SeedParams);
+		Builder.Build();
+		if (!FDungeonLayoutCache::Save(SeedParams, Builder.GetLayout()))
+		{
+			NumFailed++;
+			continue;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("UDungeonLayoutBakeCommandlet::Main - Baked seed %d to %s in %f seconds"), SeedParams.Seed, *FDungeonLayoutCache::GetCacheFilePath(SeedParams), FPlatformTime::Seconds() - BakeStartTime);
+		NumBaked++;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("UDungeonLayoutBakeCommandlet::Main - Baked %d layouts, %d failed"), NumBaked, NumFailed);
+	return NumFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,1064 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonLayoutBuilder.h"
+#include "DungeonCorridorRouter.h"
+#include "DungeonLayoutCache.h"
+
+/** Fraction of overall progress reached at the end of each stage */
+#define PROGRESS_ROOMS_END			0.4f
+#define PROGRESS_CONNECTIONS_END	0.5f
+#define PROGRESS_CORRIDORS_END		0.7f
+#define PROGRESS_TILES_END			1.0f
+
+#define STAGE_ROOMS			0
+#define STAGE_CONNECTIONS	1
+#define STAGE_TILES			2
+#define STAGE_CORRIDORS		3
+#define STAGE_OUTPUT		4
+#define STAGE_PLACEMENT		5
+
+/** Candidates tested around each active Poisson-disc sample before it is retired */
+#define POISSON_DISC_CANDIDATES		30
+
+/** Room sizes tried around each Poisson-disc seed, shrinking from a random size to RoomSizeMin */
+#define POISSON_DISC_FIT_ATTEMPTS	4
+
+/**
+ * Largest room volume, in cells, that uses the dense occupancy grid instead of bricks. Rooms are placed in a volume twice the room
+ * grid size, and the summed-volume table costs four bytes per cell, so this keeps it at 4 MB at most.
+ */
+#define DENSE_OCCUPANCY_MAX_CELLS	(1 << 20)
+
+namespace
+{
+	/** Compressed adjacency lists of a set of room edges. Neighbors of a room are stored in edge order as (room, edge index) pairs. */
+	struct FRoomAdjacency
+	{
+		TArray<int32> Offsets;
+		TArray<TPair<int32, int32>> Neighbors;
+
+		FRoomAdjacency(int32 NumRooms, const TArray<FDungeonGraphEdge>& Edges)
+		{
+			Offsets.SetNumZeroed(NumRooms + 1);
+			for (const FDungeonGraphEdge& Edge : Edges)
+			{
+				Offsets[Edge.A + 1]++;
+				Offsets[Edge.B + 1]++;
+			}
+			for (int32 RoomIndex = 0; RoomIndex < NumRooms; RoomIndex++)
+			{
+				Offsets[RoomIndex + 1] += Offsets[RoomIndex];
+			}
+
+			TArray<int32> Counts;
+			Counts.SetNumZeroed(NumRooms);
+			Neighbors.SetNum(Edges.Num() * 2);
+			for (int32 EdgeIndex = 0; EdgeIndex < Edges.Num(); EdgeIndex++)
+			{
+				const FDungeonGraphEdge& Edge = Edges[EdgeIndex];
+				Neighbors[Offsets[Edge.A] + Counts[Edge.A]++] = TPair<int32, int32>(Edge.B, EdgeIndex);
+				Neighbors[Offsets[Edge.B] + Counts[Edge.B]++] = TPair<int32, int32>(Edge.A, EdgeIndex);
+			}
+		}
+
+		int32 GetNumNeighbors(int32 Room) const
+		{
+			return Offsets[Room + 1] - Offsets[Room];
+		}
+	};
+
+	/**
+	 * Adds a source to a multi-source BFS distance field over the rooms. Only rooms the new source is strictly closer to are
+	 * visited, so adding every source in turn costs about as much as a single BFS from all of them, while ties stay with the
+	 * source added first.
+	 */
+	void AddDistanceSource(const FRoomAdjacency& Adjacency, int32 SourceRoom, int32 SourceIndex, TArray<int32>& Distances, TArray<int32>& Owners, TArray<int32>& Queue)
+	{
+		Queue.Reset();
+		Queue.Add(SourceRoom);
+		Distances[SourceRoom] = 0;
+		Owners[SourceRoom] = SourceIndex;
+		for (int32 QueueIndex = 0; QueueIndex < Queue.Num(); QueueIndex++)
+		{
+			const int32 Room = Queue[QueueIndex];
+			const int32 NextDistance = Distances[Room] + 1;
+			for (int32 NeighborIndex = Adjacency.Offsets[Room]; NeighborIndex < Adjacency.Offsets[Room + 1]; NeighborIndex++)
+			{
+				const int32 Neighbor = Adjacency.Neighbors[NeighborIndex].Key;
+				if (NextDistance < Distances[Neighbor])
+				{
+					Distances[Neighbor] = NextDistance;
+					Owners[Neighbor] = SourceIndex;
+					Queue.Add(Neighbor);
+				}
+			}
+		}
+	}
+
+	/** Returns the first room in RoomOrder with the greatest distance, rooms no source can reach count as furthest */
+	int32 FindFurthestRoom(const TArray<int32>& RoomOrder, const TArray<int32>& Distances)
+	{
+		int32 FurthestRoom = RoomOrder[0];
+		for (int32 Room : RoomOrder)
+		{
+			if (Distances[Room] > Distances[FurthestRoom])
+			{
+				FurthestRoom = Room;
+			}
+		}
+		return FurthestRoom;
+	}
+}
+
+/** Number of corridors routed in parallel. Must not depend on the machine, since it affects the routes. */
+#define CORRIDOR_ROUTING_WAVE_SIZE	8
+
+uint32 FDungeonLayout::GetChecksum() const
+{
+	uint32 Checksum = 0;
+	Checksum = FCrc::MemCrc32(Rooms.Locations.GetData(), Rooms.Locations.Num() * sizeof(FIntVector), Checksum);
+	Checksum = FCrc::MemCrc32(Rooms.Sizes.GetData(), Rooms.Sizes.Num() * sizeof(FIntVector), Checksum);
+	for (const FDungeonGraphEdge& Connection : Connections)
+	{
+		Checksum = FCrc::MemCrc32(&Connection.A, sizeof(int32), Checksum);
+		Checksum = FCrc::MemCrc32(&Connection.B, sizeof(int32), Checksum);
+	}
+	for (const FTileData& Tile : Tiles.GetTiles())
+	{
+		Checksum = FCrc::MemCrc32(&Tile.Coordinate, sizeof(FIntVector), Checksum);
+		Checksum = FCrc::MemCrc32(&Tile.ConnectionMask, sizeof(uint8), Checksum);
+	}
+	for (const FTileData& Tile : Corridors.GetTiles())
+	{
+		Checksum = FCrc::MemCrc32(&Tile.Coordinate, sizeof(FIntVector), Checksum);
+		Checksum = FCrc::MemCrc32(&Tile.ConnectionMask, sizeof(uint8), Checksum);
+	}
+	for (const FDungeonVerticalConnector& Connector : VerticalConnectors)
+	{
+		Checksum = FCrc::MemCrc32(&Connector.Bottom, sizeof(FIntVector), Checksum);
+		Checksum = FCrc::MemCrc32(&Connector.Height, sizeof(int32), Checksum);
+	}
+	for (const FDungeonPlacement& Placement : Placements)
+	{
+		Checksum = FCrc::MemCrc32(&Placement.Type, sizeof(EDungeonPlacementType), Checksum);
+		Checksum = FCrc::MemCrc32(&Placement.Room, sizeof(int32), Checksum);
+		Checksum = FCrc::MemCrc32(&Placement.Location, sizeof(FVector), Checksum);
+	}
+	return Checksum;
+}
+
+void FDungeonLayout::CreateRoomOutput(TArray<FDungeonRoom>& OutRooms, TArray<FDungeonConnection>& OutConnections) const
+{
+	FRandomStream GuidStream((int32)HashCombine(GetTypeHash(Seed), STAGE_OUTPUT));
+
+	OutRooms.Empty(Rooms.Num());
+	for (int32 RoomIndex = 0; RoomIndex < Rooms.Num(); RoomIndex++)
+	{
+		FDungeonRoom Room = FDungeonRoom(Rooms.Locations[RoomIndex], Rooms.Sizes[RoomIndex]);
+		uint32 A = GuidStream.GetUnsignedInt();
+		uint32 B = GuidStream.GetUnsignedInt();
+		uint32 C = GuidStream.GetUnsignedInt();
+		uint32 D = GuidStream.GetUnsignedInt();
+		Room.GUID = FGuid(A, B, C, D);
+		OutRooms.Add(Room);
+	}
+
+	OutConnections.Empty(Connections.Num());
+	for (const FDungeonGraphEdge& Connection : Connections)
+	{
+		OutConnections.Add(FDungeonConnection(OutRooms[Connection.A], OutRooms[Connection.B]));
+	}
+}
+
+FDungeonLayoutBuilder::FDungeonLayoutBuilder(const FDungeonGenerationParams& InParams)
+	: Params(InParams)
+	, RandomStream(InParams.Seed)
+{
+	RoomSizeTotal = FIntVector(0, 0, 0);
+	bUseDenseRoomOccupancy = false;
+	Layout.Seed = InParams.Seed;
+}
+
+void FDungeonLayoutBuilder::Build()
+{
+	if (Params.bGenerateRooms)
+	{
+		GenerateRooms();
+		BuildConnections();
+		PlaceSpawns();
+		if (Params.bCarveCorridors)
+		{
+			CarveCorridors();
+		}
+	}
+	if (Params.bGenerateTiles)
+	{
+		GenerateTileLayout();
+	}
+	SetProgress(PROGRESS_TILES_END);
+}
+
+void FDungeonLayoutBuilder::BuildCached()
+{
+	if (FDungeonLayoutCache::Load(Params, Layout))
+	{
+		Stats = FDungeonGenerationStats();
+		Stats.bLoadedFromCache = true;
+		SetProgress(PROGRESS_TILES_END);
+		return;
+	}
+
+	Build();
+	FDungeonLayoutCache::Save(Params, Layout);
+}
+
+void FDungeonLayoutBuilder::GenerateRooms()
+{
+	double StageStartTime = FPlatformTime::Seconds();
+	BeginStage(STAGE_ROOMS);
+	Stats.PlacementAttempts = 0;
+	Stats.FailedPlacements = 0;
+	Stats.PlacementSeeds = 0;
+	Layout.Rooms.Empty(Params.NumberOfRooms);
+	RoomSizeTotal = FIntVector(0, 0, 0);
+	Layout.RoomSizeAverage = FIntVector(0, 0, 0);
+	// Rooms are placed with their extent inside the room grid, DungeonGridSize is the unrelated tile grid
+	const FIntVector& GridSize = Params.RoomDungeonGridSize;
+	if (Params.RoomSizeMax.X > GridSize.X || Params.RoomSizeMax.Y > GridSize.Y || Params.RoomSizeMax.Z > GridSize.Z)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::GenerateRooms - Max room size exceeds room dungeon grid size, aborting"));
+		SetProgress(PROGRESS_ROOMS_END);
+		return;
+	}
+
+	// Flat or otherwise small grids use the dense grid for its O(1) summed-volume box test, tall or large ones the sparse bricks
+	const FIntVector OccupancyDimensions = GridSize * 2;
+	bUseDenseRoomOccupancy = (int64)OccupancyDimensions.X * OccupancyDimensions.Y * OccupancyDimensions.Z <= DENSE_OCCUPANCY_MAX_CELLS;
+	if (bUseDenseRoomOccupancy)
+	{
+		DenseRoomOccupancy.Init(-GridSize, OccupancyDimensions);
+	}
+	RoomOccupancy.Reset();
+
+	if (Params.RoomPlacementStrategy == ERoomPlacementStrategy::PoissonDisc)
+	{
+		GenerateRoomsAtSeeds();
+	}
+	else
+	{
+		for (int RoomIndex = 0; RoomIndex < Params.NumberOfRooms; RoomIndex++)
+		{
+			GenerateRoom();
+			SetProgress(PROGRESS_ROOMS_END * (RoomIndex + 1) / Params.NumberOfRooms);
+		}
+	}
+
+	if (Layout.Rooms.Num() > 0)
+	{
+		Layout.RoomSizeAverage = RoomSizeTotal / Layout.Rooms.Num();
+	}
+
+	Stats.RoomsTime = FPlatformTime::Seconds() - StageStartTime;
+}
+
+bool FDungeonLayoutBuilder::GenerateRoom()
+{
+	FIntVector RoomSize = GetRandomRoomSize();
+	FVector MaxRoomPoint = FVector(Params.RoomDungeonGridSize.X - RoomSize.X, Params.RoomDungeonGridSize.Y - RoomSize.Y, Params.RoomDungeonGridSize.Z - RoomSize.Z);
+
+	FIntVector RoomLocation;
+	bool LocationValid = false;
+	int PlacementAttempts = 0;
+	while (!LocationValid && PlacementAttempts < Params.MaxPlacementAttempts)
+	{
+		FVector RandomDungeonLocation = FVector(RandomStream.FRandRange(-MaxRoomPoint.X, MaxRoomPoint.X), RandomStream.FRandRange(-MaxRoomPoint.Y, MaxRoomPoint.Y), RandomStream.FRandRange(-MaxRoomPoint.Z, MaxRoomPoint.Z));
+		RoomLocation = FIntVector(RandomDungeonLocation.X, RandomDungeonLocation.Y, RandomDungeonLocation.Z);
+
+		LocationValid = IsRoomLocationFree(RoomLocation, RoomSize);
+		PlacementAttempts++;
+	}
+	Stats.PlacementAttempts += PlacementAttempts;
+
+	if (!LocationValid)
+	{
+		Stats.FailedPlacements++;
+		UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::GenerateRoom - Exceeded max room placement attempts, skipping room"));
+		return false;
+	}
+
+	AddRoom(RoomLocation, RoomSize);
+	return true;
+}
+
+void FDungeonLayoutBuilder::GenerateRoomsAtSeeds()
+{
+	TArray<FVector> RoomSeeds;
+	GeneratePoissonDiscSeeds(RoomSeeds);
+	Stats.PlacementSeeds = RoomSeeds.Num();
+
+	// Every seed is tried at most once with a fixed number of sizes, so the cost per room doesn't grow as the grid fills up
+	for (int32 SeedIndex = 0; SeedIndex < RoomSeeds.Num() && Layout.Rooms.Num() < Params.NumberOfRooms; SeedIndex++)
+	{
+		if (GenerateRoomAtSeed(RoomSeeds[SeedIndex]))
+		{
+			SetProgress(PROGRESS_ROOMS_END * Layout.Rooms.Num() / Params.NumberOfRooms);
+		}
+	}
+
+	if (Layout.Rooms.Num() < Params.NumberOfRooms)
+	{
+		Stats.FailedPlacements += Params.NumberOfRooms - Layout.Rooms.Num();
+		UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::GenerateRoomsAtSeeds - Room grid only fits %d of %d rooms with %d seeds"), Layout.Rooms.Num(), Params.NumberOfRooms, RoomSeeds.Num());
+	}
+}
+
+void FDungeonLayoutBuilder::GeneratePoissonDiscSeeds(TArray<FVector>& OutSeeds)
+{
+	OutSeeds.Reset();
+
+	// Sample in a space scaled so a padded average room is one unit along every axis, which makes the disc radius one
+	const FIntVector& GridSize = Params.RoomDungeonGridSize;
+	const FVector SeedSpacing = FVector(Params.RoomSizeMin + Params.RoomSizeMax) * 0.5f + FVector((float)Params.MinRoomDistance);
+	const FVector SampleExtent = FVector(GridSize) * 2.0f / SeedSpacing;
+
+	// Background grid with cells small enough to hold at most one sample each
+	const float CellSize = 1.0f / FMath::Sqrt(3.0f);
+	const FIntVector CellCount = FIntVector(FMath::CeilToInt(SampleExtent.X / CellSize), FMath::CeilToInt(SampleExtent.Y / CellSize), FMath::CeilToInt(SampleExtent.Z / CellSize));
+	if (CellCount.X <= 0 || CellCount.Y <= 0 || CellCount.Z <= 0)
+	{
+		return;
+	}
+
+	TArray<int32> SampleCells;
+	SampleCells.Init(INDEX_NONE, CellCount.X * CellCount.Y * CellCount.Z);
+	auto GetCell = [CellSize, &CellCount](const FVector& Sample)
+	{
+		return FIntVector(
+			FMath::Clamp(FMath::FloorToInt(Sample.X / CellSize), 0, CellCount.X - 1),
+			FMath::Clamp(FMath::FloorToInt(Sample.Y / CellSize), 0, CellCount.Y - 1),
+			FMath::Clamp(FMath::FloorToInt(Sample.Z / CellSize), 0, CellCount.Z - 1));
+	};
+
+	TArray<FVector> Samples;
+	TArray<int32> ActiveSamples;
+	auto AddSample = [&](const FVector& Sample)
+	{
+		const FIntVector Cell = GetCell(Sample);
+		SampleCells[(Cell.Z * CellCount.Y + Cell.Y) * CellCount.X + Cell.X] = Samples.Num();
+		ActiveSamples.Add(Samples.Num());
+		Samples.Add(Sample);
+	};
+
+	AddSample(FVector(RandomStream.FRandRange(0.0f, SampleExtent.X), RandomStream.FRandRange(0.0f, SampleExtent.Y), RandomStream.FRandRange(0.0f, SampleExtent.Z)));
+	while (ActiveSamples.Num() > 0)
+	{
+		const int32 ActiveIndex = RandomStream.RandRange(0, ActiveSamples.Num() - 1);
+		const FVector ActiveSample = Samples[ActiveSamples[ActiveIndex]];
+
+		bool bFoundCandidate = false;
+		for (int32 CandidateIndex = 0; CandidateIndex < POISSON_DISC_CANDIDATES && !bFoundCandidate; CandidateIndex++)
+		{
+			// Candidates lie in the shell between one and two radii around the active sample
+			const FVector Candidate = ActiveSample + RandomStream.GetUnitVector() * RandomStream.FRandRange(1.0f, 2.0f);
+			if (Candidate.X < 0.0f || Candidate.Y < 0.0f || Candidate.Z < 0.0f || Candidate.X >= SampleExtent.X || Candidate.Y >= SampleExtent.Y || Candidate.Z >= SampleExtent.Z)
+			{
+				continue;
+			}
+
+			// Samples within one radius are at most two cells away along each axis
+			const FIntVector CandidateCell = GetCell(Candidate);
+			bool bIsTooClose = false;
+			for (int32 Z = FMath::Max(CandidateCell.Z - 2, 0); Z <= FMath::Min(CandidateCell.Z + 2, CellCount.Z - 1) && !bIsTooClose; Z++)
+			{
+				for (int32 Y = FMath::Max(CandidateCell.Y - 2, 0); Y <= FMath::Min(CandidateCell.Y + 2, CellCount.Y - 1) && !bIsTooClose; Y++)
+				{
+					for (int32 X = FMath::Max(CandidateCell.X - 2, 0); X <= FMath::Min(CandidateCell.X + 2, CellCount.X - 1) && !bIsTooClose; X++)
+					{
+						const int32 SampleIndex = SampleCells[(Z * CellCount.Y + Y) * CellCount.X + X];
+						bIsTooClose = SampleIndex != INDEX_NONE && FVector::DistSquared(Samples[SampleIndex], Candidate) < 1.0f;
+					}
+				}
+			}
+
+			if (!bIsTooClose)
+			{
+				AddSample(Candidate);
+				bFoundCandidate = true;
+			}
+		}
+
+		if (!bFoundCandidate)
+		{
+			ActiveSamples.RemoveAtSwap(ActiveIndex);
+		}
+	}
+
+	// Samples grow outward from the first one, shuffle them so a partial set of rooms still covers the whole grid
+	for (int32 SampleIndex = Samples.Num() - 1; SampleIndex > 0; SampleIndex--)
+	{
+		Samples.Swap(SampleIndex, RandomStream.RandRange(0, SampleIndex));
+	}
+
+	OutSeeds.Reserve(Samples.Num());
+	for (const FVector& Sample : Samples)
+	{
+		OutSeeds.Add(Sample * SeedSpacing - FVector(GridSize));
+	}
+}
+
+bool FDungeonLayoutBuilder::GenerateRoomAtSeed(const FVector& RoomSeed)
+{
+	const FIntVector& GridSize = Params.RoomDungeonGridSize;
+	const FVector RandomRoomSize = FVector(GetRandomRoomSize());
+	for (int32 FitAttempt = 0; FitAttempt < POISSON_DISC_FIT_ATTEMPTS; FitAttempt++)
+	{
+		const float Alpha = (float)FitAttempt / (POISSON_DISC_FIT_ATTEMPTS - 1);
+		const FVector FitSize = FMath::Lerp(RandomRoomSize, FVector(Params.RoomSizeMin), Alpha);
+		const FIntVector RoomSize = FIntVector(FMath::RoundToInt(FitSize.X), FMath::RoundToInt(FitSize.Y), FMath::RoundToInt(FitSize.Z));
+
+		// Center the room on the seed, kept inside the same bounds the random strategy picks locations from
+		const FVector CenteredLocation = RoomSeed - FVector(RoomSize) * 0.5f;
+		const FIntVector RoomLocation = FIntVector(
+			FMath::Clamp(FMath::RoundToInt(CenteredLocation.X), -(GridSize.X - RoomSize.X), GridSize.X - RoomSize.X),
+			FMath::Clamp(FMath::RoundToInt(CenteredLocation.Y), -(GridSize.Y - RoomSize.Y), GridSize.Y - RoomSize.Y),
+			FMath::Clamp(FMath::RoundToInt(CenteredLocation.Z), -(GridSize.Z - RoomSize.Z), GridSize.Z - RoomSize.Z));
+
+		Stats.PlacementAttempts++;
+		if (IsRoomLocationFree(RoomLocation, RoomSize))
+		{
+			AddRoom(RoomLocation, RoomSize);
+			return true;
+		}
+
+		if (RoomSize == Params.RoomSizeMin)
+		{
+			break;
+		}
+	}
+	return false;
+}
+
+FIntVector FDungeonLayoutBuilder::GetRandomRoomSize()
+{
+	const FIntVector& RoomSizeMin = Params.RoomSizeMin;
+	const FIntVector& RoomSizeMax = Params.RoomSizeMax;
+	return FIntVector(RandomStream.RandRange(RoomSizeMin.X, RoomSizeMax.X), RandomStream.RandRange(RoomSizeMin.Y, RoomSizeMax.Y), RandomStream.RandRange(RoomSizeMin.Z, RoomSizeMax.Z));
+}
+
+bool FDungeonLayoutBuilder::IsRoomLocationFree(const FIntVector& Location, const FIntVector& Size) const
+{
+	// Test the room volume grown by the minimum room distance against everything placed so far
+	FIntVector RoomPadding = FIntVector(Params.MinRoomDistance, Params.MinRoomDistance, Params.MinRoomDistance);
+	if (bUseDenseRoomOccupancy)
+	{
+		return !DenseRoomOccupancy.IsBoxOccupied(Location - RoomPadding, Location + Size + RoomPadding);
+	}
+	return !RoomOccupancy.IsBoxOccupied(Location - RoomPadding, Location + Size + RoomPadding);
+}
+
+void FDungeonLayoutBuilder::AddRoom(const FIntVector& Location, const FIntVector& Size)
+{
+	Layout.Rooms.Add(Location, Size);
+	RoomSizeTotal += Size;
+
+	if (bUseDenseRoomOccupancy)
+	{
+		DenseRoomOccupancy.FillBox(Location, Location + Size);
+	}
+	else
+	{
+		RoomOccupancy.FillBox(Location, Location + Size);
+	}
+}
+
+void FDungeonLayoutBuilder::BuildConnections()
+{
+	const FDungeonRoomSet& Rooms = Layout.Rooms;
+	TArray<FDungeonGraphEdge>& Connections = Layout.Connections;
+	double StageStartTime = FPlatformTime::Seconds();
+	BeginStage(STAGE_CONNECTIONS);
+	Connections.Empty();
+
+	if (Rooms.Num() < 2)
+	{
+		Stats.ConnectionsTime = FPlatformTime::Seconds() - StageStartTime;
+		SetProgress(PROGRESS_CONNECTIONS_END);
+		return;
+	}
+
+	TArray<FVector> RoomCenters;
+	RoomCenters.Reserve(Rooms.Num());
+	for (int32 RoomIndex = 0; RoomIndex < Rooms.Num(); RoomIndex++)
+	{
+		RoomCenters.Add(Rooms.GetCenter(RoomIndex));
+	}
+
+	// Candidate connections come from the Delaunay graph of the room centers, which has O(n) edges and always contains the minimum spanning tree
+	bool bTetrahedralize = Params.RoomDungeonGridSize.Z > 1;
+	TArray<FDungeonGraphEdge> CandidateEdges = FDungeonGraph::Triangulate(RoomCenters, bTetrahedralize);
+
+	TArray<FDungeonGraphEdge> TreeEdges;
+	TArray<FDungeonGraphEdge> RemainingEdges;
+	int32 NumComponents = FDungeonGraph::BuildMinimumSpanningTree(Rooms.Num(), CandidateEdges, TreeEdges, RemainingEdges);
+	if (NumComponents > 1)
+	{
+		// Only happens for degenerate room layouts, fall back to the complete graph so the dungeon is still fully connected
+		UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::BuildConnections - Triangulation left %d disconnected room groups, falling back to complete graph"), NumComponents);
+		CandidateEdges = FDungeonGraph::BuildCompleteGraph(RoomCenters);
+		FDungeonGraph::BuildMinimumSpanningTree(Rooms.Num(), CandidateEdges, TreeEdges, RemainingEdges);
+	}
+
+	Connections.Append(TreeEdges);
+
+	if (Params.bAddExtraConnections)
+	{
+		AddExtraConnections(TreeEdges, RemainingEdges);
+	}
+
+	Stats.ConnectionsTime = FPlatformTime::Seconds() - StageStartTime;
+	SetProgress(PROGRESS_CONNECTIONS_END);
+}
+
+void FDungeonLayoutBuilder::AddExtraConnections(const TArray<FDungeonGraphEdge>& TreeEdges, const TArray<FDungeonGraphEdge>& RemainingEdges)
+{
+	const int32 NumRooms = Layout.Rooms.Num();
+	const int32 AdditionalConnections = Params.NumberOfRooms * Params.AdditionalConnectionsRatio;
+	const int32 MaxRoomConnections = Params.MaxRoomConnections > 0 ? Params.MaxRoomConnections : MAX_int32;
+	if (AdditionalConnections <= 0 || RemainingEdges.Num() == 0)
+	{
+		return;
+	}
+
+	FRoomAdjacency TreeAdjacency(NumRooms, TreeEdges);
+	// Remaining edges are sorted by weight, so every room's candidate list comes out sorted as well
+	FRoomAdjacency CandidateAdjacency(NumRooms, RemainingEdges);
+
+	TArray<int32> RoomConnections;
+	RoomConnections.SetNumZeroed(NumRooms);
+	for (const FDungeonGraphEdge& Edge : TreeEdges)
+	{
+		RoomConnections[Edge.A]++;
+		RoomConnections[Edge.B]++;
+	}
+
+	// Next candidate to look at for every room. Candidates before it were used or rejected, and rejections never become valid
+	// again since connection counts only grow and the tree doesn't change.
+	TArray<int32> CandidateCursors;
+	CandidateCursors.SetNumZeroed(NumRooms);
+	TArray<bool> UsedEdges;
+	UsedEdges.Init(false, RemainingEdges.Num());
+
+	TArray<int32> OpenRooms;
+	OpenRooms.Reserve(NumRooms);
+	for (int32 RoomIndex = 0; RoomIndex < NumRooms; RoomIndex++)
+	{
+		if (CandidateAdjacency.GetNumNeighbors(RoomIndex) > 0)
+		{
+			OpenRooms.Add(RoomIndex);
+		}
+	}
+
+	TArray<int32> VisitStamps;
+	VisitStamps.SetNumZeroed(NumRooms);
+	int32 VisitStamp = 0;
+	TArray<TPair<int32, int32>> SearchQueue;
+	SearchQueue.Reserve(NumRooms);
+
+	// Returns true if To can be reached from From in at most MaxHops tree edges, visiting only rooms within that range
+	auto IsWithinTreeHops = [&](int32 From, int32 To, int32 MaxHops)
+	{
+		VisitStamp++;
+		SearchQueue.Reset();
+		SearchQueue.Add(TPair<int32, int32>(From, 0));
+		VisitStamps[From] = VisitStamp;
+		for (int32 QueueIndex = 0; QueueIndex < SearchQueue.Num(); QueueIndex++)
+		{
+			const int32 Room = SearchQueue[QueueIndex].Key;
+			const int32 Hops = SearchQueue[QueueIndex].Value;
+			if (Room == To)
+			{
+				return true;
+			}
+			if (Hops == MaxHops)
+			{
+				continue;
+			}
+			for (int32 NeighborIndex = TreeAdjacency.Offsets[Room]; NeighborIndex < TreeAdjacency.Offsets[Room + 1]; NeighborIndex++)
+			{
+				const int32 Neighbor = TreeAdjacency.Neighbors[NeighborIndex].Key;
+				if (VisitStamps[Neighbor] != VisitStamp)
+				{
+					VisitStamps[Neighbor] = VisitStamp;
+					SearchQueue.Add(TPair<int32, int32>(Neighbor, Hops + 1));
+				}
+			}
+		}
+		return false;
+	};
+
+	int32 AddedConnections = 0;
+	while (AddedConnections < AdditionalConnections && OpenRooms.Num() > 0)
+	{
+		const int32 OpenIndex = RandomStream.RandRange(0, OpenRooms.Num() - 1);
+		const int32 RoomIndex = OpenRooms[OpenIndex];
+
+		int32& Cursor = CandidateCursors[RoomIndex];
+		const int32 NumCandidates = CandidateAdjacency.GetNumNeighbors(RoomIndex);
+		bool bAddedConnection = false;
+		while (RoomConnections[RoomIndex] < MaxRoomConnections && Cursor < NumCandidates && !bAddedConnection)
+		{
+			const TPair<int32, int32>& Candidate = CandidateAdjacency.Neighbors[CandidateAdjacency.Offsets[RoomIndex] + Cursor++];
+			const int32 OtherRoom = Candidate.Key;
+			const int32 EdgeIndex = Candidate.Value;
+			if (UsedEdges[EdgeIndex] || RoomConnections[OtherRoom] >= MaxRoomConnections)
+			{
+				continue;
+			}
+
+			// The new edge closes a loop through the tree path between its rooms, one room longer than the path
+			if (Params.MaxLoopLength > 0 && !IsWithinTreeHops(RoomIndex, OtherRoom, Params.MaxLoopLength - 1))
+			{
+				continue;
+			}
+
+			UsedEdges[EdgeIndex] = true;
+			Layout.Connections.Add(RemainingEdges[EdgeIndex]);
+			RoomConnections[RoomIndex]++;
+			RoomConnections[OtherRoom]++;
+			AddedConnections++;
+			bAddedConnection = true;
+		}
+
+		if (RoomConnections[RoomIndex] >= MaxRoomConnections || Cursor >= NumCandidates)
+		{
+			OpenRooms.RemoveAtSwap(OpenIndex);
+		}
+	}
+}
+
+void FDungeonLayoutBuilder::PlaceSpawns()
+{
+	const int32 NumRooms = Layout.Rooms.Num();
+	double StageStartTime = FPlatformTime::Seconds();
+	BeginStage(STAGE_PLACEMENT);
+	Layout.Placements.Empty();
+
+	if (NumRooms == 0 || Params.NumPlayerStarts <= 0)
+	{
+		Stats.SpawnsTime = FPlatformTime::Seconds() - StageStartTime;
+		return;
+	}
+
+	const int32 NumPlayerStarts = FMath::Min(Params.NumPlayerStarts, NumRooms);
+	if (NumPlayerStarts < Params.NumPlayerStarts)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::PlaceSpawns - Only %d rooms for %d player starts, placing one player start per room"), NumRooms, Params.NumPlayerStarts);
+	}
+
+	FRoomAdjacency Adjacency(NumRooms, Layout.Connections);
+
+	// Rooms in random order, so ties between equally distant rooms are broken at random
+	TArray<int32> RoomOrder;
+	RoomOrder.SetNum(NumRooms);
+	for (int32 RoomIndex = 0; RoomIndex < NumRooms; RoomIndex++)
+	{
+		RoomOrder[RoomIndex] = RoomIndex;
+	}
+	for (int32 OrderIndex = NumRooms - 1; OrderIndex > 0; OrderIndex--)
+	{
+		RoomOrder.Swap(OrderIndex, RandomStream.RandRange(0, OrderIndex));
+	}
+
+	TArray<int32> Distances;
+	TArray<int32> Owners;
+	TArray<int32> Queue;
+	Queue.Reserve(NumRooms);
+
+	// The first player start goes to the room furthest from a random room, which lies on the edge of the room graph
+	Distances.Init(MAX_int32, NumRooms);
+	Owners.Init(INDEX_NONE, NumRooms);
+	AddDistanceSource(Adjacency, RoomOrder[0], 0, Distances, Owners, Queue);
+	TArray<int32> StartRooms;
+	StartRooms.Add(FindFurthestRoom(RoomOrder, Distances));
+
+	// Farthest point sampling, every further player start goes to the room furthest from all player starts placed so far
+	Distances.Init(MAX_int32, NumRooms);
+	Owners.Init(INDEX_NONE, NumRooms);
+	AddDistanceSource(Adjacency, StartRooms[0], 0, Distances, Owners, Queue);
+	while (StartRooms.Num() < NumPlayerStarts)
+	{
+		const int32 StartRoom = FindFurthestRoom(RoomOrder, Distances);
+		AddDistanceSource(Adjacency, StartRoom, StartRooms.Num(), Distances, Owners, Queue);
+		StartRooms.Add(StartRoom);
+	}
+
+	// Counting sort of the rooms by distance, keeping the random order within a distance. Rooms no player start can reach are left out.
+	int32 MaxDistance = 0;
+	for (int32 RoomIndex = 0; RoomIndex < NumRooms; RoomIndex++)
+	{
+		if (Owners[RoomIndex] != INDEX_NONE)
+		{
+			MaxDistance = FMath::Max(MaxDistance, Distances[RoomIndex]);
+		}
+	}
+	TArray<int32> DistanceOffsets;
+	DistanceOffsets.SetNumZeroed(MaxDistance + 2);
+	for (int32 RoomIndex = 0; RoomIndex < NumRooms; RoomIndex++)
+	{
+		if (Owners[RoomIndex] != INDEX_NONE)
+		{
+			DistanceOffsets[Distances[RoomIndex] + 1]++;
+		}
+	}
+	for (int32 Distance = 0; Distance <= MaxDistance; Distance++)
+	{
+		DistanceOffsets[Distance + 1] += DistanceOffsets[Distance];
+	}
+	TArray<int32> SortedRooms;
+	SortedRooms.SetNum(DistanceOffsets[MaxDistance + 1]);
+	for (int32 Room : RoomOrder)
+	{
+		if (Owners[Room] != INDEX_NONE)
+		{
+			SortedRooms[DistanceOffsets[Distances[Room]]++] = Room;
+		}
+	}
+
+	TArray<TArray<int32>> OwnedRooms;
+	OwnedRooms.SetNum(NumPlayerStarts);
+	for (int32 Room : SortedRooms)
+	{
+		OwnedRooms[Owners[Room]].Add(Room);
+	}
+
+	TArray<TArray<FIntVector>> UsedRoomCells;
+	UsedRoomCells.SetNum(NumRooms);
+	Layout.Placements.Reserve(NumPlayerStarts + FMath::Max(Params.NumChests, 0) + FMath::Max(Params.NumAISpawns, 0));
+	for (int32 StartRoom : StartRooms)
+	{
+		Layout.Placements.Add(MakePlacement(EDungeonPlacementType::PlayerStart, StartRoom, UsedRoomCells));
+	}
+
+	// Chests are handed out to the player starts in turn, each taking its nearest room without a chest that is far enough away.
+	// The player start going first rotates every round, so the ones left without a chest in the last round are spread out.
+	TArray<int32> Cursors;
+	Cursors.SetNumZeroed(NumPlayerStarts);
+	int32 NumChests = 0;
+	for (int32 Round = 0; NumChests < Params.NumChests; Round++)
+	{
+		bool bPlacedChest = false;
+		for (int32 Turn = 0; Turn < NumPlayerStarts && NumChests < Params.NumChests; Turn++)
+		{
+			const int32 Owner = (Round + Turn) % NumPlayerStarts;
+			const TArray<int32>& Rooms = OwnedRooms[Owner];
+			int32& Cursor = Cursors[Owner];
+			while (Cursor < Rooms.Num() && Distances[Rooms[Cursor]] < Params.MinChestDistance)
+			{
+				Cursor++;
+			}
+			if (Cursor < Rooms.Num())
+			{
+				Layout.Placements.Add(MakePlacement(EDungeonPlacementType::Chest, Rooms[Cursor++], UsedRoomCells));
+				NumChests++;
+				bPlacedChest = true;
+			}
+		}
+		if (!bPlacedChest)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::PlaceSpawns - Only %d rooms far enough away from the player starts for %d chests"), NumChests, Params.NumChests);
+			break;
+		}
+	}
+
+	// AI spawns are handed out the same way, starting from the rooms furthest from their player start
+	for (int32 Owner = 0; Owner < NumPlayerStarts; Owner++)
+	{
+		Cursors[Owner] = OwnedRooms[Owner].Num() - 1;
+	}
+	int32 NumAISpawns = 0;
+	for (int32 Round = 0; NumAISpawns < Params.NumAISpawns; Round++)
+	{
+		bool bPlacedSpawn = false;
+		for (int32 Turn = 0; Turn < NumPlayerStarts && NumAISpawns < Params.NumAISpawns; Turn++)
+		{
+			const int32 Owner = (Round + Turn) % NumPlayerStarts;
+			int32& Cursor = Cursors[Owner];
+			// Player start rooms are always first in their list, so AI never spawns next to a player
+			if (Cursor > 0)
+			{
+				Layout.Placements.Add(MakePlacement(EDungeonPlacementType::AISpawn, OwnedRooms[Owner][Cursor--], UsedRoomCells));
+				NumAISpawns++;
+				bPlacedSpawn = true;
+			}
+		}
+		if (!bPlacedSpawn)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::PlaceSpawns - Only %d rooms without a player start for %d AI spawns"), NumAISpawns, Params.NumAISpawns);
+			break;
+		}
+	}
+
+	// Owners and distances are only final once every player start is placed
+	for (FDungeonPlacement& Placement : Layout.Placements)
+	{
+		Placement.Owner = Owners[Placement.Room];
+		Placement.Distance = Distances[Placement.Room];
+	}
+
+	Stats.SpawnsTime = FPlatformTime::Seconds() - StageStartTime;
+}
+
+FDungeonPlacement FDungeonLayoutBuilder::MakePlacement(EDungeonPlacementType Type, int32 Room, TArray<TArray<FIntVector>>& UsedRoomCells)
+{
+	const FIntVector& Location = Layout.Rooms.Locations[Room];
+	const FIntVector& Size = Layout.Rooms.Sizes[Room];
+	TArray<FIntVector>& UsedCells = UsedRoomCells[Room];
+
+	FIntVector Cell = Location + FIntVector(Size.X / 2, Size.Y / 2, 0);
+	const int32 NumFloorCells = Size.X * Size.Y;
+	if (Type != EDungeonPlacementType::PlayerStart || UsedCells.Contains(Cell))
+	{
+		// Scan on from a random floor cell to the first free one. Rooms with every floor cell used stack placements on the random cell.
+		const int32 FirstCellIndex = RandomStream.RandRange(0, NumFloorCells - 1);
+		for (int32 Step = 0; Step < NumFloorCells; Step++)
+		{
+			const int32 CellIndex = (FirstCellIndex + Step) % NumFloorCells;
+			Cell = Location + FIntVector(CellIndex % Size.X, CellIndex / Size.X, 0);
+			if (!UsedCells.Contains(Cell))
+			{
+				break;
+			}
+		}
+	}
+	UsedCells.Add(Cell);
+
+	FDungeonPlacement Placement;
+	Placement.Type = Type;
+	Placement.Room = Room;
+	Placement.Location = FVector(Cell.X + 0.5f, Cell.Y + 0.5f, Cell.Z);
+	Placement.Yaw = RandomStream.RandRange(0, 3) * 90.0f;
+	return Placement;
+}
+
+void FDungeonLayoutBuilder::CarveCorridors()
+{
+	FDungeonTileGraph& Corridors = Layout.Corridors;
+	double StageStartTime = FPlatformTime::Seconds();
+	BeginStage(STAGE_CORRIDORS);
+	Corridors.Empty();
+	Layout.VerticalConnectors.Empty();
+
+	FDungeonCorridorRouter Router;
+	// Room locations are picked in [-(GridSize - RoomSize), GridSize - RoomSize], so rooms and corridors span [-GridSize, GridSize)
+	const FIntVector& GridSize = Params.RoomDungeonGridSize;
+	Router.Init(FIntVector(-GridSize.X, -GridSize.Y, -GridSize.Z), GridSize * 2, Layout.Rooms, Params.CorridorReuseCost, Params.CorridorVerticalCost);
+
+	TArray<TArray<FIntVector>> Paths;
+	Router.RouteConnections(Layout.Connections, CORRIDOR_ROUTING_WAVE_SIZE, Paths);
+
+	for (const TArray<FIntVector>& Path : Paths)
+	{
+		int32 PreviousIndex = INDEX_NONE;
+		for (int32 PathIndex = 0; PathIndex < Path.Num(); PathIndex++)
+		{
+			const FIntVector& Cell = Path[PathIndex];
+			int32 TileIndex = INDEX_NONE;
+			if (Router.GetRoomAt(Cell) == INDEX_NONE)
+			{
+				TileIndex = Corridors.FindIndex(Cell);
+				if (TileIndex == INDEX_NONE)
+				{
+					FTileData Tile;
+					Tile.GUID = NewGuid();
+					Tile.Coordinate = Cell;
+					TileIndex = Corridors.Add(Tile);
+				}
+			}
+
+			// Vertical steps don't have a connection bit, so only horizontal steps connect tiles
+			ECardinalDirection Direction;
+			if (PathIndex > 0 && FDungeonTileGraph::GetDirectionFromOffset(Cell - Path[PathIndex - 1], Direction))
+			{
+				if (PreviousIndex != INDEX_NONE && TileIndex != INDEX_NONE)
+				{
+					Corridors.Connect(PreviousIndex, Direction, TileIndex);
+				}
+				else if (PreviousIndex != INDEX_NONE)
+				{
+					// Corridor entering a room, leave the tile open towards the room as a doorway
+					Corridors[PreviousIndex].SetConnected(Direction, true);
+				}
+				else if (TileIndex != INDEX_NONE)
+				{
+					Corridors[TileIndex].SetConnected(FDungeonTileGraph::GetOppositeDirection(Direction), true);
+				}
+			}
+			PreviousIndex = TileIndex;
+		}
+	}
+
+	BuildVerticalConnectors(Paths);
+	Layout.PortalGraph.Build(Layout.Rooms, Corridors);
+
+	Stats.CorridorsTime = FPlatformTime::Seconds() - StageStartTime;
+	Stats.ReroutedCorridors = Router.GetNumRerouted();
+	Stats.FailedCorridors = Router.GetNumFailed();
+	if (Stats.FailedCorridors > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::CarveCorridors - Found no route for %d of %d connections"), Stats.FailedCorridors, Layout.Connections.Num());
+	}
+	SetProgress(PROGRESS_CORRIDORS_END);
+}
+
+void FDungeonLayoutBuilder::BuildVerticalConnectors(const TArray<TArray<FIntVector>>& Paths)
+{
+	// Merged corridors share vertical steps, so steps are collected by their lower cell first and joined into runs afterwards
+	TSet<FIntVector> StepSet;
+	for (const TArray<FIntVector>& Path : Paths)
+	{
+		for (int32 PathIndex = 1; PathIndex < Path.Num(); PathIndex++)
+		{
+			const FIntVector& From = Path[PathIndex - 1];
+			const FIntVector& To = Path[PathIndex];
+			if (From.Z != To.Z)
+			{
+				StepSet.Add(From.Z < To.Z ? From : To);
+			}
+		}
+	}
+
+	TArray<FIntVector> Steps = StepSet.Array();
+	Steps.Sort([](const FIntVector& A, const FIntVector& B)
+	{
+		if (A.X != B.X)
+		{
+			return A.X < B.X;
+		}
+		return A.Y != B.Y ? A.Y < B.Y : A.Z < B.Z;
+	});
+
+	for (int32 StepIndex = 0; StepIndex < Steps.Num();)
+	{
+		FDungeonVerticalConnector Connector;
+		Connector.Bottom = Steps[StepIndex];
+		Connector.Height = 1;
+		while (++StepIndex < Steps.Num() && Steps[StepIndex] == Connector.Bottom + FIntVector(0, 0, Connector.Height))
+		{
+			Connector.Height++;
+		}
+		Connector.Type = Connector.Height <= Params.MaxStairsHeight ? EVerticalConnectorType::Stairs : EVerticalConnectorType::Shaft;
+
+		// Face the first side the corridor continues from at the top. Paths only step vertically between corridor cells, so the top
+		// is always a corridor tile.
+		const int32 TopIndex = Layout.Corridors.FindIndex(Connector.Bottom + FIntVector(0, 0, Connector.Height));
+		for (uint8 DirectionIndex = 0; DirectionIndex < 4 && TopIndex != INDEX_NONE; DirectionIndex++)
+		{
+			if (Layout.Corridors[TopIndex].IsConnected((ECardinalDirection)DirectionIndex))
+			{
+				Connector.ExitDirection = (ECardinalDirection)DirectionIndex;
+				break;
+			}
+		}
+		Layout.VerticalConnectors.Add(Connector);
+	}
+}
+
+void FDungeonLayoutBuilder::GenerateTileLayout()
+{
+	FDungeonTileGraph& Tiles = Layout.Tiles;
+	const FIntVector& DungeonGridSize = Params.DungeonGridSize;
+	double StageStartTime = FPlatformTime::Seconds();
+	BeginStage(STAGE_TILES);
+	Tiles.Empty(Params.NumberOfTiles);
+
+	FTileData OriginTile = FTileData();
+	OriginTile.GUID = NewGuid();
+	OriginTile.Coordinate = FIntVector(DungeonGridSize.X / 2, DungeonGridSize.Y / 2, DungeonGridSize.Z / 2);
+
+	// Indices of the tiles to grow from, consumed from QueueHead so the array never has to shift
+	TArray<int32> TileQueue;
+	TileQueue.Reserve(Params.NumberOfTiles * 2);
+	TileQueue.Add(Tiles.Add(OriginTile));
+	int32 QueueHead = 0;
+	int32 FailedConnections = 0;
+
+	while (Tiles.Num() < Params.NumberOfTiles)
+	{
+		if (QueueHead >= TileQueue.Num())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::GenerateTileLayout - Ran out of tiles to grow from"));
+			break;
+		}
+
+		const int32 ActiveTileIndex = TileQueue[QueueHead++];
+		const FIntVector ActiveTileLocation = Tiles[ActiveTileIndex].Coordinate;
+
+		ECardinalDirection AvailableConnectionDirections[4];
+		int32 NumAvailableConnectionDirections = 0;
+		for (uint8 DirectionIndex = 0; DirectionIndex < 4; DirectionIndex++)
+		{
+			ECardinalDirection Direction = (ECardinalDirection)DirectionIndex;
+			FIntVector NeighborLocation = ActiveTileLocation + FDungeonTileGraph::GetDirectionOffset(Direction);
+			bool IsOutsideOfGrid = NeighborLocation.X < 0 || NeighborLocation.Y < 0 || NeighborLocation.X >= DungeonGridSize.X || NeighborLocation.Y >= DungeonGridSize.Y;
+			if (IsOutsideOfGrid)
+			{
+				continue;
+			}
+
+			int32 NeighborIndex = Tiles.FindIndex(NeighborLocation);
+			if (NeighborIndex != INDEX_NONE)
+			{
+				// Adjacent tiles are always connected, on both sides so their meshes line up
+				Tiles.Connect(ActiveTileIndex, Direction, NeighborIndex);
+				continue;
+			}
+			AvailableConnectionDirections[NumAvailableConnectionDirections++] = Direction;
+		}
+
+		if (NumAvailableConnectionDirections > 0)
+		{
+			ECardinalDirection NewTileDirection = AvailableConnectionDirections[RandomStream.RandRange(0, NumAvailableConnectionDirections - 1)];
+			FTileData NewTile;
+			NewTile.GUID = NewGuid();
+			NewTile.Coordinate = ActiveTileLocation + FDungeonTileGraph::GetDirectionOffset(NewTileDirection);
+
+			int32 NewTileIndex = Tiles.Add(NewTile);
+			Tiles.Connect(ActiveTileIndex, NewTileDirection, NewTileIndex);
+
+			TileQueue.Add(NewTileIndex);
+			TileQueue.Add(ActiveTileIndex);
+
+			if ((Tiles.Num() & 1023) == 0)
+			{
+				SetProgress(PROGRESS_CORRIDORS_END + (PROGRESS_TILES_END - PROGRESS_CORRIDORS_END) * Tiles.Num() / Params.NumberOfTiles);
+			}
+		}
+		else
+		{
+			FailedConnections++;
+		}
+	}
+	UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutBuilder::GenerateTileLayout - Generated %d tiles, %d tiles had no free neighbor to grow into"), Tiles.Num(), FailedConnections);
+
+	Stats.TilesTime = FPlatformTime::Seconds() - StageStartTime;
+	SetProgress(PROGRESS_TILES_END);
+}
+
+void FDungeonLayoutBuilder::BeginStage(uint32 StageIndex)
+{
+	RandomStream.Initialize((int32)HashCombine(GetTypeHash(Params.Seed), StageIndex));
+}
+
+FGuid FDungeonLayoutBuilder::NewGuid()
+{
+	uint32 A = RandomStream.GetUnsignedInt();
+	uint32 B = RandomStream.GetUnsignedInt();
+	uint32 C = RandomStream.GetUnsignedInt();
+	uint32 D = RandomStream.GetUnsignedInt();
+	return FGuid(A, B, C, D);
+}
+
+void FDungeonLayoutBuilder::SetProgress(float Progress)
+{
+	ProgressPermille.Set(FMath::Clamp(FMath::RoundToInt(Progress * 1000.0f), 0, 1000));
+}
@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonLayoutCache.h"
+#include "DungeonLayoutBuilder.h"
+
+#include <HAL/FileManager.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+#include <Serialization/MemoryReader.h>
+#include <Serialization/MemoryWriter.h>
+
+#define DUNGEON_LAYOUT_CACHE_MAGIC		0x59414C44
+
+/** Must be bumped whenever the file format or the output of the layout builder changes, so stale layouts are rebuilt */
+#define DUNGEON_LAYOUT_CACHE_VERSION	3
+
+bool FDungeonLayoutCache::Load(const FDungeonGenerationParams& Params, FDungeonLayout& OutLayout)
+{
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *GetCacheFilePath(Params), FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	// The whole header has to match, which rejects other versions as well as hash collisions between different params
+	const TArray<uint8> Header = MakeHeader(Params);
+	if (FileData.Num() < Header.Num() || FMemory::Memcmp(FileData.GetData(), Header.GetData(), Header.Num()) != 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("FDungeonLayoutCache::Load - Ignoring outdated layout cache file for seed %d"), Params.Seed);
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	Reader.Seek(Header.Num());
+	uint32 Checksum = 0;
+	Reader << Checksum;
+
+	FDungeonLayout Layout;
+	SerializeLayout(Reader, Layout);
+	if (Reader.IsError() || Layout.GetChecksum() != Checksum)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutCache::Load - Layout cache file for seed %d is damaged, ignoring it"), Params.Seed);
+		return false;
+	}
+
+	// The portal graph is derived from the rooms and corridors, so it is rebuilt instead of stored
+	if (Params.bGenerateRooms && Params.bCarveCorridors)
+	{
+		Layout.PortalGraph.Build(Layout.Rooms, Layout.Corridors);
+	}
+
+	OutLayout = MoveTemp(Layout);
+	return true;
+}
+
+bool FDungeonLayoutCache::Save(const FDungeonGenerationParams& Params, const FDungeonLayout& Layout)
+{
+	TArray<uint8> FileData = MakeHeader(Params);
+	FMemoryWriter Writer(FileData);
+	Writer.Seek(FileData.Num());
+
+	uint32 Checksum = Layout.GetChecksum();
+	Writer << Checksum;
+	// Saving archives only read from the layout
+	SerializeLayout(Writer, const_cast<FDungeonLayout&>(Layout));
+
+	// Write to a temporary file first, so a generator reading the cache never sees a partially written layout. The temporary file
+	// is unique, since several editor instances can save the same layout at once.
+	const FString FilePath = GetCacheFilePath(Params);
+	const FString TempFilePath = FString::Printf(TEXT("%s.%s.tmp"), *FilePath, *FGuid::NewGuid().ToString());
+	if (!FFileHelper::SaveArrayToFile(FileData, *TempFilePath) || !IFileManager::Get().Move(*FilePath, *TempFilePath, true, true))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FDungeonLayoutCache::Save - Failed to write layout cache file %s"), *FilePath);
+		IFileManager::Get().Delete(*TempFilePath, false, false, true);
+		return false;
+	}
+	return true;
+}
+
+FString FDungeonLayoutCache::GetCacheFilePath(const FDungeonGenerationParams& Params)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("DungeonLayouts"), FString::Printf(TEXT("%d_%08x.layout"), Params.Seed, GetParamsHash(Params)));
+}
+
+void FDungeonLayoutCache::SerializeLayout(FArchive& Ar, FDungeonLayout& Layout)
+{
+	Ar << Layout.Seed;
+	Ar << Layout.RoomSizeAverage;
+	Ar << Layout.Rooms.Locations;
+	Ar << Layout.Rooms.Sizes;
+	if (Layout.Rooms.Locations.Num() != Layout.Rooms.Sizes.Num())
+	{
+		Ar.SetError();
+		return;
+	}
+
+	int32 NumConnections = Layout.Connections.Num();
+	Ar << NumConnections;
+	if (Ar.IsLoading())
+	{
+		if (NumConnections < 0 || Ar.IsError())
+		{
+			Ar.SetError();
+			return;
+		}
+		Layout.Connections.SetNum(NumConnections);
+	}
+	for (FDungeonGraphEdge& Connection : Layout.Connections)
+	{
+		Ar << Connection.A;
+		Ar << Connection.B;
+		Ar << Connection.Weight;
+	}
+
+	SerializeTileGraph(Ar, Layout.Tiles);
+	SerializeTileGraph(Ar, Layout.Corridors);
+
+	int32 NumVerticalConnectors = Layout.VerticalConnectors.Num();
+	Ar << NumVerticalConnectors;
+	if (Ar.IsLoading())
+	{
+		if (NumVerticalConnectors < 0 || Ar.IsError())
+		{
+			Ar.SetError();
+			return;
+		}
+		Layout.VerticalConnectors.SetNum(NumVerticalConnectors);
+	}
+	for (FDungeonVerticalConnector& Connector : Layout.VerticalConnectors)
+	{
+		uint8 Type = (uint8)Connector.Type;
+		uint8 ExitDirection = (uint8)Connector.ExitDirection;
+		Ar << Connector.Bottom;
+		Ar << Connector.Height;
+		Ar << Type;
+		Ar << ExitDirection;
+		Connector.Type = (EVerticalConnectorType)Type;
+		Connector.ExitDirection = (ECardinalDirection)ExitDirection;
+	}
+
+	int32 NumPlacements = Layout.Placements.Num();
+	Ar << NumPlacements;
+	if (Ar.IsLoading())
+	{
+		if (NumPlacements < 0 || Ar.IsError())
+		{
+			Ar.SetError();
+			return;
+		}
+		Layout.Placements.SetNum(NumPlacements);
+	}
+	for (FDungeonPlacement& Placement : Layout.Placements)
+	{
+		uint8 Type = (uint8)Placement.Type;
+		Ar << Type;
+		Ar << Placement.Room;
+		Ar << Placement.Location;
+		Ar << Placement.Yaw;
+		Ar << Placement.Owner;
+		Ar << Placement.Distance;
+		Placement.Type = (EDungeonPlacementType)Type;
+	}
+}
+
+void FDungeonLayoutCache::SerializeParams(FArchive& Ar, FDungeonGenerationParams& Params)
+{
+	uint8 RoomPlacementStrategy = (uint8)Params.RoomPlacementStrategy;
+
+	Ar << Params.Seed;
+	Ar << Params.RoomDungeonGridSize;
+	Ar << Params.NumberOfRooms;
+	Ar << Params.RoomSizeMin;
+	Ar << Params.RoomSizeMax;
+	Ar << Params.MinRoomDistance;
+	Ar << RoomPlacementStrategy;
+	Ar << Params.MaxPlacementAttempts;
+	Ar << Params.bAddExtraConnections;
+	Ar << Params.AdditionalConnectionsRatio;
+	Ar << Params.MaxRoomConnections;
+	Ar << Params.MaxLoopLength;
+	Ar << Params.bCarveCorridors;
+	Ar << Params.CorridorReuseCost;
+	Ar << Params.CorridorVerticalCost;
+	Ar << Params.MaxStairsHeight;
+	Ar << Params.NumPlayerStarts;
+	Ar << Params.NumChests;
+	Ar << Params.MinChestDistance;
+	Ar << Params.NumAISpawns;
+	Ar << Params.DungeonGridSize;
+	Ar << Params.NumberOfTiles;
+	Ar << Params.bGenerateRooms;
+	Ar << Params.bGenerateTiles;
+
+	Params.RoomPlacementStrategy = (ERoomPlacementStrategy)RoomPlacementStrategy;
+}
+
+void FDungeonLayoutCache::SerializeTileGraph(FArchive& Ar, FDungeonTileGraph& TileGraph)
+{
+	int32 NumTiles = TileGraph.Num();
+	Ar << NumTiles;
+	if (Ar.IsSaving())
+	{
+		for (FTileData& Tile : TileGraph.GetTiles())
+		{
+			uint8 Type = (uint8)Tile.Type;
+			Ar << Tile.GUID;
+			Ar << Type;
+			Ar << Tile.Coordinate;
+			Ar << Tile.ConnectionMask;
+		}
+		return;
+	}
+
+	if (NumTiles < 0 || Ar.IsError())
+	{
+		Ar.SetError();
+		return;
+	}
+
+	TileGraph.Empty(NumTiles);
+	for (int32 TileIndex = 0; TileIndex < NumTiles && !Ar.IsError(); TileIndex++)
+	{
+		FTileData Tile;
+		uint8 Type = 0;
+		Ar << Tile.GUID;
+		Ar << Type;
+		Ar << Tile.Coordinate;
+		Ar << Tile.ConnectionMask;
+		Tile.Type = (ETileType)Type;
+		if (TileGraph.Add(Tile) == INDEX_NONE)
+		{
+			Ar.SetError();
+		}
+	}
+}
+
+TArray<uint8> FDungeonLayoutCache::MakeHeader(const FDungeonGenerationParams& Params)
+{
+	TArray<uint8> Header;
+	FMemoryWriter Writer(Header);
+	uint32 Magic = DUNGEON_LAYOUT_CACHE_MAGIC;
+	int32 Version = DUNGEON_LAYOUT_CACHE_VERSION;
+	Writer << Magic;
+	Writer << Version;
+	FDungeonGenerationParams HeaderParams = Params;
+	SerializeParams(Writer, HeaderParams);
+	return Header;
+}
+
+uint32 FDungeonLayoutCache::GetParamsHash(const FDungeonGenerationParams& Params)
+{
+	const TArray<uint8> Header = MakeHeader(Params);
+	return FCrc::MemCrc32(Header.GetData(), Header.Num());
+}
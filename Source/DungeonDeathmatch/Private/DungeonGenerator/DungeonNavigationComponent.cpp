@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonNavigationComponent.h"
+
+#include <NavigationSystem.h>
+#include <Components/PrimitiveComponent.h>
+#include <GameFramework/Actor.h>
+
+// Sets default values for this component's properties
+UDungeonNavigationComponent::UDungeonNavigationComponent()
+{
+	// Only ticks while waiting for the navmesh of a spawned dungeon
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	bDeferNavigationUpdates = true;
+
+	NumReleasedRegions = 0;
+	bIsDeferring = false;
+	bIsWaitingForNavigation = false;
+	FirstReleaseTime = 0.0;
+	LastReleaseFrame = 0;
+}
+
+void UDungeonNavigationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Released components only reach the navmesh's dirty areas on the navigation system's next tick
+	if (!bIsWaitingForNavigation || GFrameCounter <= LastReleaseFrame)
+	{
+		return;
+	}
+
+	UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (NavigationSystem && NavigationSystem->IsNavigationBuildInProgress())
+	{
+		return;
+	}
+
+	bIsWaitingForNavigation = false;
+	SetComponentTickEnabled(false);
+
+	const float BuildTime = FPlatformTime::Seconds() - FirstReleaseTime;
+	UE_LOG(LogTemp, Log, TEXT("UDungeonNavigationComponent::TickComponent - Navigation of %d regions built in %f seconds"), RegionComponents.Num(), BuildTime);
+	OnNavigationReady.Broadcast(BuildTime);
+}
+
+void UDungeonNavigationComponent::BeginDeferredUpdates(int32 NumRegions)
+{
+	Reset();
+
+	UWorld* World = GetWorld();
+	bIsDeferring = bDeferNavigationUpdates && World && World->IsGameWorld() && FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	if (!bIsDeferring)
+	{
+		return;
+	}
+
+	RegionComponents.SetNum(NumRegions + 1);
+	RegionPendingTiles.Init(0, NumRegions + 1);
+	NumReleasedRegions = 0;
+}
+
+void UDungeonNavigationComponent::AddPendingTile(int32 Region)
+{
+	if (bIsDeferring)
+	{
+		RegionPendingTiles[GetRegionSlot(Region)]++;
+	}
+}
+
+void UDungeonNavigationComponent::OnTileSpawned(int32 Region)
+{
+	if (!bIsDeferring)
+	{
+		return;
+	}
+
+	const int32 Slot = GetRegionSlot(Region);
+	if (RegionPendingTiles[Slot] > 0 && --RegionPendingTiles[Slot] == 0)
+	{
+		ReleaseRegion(Slot);
+	}
+}
+
+void UDungeonNavigationComponent::DeferComponent(int32 Region, UPrimitiveComponent* Component)
+{
+	if (bIsDeferring && Component && Component->CanEverAffectNavigation())
+	{
+		Component->SetCanEverAffectNavigation(false);
+		RegionComponents[GetRegionSlot(Region)].Add(Component);
+	}
+}
+
+void UDungeonNavigationComponent::DeferActor(int32 Region, AActor* Actor)
+{
+	if (!bIsDeferring || !Actor)
+	{
+		return;
+	}
+
+	// Spawned tiles are only queued for the navigation octree until its next tick, so removing them here never dirties the navmesh
+	TInlineComponentArray<UPrimitiveComponent*> PrimitiveComponents;
+	Actor->GetComponents(PrimitiveComponents);
+	for (UPrimitiveComponent* Component : PrimitiveComponents)
+	{
+		DeferComponent(Region, Component);
+	}
+}
+
+void UDungeonNavigationComponent::ReleaseAllRegions()
+{
+	for (int32 Slot = 0; Slot < RegionPendingTiles.Num(); Slot++)
+	{
+		if (RegionPendingTiles[Slot] != INDEX_NONE)
+		{
+			ReleaseRegion(Slot);
+		}
+	}
+}
+
+void UDungeonNavigationComponent::Reset()
+{
+	// Pooled tiles must be able to affect navigation again when they are reused
+	ReleaseAllRegions();
+
+	RegionComponents.Empty();
+	RegionPendingTiles.Empty();
+	NumReleasedRegions = 0;
+	bIsDeferring = false;
+	bIsWaitingForNavigation = false;
+	SetComponentTickEnabled(false);
+}
+
+bool UDungeonNavigationComponent::IsNavigationReady() const
+{
+	return !bIsDeferring && !bIsWaitingForNavigation;
+}
+
+int32 UDungeonNavigationComponent::GetRegionSlot(int32 Region) const
+{
+	const int32 NumRegions = RegionPendingTiles.Num() - 1;
+	return Region >= 0 && Region < NumRegions ? Region : NumRegions;
+}
+
+void UDungeonNavigationComponent::ReleaseRegion(int32 Slot)
+{
+	for (TWeakObjectPtr<UPrimitiveComponent>& Component : RegionComponents[Slot])
+	{
+		if (Component.IsValid())
+		{
+			Component->SetCanEverAffectNavigation(true);
+		}
+	}
+	RegionComponents[Slot].Empty();
+	RegionPendingTiles[Slot] = INDEX_NONE;
+
+	if (NumReleasedRegions++ == 0)
+	{
+		FirstReleaseTime = FPlatformTime::Seconds();
+	}
+	LastReleaseFrame = GFrameCounter;
+
+	if (NumReleasedRegions == RegionPendingTiles.Num())
+	{
+		bIsDeferring = false;
+		bIsWaitingForNavigation = true;
+		SetComponentTickEnabled(true);
+	}
+}
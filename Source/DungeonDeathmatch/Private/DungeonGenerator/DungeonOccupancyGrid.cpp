@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonOccupancyGrid.h"
+
+FDungeonOccupancyGrid::FDungeonOccupancyGrid()
+{
+	Origin = FIntVector(0, 0, 0);
+	Dimensions = FIntVector(0, 0, 0);
+	WordsPerRow = 0;
+	bIsSummedVolumeDirty = true;
+	DirtyQueryCost = 0;
+}
+
+void FDungeonOccupancyGrid::Init(const FIntVector& InOrigin, const FIntVector& InDimensions)
+{
+	Origin = InOrigin;
+	Dimensions = FIntVector(FMath::Max(InDimensions.X, 0), FMath::Max(InDimensions.Y, 0), FMath::Max(InDimensions.Z, 0));
+	WordsPerRow = (Dimensions.X + 63) / 64;
+
+	Words.SetNumZeroed(WordsPerRow * Dimensions.Y * Dimensions.Z);
+	SummedVolume.Empty();
+	bIsSummedVolumeDirty = true;
+	DirtyQueryCost = 0;
+}
+
+void FDungeonOccupancyGrid::Reset()
+{
+	FMemory::Memzero(Words.GetData(), Words.Num() * sizeof(uint64));
+	bIsSummedVolumeDirty = true;
+	DirtyQueryCost = 0;
+}
+
+bool FDungeonOccupancyGrid::IsCellOccupied(const FIntVector& Cell) const
+{
+	FIntVector Local = Cell - Origin;
+	if (Local.X < 0 || Local.Y < 0 || Local.Z < 0 || Local.X >= Dimensions.X || Local.Y >= Dimensions.Y || Local.Z >= Dimensions.Z)
+	{
+		return false;
+	}
+	return (Words[GetRowIndex(Local.Y, Local.Z) + (Local.X >> 6)] >> (Local.X & 63)) & 1;
+}
+
+bool FDungeonOccupancyGrid::IsBoxOccupied(const FIntVector& Min, const FIntVector& Max) const
+{
+	FIntVector LocalMin;
+	FIntVector LocalMax;
+	if (!ClampBox(Min, Max, LocalMin, LocalMax))
+	{
+		return false;
+	}
+
+	if (bIsSummedVolumeDirty)
+	{
+		// Scanning words is cheap for a handful of queries, but once the scans since the last change add up to a meaningful
+		// fraction of a rebuild, every following query is better served by the summed-volume table
+		int32 NumRows = (LocalMax.Y - LocalMin.Y) * (LocalMax.Z - LocalMin.Z);
+		int32 NumWordsPerRow = ((LocalMax.X - 1) >> 6) - (LocalMin.X >> 6) + 1;
+		DirtyQueryCost += NumRows * NumWordsPerRow;
+		if (DirtyQueryCost * 8 < (int64)Words.Num() * 64)
+		{
+			return IsLocalBoxOccupiedWords(LocalMin, LocalMax);
+		}
+		BuildSummedVolume();
+	}
+
+	return CountLocalBoxSummed(LocalMin, LocalMax) > 0;
+}
+
+int32 FDungeonOccupancyGrid::CountOccupied(const FIntVector& Min, const FIntVector& Max) const
+{
+	FIntVector LocalMin;
+	FIntVector LocalMax;
+	if (!ClampBox(Min, Max, LocalMin, LocalMax))
+	{
+		return 0;
+	}
+
+	if (bIsSummedVolumeDirty)
+	{
+		BuildSummedVolume();
+	}
+	return CountLocalBoxSummed(LocalMin, LocalMax);
+}
+
+void FDungeonOccupancyGrid::FillBox(const FIntVector& Min, const FIntVector& Max)
+{
+	FIntVector LocalMin;
+	FIntVector LocalMax;
+	if (!ClampBox(Min, Max, LocalMin, LocalMax))
+	{
+		return;
+	}
+
+	int32 FirstWord = LocalMin.X >> 6;
+	int32 LastWord = (LocalMax.X - 1) >> 6;
+	for (int32 Z = LocalMin.Z; Z < LocalMax.Z; Z++)
+	{
+		for (int32 Y = LocalMin.Y; Y < LocalMax.Y; Y++)
+		{
+			uint64* Row = &Words[GetRowIndex(Y, Z)];
+			for (int32 WordIndex = FirstWord; WordIndex <= LastWord; WordIndex++)
+			{
+				int32 FirstBit = WordIndex == FirstWord ? (LocalMin.X & 63) : 0;
+				int32 LastBit = WordIndex == LastWord ? ((LocalMax.X - 1) & 63) : 63;
+				Row[WordIndex] |= GetWordMask(FirstBit, LastBit);
+			}
+		}
+	}
+
+	bIsSummedVolumeDirty = true;
+	DirtyQueryCost = 0;
+}
+
+void FDungeonOccupancyGrid::BuildSummedVolume() const
+{
+	const int32 SizeX = Dimensions.X + 1;
+	const int32 SizeY = Dimensions.Y + 1;
+	const int32 SizeZ = Dimensions.Z + 1;
+	SummedVolume.SetNumZeroed(SizeX * SizeY * SizeZ);
+
+	// Standard 3D inclusive prefix sum, entry (X + 1, Y + 1, Z + 1) holds the occupied count of the box [0, X] x [0, Y] x [0, Z]
+	for (int32 Z = 1; Z < SizeZ; Z++)
+	{
+		for (int32 Y = 1; Y < SizeY; Y++)
+		{
+			const uint64* Row = &Words[GetRowIndex(Y - 1, Z - 1)];
+			int32 RowSum = 0;
+			for (int32 X = 1; X < SizeX; X++)
+			{
+				RowSum += (Row[(X - 1) >> 6] >> ((X - 1) & 63)) & 1;
+				SummedVolume[GetSummedIndex(X, Y, Z)] = RowSum
+					+ SummedVolume[GetSummedIndex(X, Y - 1, Z)]
+					+ SummedVolume[GetSummedIndex(X, Y, Z - 1)]
+					- SummedVolume[GetSummedIndex(X, Y - 1, Z - 1)];
+			}
+		}
+	}
+
+	bIsSummedVolumeDirty = false;
+	DirtyQueryCost = 0;
+}
+
+bool FDungeonOccupancyGrid::ClampBox(const FIntVector& Min, const FIntVector& Max, FIntVector& OutMin, FIntVector& OutMax) const
+{
+	OutMin = Min - Origin;
+	OutMax = Max - Origin;
+
+	OutMin.X = FMath::Max(OutMin.X, 0);
+	OutMin.Y = FMath::Max(OutMin.Y, 0);
+	OutMin.Z = FMath::Max(OutMin.Z, 0);
+	OutMax.X = FMath::Min(OutMax.X, Dimensions.X);
+	OutMax.Y = FMath::Min(OutMax.Y, Dimensions.Y);
+	OutMax.Z = FMath::Min(OutMax.Z, Dimensions.Z);
+
+	return OutMin.X < OutMax.X && OutMin.Y < OutMax.Y && OutMin.Z < OutMax.Z;
+}
+
+bool FDungeonOccupancyGrid::IsLocalBoxOccupiedWords(const FIntVector& LocalMin, const FIntVector& LocalMax) const
+{
+	int32 FirstWord = LocalMin.X >> 6;
+	int32 LastWord = (LocalMax.X - 1) >> 6;
+	uint64 FirstMask = GetWordMask(LocalMin.X & 63, FirstWord == LastWord ? ((LocalMax.X - 1) & 63) : 63);
+	uint64 LastMask = GetWordMask(0, (LocalMax.X - 1) & 63);
+
+	for (int32 Z = LocalMin.Z; Z < LocalMax.Z; Z++)
+	{
+		for (int32 Y = LocalMin.Y; Y < LocalMax.Y; Y++)
+		{
+			const uint64* Row = &Words[GetRowIndex(Y, Z)];
+			if (Row[FirstWord] & FirstMask)
+			{
+				return true;
+			}
+			for (int32 WordIndex = FirstWord + 1; WordIndex < LastWord; WordIndex++)
+			{
+				if (Row[WordIndex])
+				{
+					return true;
+				}
+			}
+			if (LastWord > FirstWord && (Row[LastWord] & LastMask))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+int32 FDungeonOccupancyGrid::CountLocalBoxSummed(const FIntVector& LocalMin, const FIntVector& LocalMax) const
+{
+	const int32 X0 = LocalMin.X, Y0 = LocalMin.Y, Z0 = LocalMin.Z;
+	const int32 X1 = LocalMax.X, Y1 = LocalMax.Y, Z1 = LocalMax.Z;
+
+	return SummedVolume[GetSummedIndex(X1, Y1, Z1)]
+		- SummedVolume[GetSummedIndex(X0, Y1, Z1)]
+		- SummedVolume[GetSummedIndex(X1, Y0, Z1)]
+		- SummedVolume[GetSummedIndex(X1, Y1, Z0)]
+		+ SummedVolume[GetSummedIndex(X0, Y0, Z1)]
+		+ SummedVolume[GetSummedIndex(X0, Y1, Z0)]
+		+ SummedVolume[GetSummedIndex(X1, Y0, Z0)]
+		- SummedVolume[GetSummedIndex(X0, Y0, Z0)];
+}
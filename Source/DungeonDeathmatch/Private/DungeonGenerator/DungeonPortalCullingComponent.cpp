@@ -0,0 +1,339 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonPortalCullingComponent.h"
+#include "DungeonPortalGraph.h"
+#include "Item.h"
+#include "Chest.h"
+
+#include <EngineUtils.h>
+#include <Camera/PlayerCameraManager.h>
+#include <Components/PrimitiveComponent.h>
+#include <GameFramework/Pawn.h>
+#include <GameFramework/PlayerController.h>
+
+// Sets default values for this component's properties
+UDungeonPortalCullingComponent::UDungeonPortalCullingComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	bEnableCulling = true;
+	PortalAngleMargin = 10.0f;
+	DynamicActorRefreshInterval = 0.5f;
+
+	PortalGraph = nullptr;
+	CellSize = FVector(500.0f, 500.0f, 500.0f);
+	bCulledSetsDirty = false;
+	TimeSinceDynamicActorRefresh = 0.0f;
+}
+
+void UDungeonPortalCullingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	APlayerController* PlayerController = GetWorld() ? GetWorld()->GetFirstPlayerController() : nullptr;
+	if (!bEnableCulling || !PortalGraph || PortalGraph->GetNumRegions() == 0 || !PlayerController || !PlayerController->IsLocalController() || !PlayerController->PlayerCameraManager)
+	{
+		ShowAllRegions();
+		return;
+	}
+
+	if (CullingController.Get() != PlayerController)
+	{
+		ShowAllRegions();
+		CullingController = PlayerController;
+	}
+
+	TimeSinceDynamicActorRefresh += DeltaTime;
+	if (TimeSinceDynamicActorRefresh >= DynamicActorRefreshInterval)
+	{
+		TimeSinceDynamicActorRefresh = 0.0f;
+		RefreshDynamicActors();
+	}
+
+	APlayerCameraManager* CameraManager = PlayerController->PlayerCameraManager;
+	TArray<bool> VisibleRegions;
+	if (!FindVisibleRegions(CameraManager->GetCameraLocation(), CameraManager->GetCameraRotation(), CameraManager->GetFOVAngle(), VisibleRegions))
+	{
+		// Outside of the dungeon, nothing can be culled by portals
+		ShowAllRegions();
+		return;
+	}
+
+	for (int32 Region = 0; Region < VisibleRegions.Num(); Region++)
+	{
+		SetRegionHidden(Region, !VisibleRegions[Region]);
+	}
+	ApplyCulledSets();
+}
+
+void UDungeonPortalCullingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ShowAllRegions();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UDungeonPortalCullingComponent::SetPortalGraph(const FDungeonPortalGraph* InPortalGraph, const FVector& InCellSize)
+{
+	ShowAllRegions();
+
+	PortalGraph = InPortalGraph;
+	CellSize = InCellSize;
+
+	const int32 NumRegions = PortalGraph ? PortalGraph->GetNumRegions() : 0;
+	RegionComponents.Empty(NumRegions);
+	RegionComponents.SetNum(NumRegions);
+	RegionActors.Empty(NumRegions);
+	RegionActors.SetNum(NumRegions);
+	RegionDynamicActors.Empty(NumRegions);
+	RegionDynamicActors.SetNum(NumRegions);
+	HiddenRegions.Init(false, NumRegions);
+
+	// Sort items and chests on the next tick
+	TimeSinceDynamicActorRefresh = DynamicActorRefreshInterval;
+}
+
+void UDungeonPortalCullingComponent::RegisterRegionComponent(int32 Region, UPrimitiveComponent* Component)
+{
+	if (RegionComponents.IsValidIndex(Region) && Component)
+	{
+		RegionComponents[Region].Add(Component);
+		if (HiddenRegions[Region])
+		{
+			CulledComponents.Add(Component);
+			bCulledSetsDirty = true;
+		}
+	}
+}
+
+void UDungeonPortalCullingComponent::RegisterRegionActor(int32 Region, AActor* Actor)
+{
+	if (RegionActors.IsValidIndex(Region) && Actor)
+	{
+		RegionActors[Region].Add(Actor);
+		if (HiddenRegions[Region])
+		{
+			CulledActors.Add(Actor);
+			bCulledSetsDirty = true;
+		}
+	}
+}
+
+int32 UDungeonPortalCullingComponent::FindRegionAtLocation(const FVector& Location) const
+{
+	if (!PortalGraph || CellSize.X <= 0.0f || CellSize.Y <= 0.0f || CellSize.Z <= 0.0f)
+	{
+		return INDEX_NONE;
+	}
+
+	FIntVector Cell = FIntVector(FMath::FloorToInt(Location.X / CellSize.X), FMath::FloorToInt(Location.Y / CellSize.Y), FMath::FloorToInt(Location.Z / CellSize.Z));
+	return PortalGraph->FindRegion(Cell);
+}
+
+int32 UDungeonPortalCullingComponent::GetNumHiddenRegions() const
+{
+	int32 NumHiddenRegions = 0;
+	for (bool bIsHidden : HiddenRegions)
+	{
+		NumHiddenRegions += bIsHidden ? 1 : 0;
+	}
+	return NumHiddenRegions;
+}
+
+bool UDungeonPortalCullingComponent::FindVisibleRegions(const FVector& CameraLocation, const FRotator& CameraRotation, float FOVAngle, TArray<bool>& OutVisibleRegions) const
+{
+	const int32 CameraRegion = FindRegionAtLocation(CameraLocation);
+	if (CameraRegion == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FVector CameraForward = CameraRotation.Vector();
+	const float HalfAngle = FOVAngle * 0.5f + PortalAngleMargin;
+	const float CosHalfAngle = HalfAngle >= 180.0f ? -1.0f : FMath::Cos(FMath::DegreesToRadians(HalfAngle));
+
+	OutVisibleRegions.Init(false, PortalGraph->GetNumRegions());
+	OutVisibleRegions[CameraRegion] = true;
+
+	TArray<int32> RegionQueue;
+	RegionQueue.Add(CameraRegion);
+	for (int32 QueueIndex = 0; QueueIndex < RegionQueue.Num(); QueueIndex++)
+	{
+		const int32 Region = RegionQueue[QueueIndex];
+		for (int32 PortalIndex : PortalGraph->GetRegionPortals(Region))
+		{
+			const FDungeonPortal& Portal = PortalGraph->GetPortals()[PortalIndex];
+			const int32 OtherRegion = Portal.GetOtherRegion(Region);
+			if (OutVisibleRegions[OtherRegion])
+			{
+				continue;
+			}
+
+			FBox PortalBounds = FBox(Portal.Bounds.Min * CellSize, Portal.Bounds.Max * CellSize);
+			if (IsPortalVisible(PortalBounds, CameraLocation, CameraForward, CosHalfAngle))
+			{
+				OutVisibleRegions[OtherRegion] = true;
+				RegionQueue.Add(OtherRegion);
+			}
+		}
+	}
+	return true;
+}
+
+bool UDungeonPortalCullingComponent::IsPortalVisible(const FBox& Bounds, const FVector& CameraLocation, const FVector& CameraForward, float CosHalfAngle) const
+{
+	// Standing in a doorway sees both sides of it no matter where the camera looks
+	if (Bounds.ExpandBy(CellSize.GetMin() * 0.5f).IsInside(CameraLocation))
+	{
+		return true;
+	}
+
+	const FVector TestPoints[5] =
+	{
+		Bounds.GetCenter(),
+		Bounds.Min,
+		Bounds.Max,
+		FVector(Bounds.Min.X, Bounds.Min.Y, Bounds.Max.Z),
+		FVector(Bounds.Max.X, Bounds.Max.Y, Bounds.Min.Z)
+	};
+	for (const FVector& TestPoint : TestPoints)
+	{
+		if (((TestPoint - CameraLocation).GetSafeNormal() | CameraForward) >= CosHalfAngle)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UDungeonPortalCullingComponent::RefreshDynamicActors()
+{
+	for (int32 Region = 0; Region < RegionDynamicActors.Num(); Region++)
+	{
+		if (HiddenRegions[Region])
+		{
+			SetActorsHidden(RegionDynamicActors[Region], false);
+		}
+		RegionDynamicActors[Region].Reset();
+	}
+
+	auto AddDynamicActor = [this](AActor* Actor)
+	{
+		// Equipped and carried items move with their owner and are drawn with it, so they aren't culled on their own
+		if (Actor->GetAttachParentActor() || Cast<APawn>(Actor->GetOwner()))
+		{
+			return;
+		}
+
+		int32 Region = FindRegionAtLocation(Actor->GetActorLocation());
+		if (Region != INDEX_NONE)
+		{
+			RegionDynamicActors[Region].Add(Actor);
+		}
+	};
+	for (TActorIterator<AItem> ItemIterator(GetWorld()); ItemIterator; ++ItemIterator)
+	{
+		AddDynamicActor(*ItemIterator);
+	}
+	for (TActorIterator<AChest> ChestIterator(GetWorld()); ChestIterator; ++ChestIterator)
+	{
+		AddDynamicActor(*ChestIterator);
+	}
+
+	for (int32 Region = 0; Region < RegionDynamicActors.Num(); Region++)
+	{
+		if (HiddenRegions[Region])
+		{
+			SetActorsHidden(RegionDynamicActors[Region], true);
+		}
+	}
+}
+
+void UDungeonPortalCullingComponent::SetRegionHidden(int32 Region, bool bIsHidden)
+{
+	if (HiddenRegions[Region] == bIsHidden)
+	{
+		return;
+	}
+	HiddenRegions[Region] = bIsHidden;
+
+	for (const TWeakObjectPtr<UPrimitiveComponent>& Component : RegionComponents[Region])
+	{
+		if (bIsHidden)
+		{
+			CulledComponents.Add(Component);
+		}
+		else
+		{
+			CulledComponents.Remove(Component);
+		}
+	}
+	bCulledSetsDirty = true;
+	SetActorsHidden(RegionActors[Region], bIsHidden);
+	SetActorsHidden(RegionDynamicActors[Region], bIsHidden);
+}
+
+void UDungeonPortalCullingComponent::SetActorsHidden(const TArray<TWeakObjectPtr<AActor>>& Actors, bool bIsHidden)
+{
+	for (const TWeakObjectPtr<AActor>& Actor : Actors)
+	{
+		if (bIsHidden)
+		{
+			CulledActors.Add(Actor);
+		}
+		else
+		{
+			CulledActors.Remove(Actor);
+		}
+	}
+	bCulledSetsDirty = true;
+}
+
+void UDungeonPortalCullingComponent::ApplyCulledSets()
+{
+	if (!bCulledSetsDirty)
+	{
+		return;
+	}
+	bCulledSetsDirty = false;
+
+	APlayerController* PlayerController = CullingController.Get();
+	if (PlayerController)
+	{
+		PlayerController->HiddenPrimitiveComponents.RemoveAll([this](const TWeakObjectPtr<UPrimitiveComponent>& Component)
+		{
+			return AppliedComponents.Contains(Component);
+		});
+		for (const TWeakObjectPtr<UPrimitiveComponent>& Component : CulledComponents)
+		{
+			if (Component.IsValid())
+			{
+				PlayerController->HiddenPrimitiveComponents.Add(Component);
+			}
+		}
+
+		PlayerController->HiddenActors.RemoveAll([this](AActor* Actor)
+		{
+			return !Actor || AppliedActors.Contains(Actor);
+		});
+		for (const TWeakObjectPtr<AActor>& Actor : CulledActors)
+		{
+			if (Actor.IsValid())
+			{
+				PlayerController->HiddenActors.Add(Actor.Get());
+			}
+		}
+	}
+
+	AppliedComponents = CulledComponents;
+	AppliedActors = CulledActors;
+}
+
+void UDungeonPortalCullingComponent::ShowAllRegions()
+{
+	for (int32 Region = 0; Region < HiddenRegions.Num(); Region++)
+	{
+		SetRegionHidden(Region, false);
+	}
+	ApplyCulledSets();
+}
@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonPortalGraph.h"
+#include "DungeonGraph.h"
+
+FDungeonPortalGraph::FDungeonPortalGraph()
+{
+	NumRegions = 0;
+}
+
+void FDungeonPortalGraph::Build(const FDungeonRoomSet& Rooms, const FDungeonTileGraph& Corridors)
+{
+	Empty();
+
+	RoomBounds.Reserve(Rooms.Num());
+	for (int32 RoomIndex = 0; RoomIndex < Rooms.Num(); RoomIndex++)
+	{
+		const FIntVector& Min = Rooms.Locations[RoomIndex];
+		const FIntVector Max = Rooms.GetMax(RoomIndex);
+		RoomBounds.Add(TPair<FIntVector, FIntVector>(Min, Max));
+
+		for (int32 Z = Min.Z; Z < Max.Z; Z++)
+		{
+			for (int32 Y = Min.Y; Y < Max.Y; Y++)
+			{
+				for (int32 X = Min.X; X < Max.X; X++)
+				{
+					RoomCellRooms.Add(FIntVector(X, Y, Z), RoomIndex);
+				}
+			}
+		}
+	}
+
+	// Group corridor tiles that touch, including vertically, into regions. Touching tiles without a connection still share a
+	// region, which can only make more of the dungeon visible and never hides anything that should be seen.
+	const TArray<FTileData>& CorridorTiles = Corridors.GetTiles();
+	FDungeonUnionFind CorridorGroups(CorridorTiles.Num());
+	const FIntVector NeighborOffsets[3] = { FIntVector(1, 0, 0), FIntVector(0, 1, 0), FIntVector(0, 0, 1) };
+	for (int32 TileIndex = 0; TileIndex < CorridorTiles.Num(); TileIndex++)
+	{
+		for (const FIntVector& Offset : NeighborOffsets)
+		{
+			int32 NeighborIndex = Corridors.FindIndex(CorridorTiles[TileIndex].Coordinate + Offset);
+			if (NeighborIndex != INDEX_NONE)
+			{
+				CorridorGroups.Union(TileIndex, NeighborIndex);
+			}
+		}
+	}
+
+	TMap<int32, int32> GroupRegions;
+	NumRegions = Rooms.Num();
+	CorridorCellRegions.Reserve(CorridorTiles.Num());
+	for (int32 TileIndex = 0; TileIndex < CorridorTiles.Num(); TileIndex++)
+	{
+		const int32 Group = CorridorGroups.Find(TileIndex);
+		const int32* Region = GroupRegions.Find(Group);
+		if (!Region)
+		{
+			Region = &GroupRegions.Add(Group, NumRegions++);
+		}
+		CorridorCellRegions.Add(CorridorTiles[TileIndex].Coordinate, *Region);
+	}
+	RegionPortals.SetNum(NumRegions);
+
+	RegionCenters.SetNumZeroed(NumRegions);
+	TArray<int32> RegionCellCounts;
+	RegionCellCounts.SetNumZeroed(NumRegions);
+	for (int32 RoomIndex = 0; RoomIndex < RoomBounds.Num(); RoomIndex++)
+	{
+		RegionCenters[RoomIndex] = (FVector(RoomBounds[RoomIndex].Key) + FVector(RoomBounds[RoomIndex].Value)) * 0.5f;
+	}
+	for (const TPair<FIntVector, int32>& CorridorCellRegion : CorridorCellRegions)
+	{
+		RegionCenters[CorridorCellRegion.Value] += FVector(CorridorCellRegion.Key) + FVector(0.5f, 0.5f, 0.5f);
+		RegionCellCounts[CorridorCellRegion.Value]++;
+	}
+	for (int32 Region = RoomBounds.Num(); Region < NumRegions; Region++)
+	{
+		RegionCenters[Region] /= FMath::Max(RegionCellCounts[Region], 1);
+	}
+
+	// Doorways are the open sides of corridor tiles that lead into a room
+	for (const FTileData& Tile : CorridorTiles)
+	{
+		for (uint8 DirectionIndex = 0; DirectionIndex < 4; DirectionIndex++)
+		{
+			ECardinalDirection Direction = (ECardinalDirection)DirectionIndex;
+			FIntVector Offset = FDungeonTileGraph::GetDirectionOffset(Direction);
+			if (!Tile.IsConnected(Direction) || Corridors.Contains(Tile.Coordinate + Offset))
+			{
+				continue;
+			}
+
+			int32 Room = FindRoom(Tile.Coordinate + Offset);
+			if (Room == INDEX_NONE)
+			{
+				continue;
+			}
+
+			// The shared face of the two cells, flat along the step axis
+			FVector CellMin = FVector(Tile.Coordinate);
+			FVector FaceMin = CellMin + FVector(FMath::Max(Offset.X, 0), FMath::Max(Offset.Y, 0), 0);
+			FVector FaceMax = FaceMin + FVector(Offset.X == 0 ? 1 : 0, Offset.Y == 0 ? 1 : 0, 1);
+
+			int32 PortalIndex = Portals.Add(FDungeonPortal(Room, CorridorCellRegions[Tile.Coordinate], FBox(FaceMin, FaceMax)));
+			RegionPortals[Room].Add(PortalIndex);
+			RegionPortals[Portals[PortalIndex].RegionB].Add(PortalIndex);
+		}
+	}
+}
+
+void FDungeonPortalGraph::Empty()
+{
+	RoomBounds.Empty();
+	NumRegions = 0;
+	CorridorCellRegions.Empty();
+	RoomCellRooms.Empty();
+	Portals.Empty();
+	RegionPortals.Empty();
+	RegionCenters.Empty();
+}
+
+int32 FDungeonPortalGraph::FindRegion(const FIntVector& Cell) const
+{
+	int32 Region = FindCorridorRegion(Cell);
+	return Region != INDEX_NONE ? Region : FindRoom(Cell);
+}
+
+int32 FDungeonPortalGraph::FindCorridorRegion(const FIntVector& Cell) const
+{
+	const int32* Region = CorridorCellRegions.Find(Cell);
+	return Region ? *Region : INDEX_NONE;
+}
+
+int32 FDungeonPortalGraph::FindRoom(const FIntVector& Cell) const
+{
+	const int32* Room = RoomCellRooms.Find(Cell);
+	return Room ? *Room : INDEX_NONE;
+}
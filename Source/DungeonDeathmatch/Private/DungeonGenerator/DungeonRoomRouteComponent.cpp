@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonRoomRouteComponent.h"
+#include "DungeonGenerator.h"
+#include "DungeonPortalGraph.h"
+
+#include <EngineUtils.h>
+
+// Sets default values for this component's properties
+UDungeonRoomRouteComponent::UDungeonRoomRouteComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	PortalGraph = nullptr;
+	CellSize = FVector(500.0f, 500.0f, 500.0f);
+	NumRegions = 0;
+}
+
+void UDungeonRoomRouteComponent::SetPortalGraph(const FDungeonPortalGraph* InPortalGraph, const FVector& InCellSize)
+{
+	PortalGraph = InPortalGraph;
+	CellSize = InCellSize;
+	NumRegions = 0;
+	NextPortals.Empty();
+	PortalWaypoints.Empty();
+
+	if (PortalGraph)
+	{
+		double BuildStartTime = FPlatformTime::Seconds();
+		BuildRouteTable();
+		UE_LOG(LogTemp, Log, TEXT("UDungeonRoomRouteComponent::SetPortalGraph - Built routes between %d regions through %d doorways in %f seconds"), NumRegions, PortalWaypoints.Num(), FPlatformTime::Seconds() - BuildStartTime);
+	}
+}
+
+bool UDungeonRoomRouteComponent::FindRoomRoute(const FVector& Start, const FVector& End, TArray<FVector>& OutWaypoints) const
+{
+	OutWaypoints.Reset();
+
+	int32 Region = FindRegionAtLocation(Start);
+	const int32 EndRegion = FindRegionAtLocation(End);
+	if (Region != INDEX_NONE && EndRegion != INDEX_NONE)
+	{
+		while (Region != EndRegion)
+		{
+			const int32 PortalIndex = NextPortals[Region * NumRegions + EndRegion];
+			if (PortalIndex == INDEX_NONE || OutWaypoints.Num() >= NumRegions)
+			{
+				OutWaypoints.Reset();
+				return false;
+			}
+
+			OutWaypoints.Add(PortalWaypoints[PortalIndex]);
+			Region = PortalGraph->GetPortals()[PortalIndex].GetOtherRegion(Region);
+		}
+	}
+
+	OutWaypoints.Add(End);
+	return true;
+}
+
+int32 UDungeonRoomRouteComponent::FindRegionAtLocation(const FVector& Location) const
+{
+	if (!PortalGraph || NumRegions == 0 || CellSize.X <= 0.0f || CellSize.Y <= 0.0f || CellSize.Z <= 0.0f)
+	{
+		return INDEX_NONE;
+	}
+
+	FIntVector Cell = FIntVector(FMath::FloorToInt(Location.X / CellSize.X), FMath::FloorToInt(Location.Y / CellSize.Y), FMath::FloorToInt(Location.Z / CellSize.Z));
+	return PortalGraph->FindRegion(Cell);
+}
+
+UDungeonRoomRouteComponent* UDungeonRoomRouteComponent::FindInWorld(UWorld* World)
+{
+	if (!World)
+	{
+		return nullptr;
+	}
+
+	for (TActorIterator<ADungeonGenerator> GeneratorIterator(World); GeneratorIterator; ++GeneratorIterator)
+	{
+		UDungeonRoomRouteComponent* RouteComponent = GeneratorIterator->FindComponentByClass<UDungeonRoomRouteComponent>();
+		if (RouteComponent)
+		{
+			return RouteComponent;
+		}
+	}
+	return nullptr;
+}
+
+void UDungeonRoomRouteComponent::BuildRouteTable()
+{
+	NumRegions = PortalGraph->GetNumRegions();
+	const TArray<FDungeonPortal>& Portals = PortalGraph->GetPortals();
+
+	PortalWaypoints.Reserve(Portals.Num());
+	for (const FDungeonPortal& Portal : Portals)
+	{
+		FVector Center = Portal.Bounds.GetCenter();
+		PortalWaypoints.Add(FVector(Center.X, Center.Y, Portal.Bounds.Min.Z) * CellSize);
+	}
+
+	// Walking through a doorway costs the distance from one region's center to the other's through the doorway
+	TArray<float> PortalCosts;
+	PortalCosts.Reserve(Portals.Num());
+	for (int32 PortalIndex = 0; PortalIndex < Portals.Num(); PortalIndex++)
+	{
+		const FDungeonPortal& Portal = Portals[PortalIndex];
+		const FVector CenterA = PortalGraph->GetRegionCenter(Portal.RegionA) * CellSize;
+		const FVector CenterB = PortalGraph->GetRegionCenter(Portal.RegionB) * CellSize;
+		PortalCosts.Add(FVector::Distance(CenterA, PortalWaypoints[PortalIndex]) + FVector::Distance(PortalWaypoints[PortalIndex], CenterB));
+	}
+
+	NextPortals.Init(INDEX_NONE, NumRegions * NumRegions);
+	TArray<float> Costs;
+	TArray<TPair<float, int32>> OpenSet;
+	auto CostPredicate = [](const TPair<float, int32>& A, const TPair<float, int32>& B)
+	{
+		return A.Key < B.Key;
+	};
+	for (int32 FromRegion = 0; FromRegion < NumRegions; FromRegion++)
+	{
+		int32* FirstPortals = &NextPortals[FromRegion * NumRegions];
+		Costs.Init(MAX_flt, NumRegions);
+		Costs[FromRegion] = 0.0f;
+		OpenSet.Reset();
+		OpenSet.HeapPush(TPair<float, int32>(0.0f, FromRegion), CostPredicate);
+
+		while (OpenSet.Num() > 0)
+		{
+			TPair<float, int32> Entry;
+			OpenSet.HeapPop(Entry, CostPredicate, false);
+			const int32 Region = Entry.Value;
+			if (Entry.Key > Costs[Region])
+			{
+				continue;
+			}
+
+			for (int32 PortalIndex : PortalGraph->GetRegionPortals(Region))
+			{
+				const int32 Neighbor = Portals[PortalIndex].GetOtherRegion(Region);
+				const float Cost = Costs[Region] + PortalCosts[PortalIndex];
+				if (Cost < Costs[Neighbor])
+				{
+					Costs[Neighbor] = Cost;
+					// Every region reached through another region shares its first doorway
+					FirstPortals[Neighbor] = Region == FromRegion ? PortalIndex : FirstPortals[Region];
+					OpenSet.HeapPush(TPair<float, int32>(Cost, Neighbor), CostPredicate);
+				}
+			}
+		}
+	}
+}
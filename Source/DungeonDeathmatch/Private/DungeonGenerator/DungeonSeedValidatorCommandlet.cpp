@@ -0,0 +1,332 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonSeedValidatorCommandlet.h"
+#include "DungeonGenerator.h"
+#include "DungeonGraph.h"
+#include "DungeonLayoutBuilder.h"
+
+#include <Async/ParallelFor.h>
+#include <Misc/FileHelper.h>
+#include <Misc/Paths.h>
+
+/** Problems a seed can be flagged for */
+#define SEED_FLAG_DISCONNECTED	(1 << 0)
+#define SEED_FLAG_MISSING_ROOMS	(1 << 1)
+#define SEED_FLAG_MISSING_TILES	(1 << 2)
+#define SEED_FLAG_DEAD_ENDS		(1 << 3)
+#define SEED_FLAG_SLOW			(1 << 4)
+
+namespace
+{
+	struct FSeedValidationResult
+	{
+		int32 Seed;
+
+		/** Total generation time in seconds */
+		double Time;
+
+		int32 RoomsPlaced;
+		int32 Connections;
+
+		/** Groups of rooms joined by carved corridors, 1 for a fully connected dungeon */
+		int32 RoomGroups;
+
+		int32 FailedCorridors;
+		int32 CorridorTiles;
+		int32 VerticalConnectors;
+		int32 TilesGenerated;
+
+		/** Groups of tiles joined by tile connections, 1 for a fully connected tile layout */
+		int32 TileGroups;
+
+		/** Fraction of tiles and corridor tiles with a single connection */
+		float DeadEndRatio;
+
+		/** Quality in the range [0, 1], higher is better */
+		float Score;
+
+		/** SEED_FLAG_* bits */
+		uint8 Flags;
+	};
+
+	FString GetFlagNames(uint8 Flags)
+	{
+		static const TCHAR* FlagNames[] = { TEXT("Disconnected"), TEXT("MissingRooms"), TEXT("MissingTiles"), TEXT("DeadEnds"), TEXT("Slow") };
+
+		FString Names;
+		for (int32 FlagIndex = 0; FlagIndex < ARRAY_COUNT(FlagNames); FlagIndex++)
+		{
+			if (Flags & (1 << FlagIndex))
+			{
+				if (!Names.IsEmpty())
+				{
+					Names += TEXT("|");
+				}
+				Names += FlagNames[FlagIndex];
+			}
+		}
+		return Names;
+	}
+
+	/**
+	 * Counts the groups of rooms a player can walk between. With carved corridors this floods the regions of the portal graph, so
+	 * a corridor that failed or never reached a doorway splits the rooms. Without corridors only the planned connections exist.
+	 */
+	int32 CountRoomGroups(const FDungeonLayout& Layout, bool bCarvedCorridors)
+	{
+		const int32 NumRooms = Layout.Rooms.Num();
+		if (!bCarvedCorridors)
+		{
+			FDungeonUnionFind RoomGroups(NumRooms);
+			for (const FDungeonGraphEdge& Connection : Layout.Connections)
+			{
+				RoomGroups.Union(Connection.A, Connection.B);
+			}
+			return RoomGroups.GetNumSets();
+		}
+
+		const FDungeonPortalGraph& PortalGraph = Layout.PortalGraph;
+		FDungeonUnionFind RegionGroups(PortalGraph.GetNumRegions());
+		for (const FDungeonPortal& Portal : PortalGraph.GetPortals())
+		{
+			RegionGroups.Union(Portal.RegionA, Portal.RegionB);
+		}
+
+		// Rooms are the first regions of the portal graph, corridor regions that reach no room don't count
+		TSet<int32> RoomGroups;
+		for (int32 Room = 0; Room < NumRooms && Room < PortalGraph.GetNumRegions(); Room++)
+		{
+			RoomGroups.Add(RegionGroups.Find(Room));
+		}
+		return RoomGroups.Num();
+	}
+
+	/** Counts the groups of tiles joined by their connections */
+	int32 CountTileGroups(const FDungeonTileGraph& TileGraph)
+	{
+		const TArray<FTileData>& Tiles = TileGraph.GetTiles();
+		FDungeonUnionFind TileGroups(Tiles.Num());
+		for (int32 TileIndex = 0; TileIndex < Tiles.Num(); TileIndex++)
+		{
+			for (uint8 DirectionIndex = 0; DirectionIndex < 4; DirectionIndex++)
+			{
+				ECardinalDirection Direction = (ECardinalDirection)DirectionIndex;
+				if (!Tiles[TileIndex].IsConnected(Direction))
+				{
+					continue;
+				}
+
+				int32 NeighborIndex = TileGraph.FindIndex(Tiles[TileIndex].Coordinate + FDungeonTileGraph::GetDirectionOffset(Direction));
+				if (NeighborIndex != INDEX_NONE)
+				{
+					TileGroups.Union(TileIndex, NeighborIndex);
+				}
+			}
+		}
+		return TileGroups.GetNumSets();
+	}
+}
+
+UDungeonSeedValidatorCommandlet::UDungeonSeedValidatorCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+int32 UDungeonSeedValidatorCommandlet::Main(const FString& Params)
+{
+	int32 NumSeeds = 0;
+	if (!FParse::Value(*Params, TEXT("Seeds="), NumSeeds) || NumSeeds <= 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UDungeonSeedValidatorCommandlet::Main - Missing -Seeds=, expected the number of seeds to validate"));
+		return 1;
+	}
+
+	int32 FirstSeed = 0;
+	FParse::Value(*Params, TEXT("FirstSeed="), FirstSeed);
+
+	FDungeonGenerationParams BaseParams;
+	if (!ADungeonGenerator::ParseCommandletGenerationParams(Params, BaseParams))
+	{
+		return 1;
+	}
+
+	// Seeds placing fewer rooms than this fraction of NumberOfRooms are flagged
+	float MinRoomRatio = 0.9f;
+	FParse::Value(*Params, TEXT("MinRoomRatio="), MinRoomRatio);
+
+	float MaxDeadEndRatio = 0.3f;
+	FParse::Value(*Params, TEXT("MaxDeadEndRatio="), MaxDeadEndRatio);
+
+	// Seeds run concurrently, so their times are inflated by contention. Slow seeds are found relative to the median instead.
+	float SlowFactor = 3.0f;
+	FParse::Value(*Params, TEXT("SlowFactor="), SlowFactor);
+
+	// Absolute time limit in milliseconds, 0 for none
+	float MaxMs = 0.0f;
+	FParse::Value(*Params, TEXT("MaxMs="), MaxMs);
+
+	FString OutputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SeedValidation"), TEXT("DungeonSeedValidation.csv"));
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	FString PoolPath;
+	FParse::Value(*Params, TEXT("Pool="), PoolPath);
+
+	const bool bFailOnFlagged = FParse::Param(*Params, TEXT("FailOnFlagged"));
+
+	double ValidationStartTime = FPlatformTime::Seconds();
+	TArray<FSeedValidationResult> Results;
+	Results.SetNumZeroed(NumSeeds);
+
+	// Builders share nothing, every one seeds its own random streams from its params
+	ParallelFor(NumSeeds, [&](int32 SeedIndex)
+	{
+		FDungeonGenerationParams SeedParams = BaseParams;
+		SeedParams.Seed = FirstSeed + SeedIndex;
+
+		FDungeonLayoutBuilder Builder(SeedParams);
+		Builder.Build();
+
+		const FDungeonGenerationStats& Stats = Builder.GetStats();
+		const FDungeonLayout& Layout = Builder.GetLayout();
+		FSeedValidationResult& Result = Results[SeedIndex];
+		Result.Seed = SeedParams.Seed;
+		Result.Time = Stats.RoomsTime + Stats.ConnectionsTime + Stats.SpawnsTime + Stats.CorridorsTime + Stats.TilesTime;
+		Result.RoomsPlaced = Layout.Rooms.Num();
+		Result.Connections = Layout.Connections.Num();
+		Result.FailedCorridors = Stats.FailedCorridors;
+		Result.CorridorTiles = Layout.Corridors.Num();
+		Result.VerticalConnectors = Layout.VerticalConnectors.Num();
+		Result.TilesGenerated = Layout.Tiles.Num();
+		Result.RoomGroups = CountRoomGroups(Layout, SeedParams.bGenerateRooms && SeedParams.bCarveCorridors);
+		Result.TileGroups = CountTileGroups(Layout.Tiles);
+
+		// Vertical steps don't have a connection bit, so the corridor tiles at either end of a stairs or shaft run are not dead ends
+		// even with a single horizontal connection
+		TSet<FIntVector> VerticalEndCells;
+		VerticalEndCells.Reserve(Layout.VerticalConnectors.Num() * 2);
+		for (const FDungeonVerticalConnector& Connector : Layout.VerticalConnectors)
+		{
+			VerticalEndCells.Add(Connector.Bottom);
+			VerticalEndCells.Add(Connector.Bottom + FIntVector(0, 0, Connector.Height));
+		}
+
+		int32 NumDeadEnds = 0;
+		for (const FDungeonTileGraph* TileGraph : { &Layout.Tiles, &Layout.Corridors })
+		{
+			for (const FTileData& Tile : TileGraph->GetTiles())
+			{
+				// A single set bit means a single connection
+				const uint8 Mask = Tile.ConnectionMask & 0xF;
+				const bool IsVerticalEnd = TileGraph == &Layout.Corridors && VerticalEndCells.Contains(Tile.Coordinate);
+				NumDeadEnds += Mask != 0 && (Mask & (Mask - 1)) == 0 && !IsVerticalEnd ? 1 : 0;
+			}
+		}
+		const int32 NumTiles = Layout.Tiles.Num() + Layout.Corridors.Num();
+		Result.DeadEndRatio = NumTiles > 0 ? (float)NumDeadEnds / NumTiles : 0.0f;
+
+		float RoomRatio = 1.0f;
+		if (SeedParams.bGenerateRooms)
+		{
+			RoomRatio = FMath::Min((float)Result.RoomsPlaced / FMath::Max(SeedParams.NumberOfRooms, 1), 1.0f);
+			if (Result.RoomGroups > 1 || (SeedParams.bCarveCorridors && Result.FailedCorridors > 0))
+			{
+				Result.Flags |= SEED_FLAG_DISCONNECTED;
+			}
+			if (RoomRatio < MinRoomRatio)
+			{
+				Result.Flags |= SEED_FLAG_MISSING_ROOMS;
+			}
+		}
+
+		float TileRatio = 1.0f;
+		if (SeedParams.bGenerateTiles)
+		{
+			TileRatio = FMath::Min((float)Result.TilesGenerated / FMath::Max(SeedParams.NumberOfTiles, 1), 1.0f);
+			if (Result.TilesGenerated < SeedParams.NumberOfTiles)
+			{
+				Result.Flags |= SEED_FLAG_MISSING_TILES;
+			}
+			if (Result.TileGroups > 1)
+			{
+				Result.Flags |= SEED_FLAG_DISCONNECTED;
+			}
+		}
+
+		if (Result.DeadEndRatio > MaxDeadEndRatio)
+		{
+			Result.Flags |= SEED_FLAG_DEAD_ENDS;
+		}
+
+		Result.Score = (Result.Flags & SEED_FLAG_DISCONNECTED) ? 0.0f : RoomRatio * TileRatio * (1.0f - Result.DeadEndRatio);
+	});
+
+	TArray<double> Times;
+	Times.Reserve(NumSeeds);
+	for (const FSeedValidationResult& Result : Results)
+	{
+		Times.Add(Result.Time);
+	}
+	Times.Sort();
+	const double MedianTime = Times[Times.Num() / 2];
+	for (FSeedValidationResult& Result : Results)
+	{
+		if ((SlowFactor > 0.0f && Result.Time > MedianTime * SlowFactor) || (MaxMs > 0.0f && Result.Time * 1000.0 > MaxMs))
+		{
+			Result.Flags |= SEED_FLAG_SLOW;
+		}
+	}
+
+	// Seeds that passed come first, then by score, then the faster seed, then the lower seed so the ranking is stable
+	Results.Sort([](const FSeedValidationResult& A, const FSeedValidationResult& B)
+	{
+		if ((A.Flags == 0) != (B.Flags == 0))
+		{
+			return A.Flags == 0;
+		}
+		if (A.Score != B.Score)
+		{
+			return A.Score > B.Score;
+		}
+		return A.Time != B.Time ? A.Time < B.Time : A.Seed < B.Seed;
+	});
+
+	FString Csv = TEXT("Rank,Seed,Score,Flags,TotalMs,RoomsRequested,RoomsPlaced,Connections,RoomGroups,FailedCorridors,CorridorTiles,VerticalConnectors,TilesRequested,TilesGenerated,TileGroups,DeadEndRatio\n");
+	FString Pool;
+	int32 NumFlagged = 0;
+	for (int32 Rank = 0; Rank < Results.Num(); Rank++)
+	{
+		const FSeedValidationResult& Result = Results[Rank];
+		Csv += FString::Printf(TEXT("%d,%d,%.4f,%s,%.3f,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%.4f\n"),
+			Rank + 1, Result.Seed, Result.Score, *GetFlagNames(Result.Flags), Result.Time * 1000.0,
+			BaseParams.bGenerateRooms ? BaseParams.NumberOfRooms : 0, Result.RoomsPlaced, Result.Connections, Result.RoomGroups, Result.FailedCorridors, Result.CorridorTiles, Result.VerticalConnectors,
+			BaseParams.bGenerateTiles ? BaseParams.NumberOfTiles : 0, Result.TilesGenerated, Result.TileGroups, Result.DeadEndRatio);
+
+		if (Result.Flags == 0)
+		{
+			Pool += FString::Printf(TEXT("%d\n"), Result.Seed);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("UDungeonSeedValidatorCommandlet::Main - Seed %d flagged: %s"), Result.Seed, *GetFlagNames(Result.Flags));
+			NumFlagged++;
+		}
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *OutputPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UDungeonSeedValidatorCommandlet::Main - Failed to write seed report to %s"), *OutputPath);
+		return 1;
+	}
+	if (!PoolPath.IsEmpty() && !FFileHelper::SaveStringToFile(Pool, *PoolPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UDungeonSeedValidatorCommandlet::Main - Failed to write seed pool to %s"), *PoolPath);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("UDungeonSeedValidatorCommandlet::Main - Validated %d seeds in %f seconds (median %.3f ms per seed), %d flagged. Report written to %s"), NumSeeds, FPlatformTime::Seconds() - ValidationStartTime, MedianTime * 1000.0, NumFlagged, *OutputPath);
+	return bFailOnFlagged && NumFlagged > 0 ? 1 : 0;
+}
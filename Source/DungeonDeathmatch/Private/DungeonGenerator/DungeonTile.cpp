@@ -5,9 +5,16 @@
 // Sets default values
 ADungeonTile::ADungeonTile()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Tiles are static level geometry, blueprints that implement Tick get ticking enabled again automatically
+	PrimaryActorTick.bCanEverTick = false;
 
+	TileMesh = nullptr;
+	bRequiresActor = false;
+	bIsTileActive = true;
+	bWasTickEnabled = false;
+
+	// Tiles are spawned locally on every machine from the replicated dungeon seed
+	bReplicates = false;
 }
 
 // Called when the game starts or when spawned
@@ -24,3 +31,26 @@ void ADungeonTile::Tick(float DeltaTime)
 
 }
 
+void ADungeonTile::SetTileActive(bool bIsActive)
+{
+	if (bIsTileActive == bIsActive)
+	{
+		return;
+	}
+	bIsTileActive = bIsActive;
+
+	if (bIsActive)
+	{
+		SetActorHiddenInGame(false);
+		SetActorEnableCollision(true);
+		SetActorTickEnabled(bWasTickEnabled);
+		OnTileReused();
+	}
+	else
+	{
+		bWasTickEnabled = IsActorTickEnabled();
+		SetActorHiddenInGame(true);
+		SetActorEnableCollision(false);
+		SetActorTickEnabled(false);
+	}
+}
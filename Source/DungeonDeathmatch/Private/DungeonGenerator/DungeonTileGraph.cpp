@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonTileGraph.h"
+
+void FDungeonTileGraph::Empty(int32 ExpectedNumTiles)
+{
+	Tiles.Empty(ExpectedNumTiles);
+	TileIndices.Empty(ExpectedNumTiles);
+}
+
+int32 FDungeonTileGraph::Add(const FTileData& Tile)
+{
+	if (TileIndices.Contains(Tile.Coordinate))
+	{
+		return INDEX_NONE;
+	}
+
+	int32 Index = Tiles.Add(Tile);
+	TileIndices.Add(Tile.Coordinate, Index);
+	return Index;
+}
+
+int32 FDungeonTileGraph::FindIndex(const FIntVector& Coordinate) const
+{
+	const int32* Index = TileIndices.Find(Coordinate);
+	return Index ? *Index : INDEX_NONE;
+}
+
+FTileData* FDungeonTileGraph::Find(const FIntVector& Coordinate)
+{
+	int32 Index = FindIndex(Coordinate);
+	return Index != INDEX_NONE ? &Tiles[Index] : nullptr;
+}
+
+const FTileData* FDungeonTileGraph::Find(const FIntVector& Coordinate) const
+{
+	int32 Index = FindIndex(Coordinate);
+	return Index != INDEX_NONE ? &Tiles[Index] : nullptr;
+}
+
+int32 FDungeonTileGraph::GetNeighborIndex(int32 Index, ECardinalDirection Direction) const
+{
+	return FindIndex(Tiles[Index].Coordinate + GetDirectionOffset(Direction));
+}
+
+void FDungeonTileGraph::Connect(int32 Index, ECardinalDirection Direction, int32 NeighborIndex)
+{
+	Tiles[Index].SetConnected(Direction, true);
+	Tiles[NeighborIndex].SetConnected(GetOppositeDirection(Direction), true);
+}
+
+FIntVector FDungeonTileGraph::GetDirectionOffset(ECardinalDirection Direction)
+{
+	switch (Direction)
+	{
+	case ECardinalDirection::North:
+		return FIntVector(1, 0, 0);
+	case ECardinalDirection::South:
+		return FIntVector(-1, 0, 0);
+	case ECardinalDirection::East:
+		return FIntVector(0, 1, 0);
+	case ECardinalDirection::West:
+		return FIntVector(0, -1, 0);
+	default:
+		return FIntVector(0, 0, 0);
+	}
+}
+
+ECardinalDirection FDungeonTileGraph::GetOppositeDirection(ECardinalDirection Direction)
+{
+	switch (Direction)
+	{
+	case ECardinalDirection::North:
+		return ECardinalDirection::South;
+	case ECardinalDirection::South:
+		return ECardinalDirection::North;
+	case ECardinalDirection::East:
+		return ECardinalDirection::West;
+	default:
+		return ECardinalDirection::East;
+	}
+}
+
+bool FDungeonTileGraph::GetDirectionFromOffset(const FIntVector& Offset, ECardinalDirection& OutDirection)
+{
+	for (uint8 DirectionIndex = 0; DirectionIndex < 4; DirectionIndex++)
+	{
+		if (GetDirectionOffset((ECardinalDirection)DirectionIndex) == Offset)
+		{
+			OutDirection = (ECardinalDirection)DirectionIndex;
+			return true;
+		}
+	}
+	return false;
+}
@@ -216,12 +216,7 @@ void ADungeonPlayerController::StartDraggingItem(UDraggableItemWidget* Draggable
 		OnBeginItemDrag.Broadcast(DraggedItem->GetItem());
 	}
 
-
-	UInventoryComponent* InventoryComponent = Cast<UInventoryComponent>(GetPawn()->GetComponentByClass(UInventoryComponent::StaticClass()));
-	if (InventoryComponent)
-	{
-		InventoryComponent->ServerRequestRemoveItemFromInventory(DraggedItem->GetItem());
-	}
+	// The dragged item stays in the inventory or equipment until it is dropped, nothing is sent to the server until then
 
 	ADungeonHUD* DungeonHUD = Cast<ADungeonHUD>(GetHUD());
 	if (DungeonHUD)
@@ -33,6 +33,31 @@ AEquippable* UEquipmentComponent::GetEquipmentInSlot(EEquipmentSlot Slot)
 }
 
 TArray<EEquipmentSlot> UEquipmentComponent::GetValidSlotsForEquippable(AEquippable* Equippable)
+{
+	TArray<EEquipmentSlot> ValidSlots = GetAllSlotsForEquippable(Equippable);
+	if (Cast<AWeapon>(Equippable))
+	{
+		AWeapon* MainHandWeapon = Cast<AWeapon>(GetEquipmentInSlot(EEquipmentSlot::WeaponLoadoutOneMainHand));
+		if (MainHandWeapon)
+		{
+			if (MainHandWeapon->GetWeaponHand() == EWeaponHand::TwoHand)
+			{
+				ValidSlots.Remove(EEquipmentSlot::WeaponLoadoutOneOffHand);
+			}
+		}
+		MainHandWeapon = Cast<AWeapon>(GetEquipmentInSlot(EEquipmentSlot::WeaponLoadoutTwoMainHand));
+		if (MainHandWeapon)
+		{
+			if (MainHandWeapon->GetWeaponHand() == EWeaponHand::TwoHand)
+			{
+				ValidSlots.Remove(EEquipmentSlot::WeaponLoadoutTwoOffHand);
+			}
+		}
+	}
+	return ValidSlots;
+}
+
+TArray<EEquipmentSlot> UEquipmentComponent::GetAllSlotsForEquippable(AEquippable* Equippable)
 {
 	TArray<EEquipmentSlot> ValidSlots;
 	AArmor* Armor = Cast<AArmor>(Equippable);
@@ -94,23 +119,6 @@ TArray<EEquipmentSlot> UEquipmentComponent::GetValidSlotsForEquippable(AEquippab
 		default:
 			break;
 		}
-
-		AWeapon* MainHandWeapon = Cast<AWeapon>(GetEquipmentInSlot(EEquipmentSlot::WeaponLoadoutOneMainHand));
-		if (MainHandWeapon)
-		{
-			if (MainHandWeapon->GetWeaponHand() == EWeaponHand::TwoHand)
-			{
-				ValidSlots.Remove(EEquipmentSlot::WeaponLoadoutOneOffHand);
-			}
-		}
-		MainHandWeapon = Cast<AWeapon>(GetEquipmentInSlot(EEquipmentSlot::WeaponLoadoutTwoMainHand));
-		if (MainHandWeapon)
-		{
-			if (MainHandWeapon->GetWeaponHand() == EWeaponHand::TwoHand)
-			{
-				ValidSlots.Remove(EEquipmentSlot::WeaponLoadoutTwoOffHand);
-			}
-		}
 	}
 	return ValidSlots;
 }
@@ -136,6 +144,16 @@ TArray<EEquipmentSlot>  UEquipmentComponent::GetOpenSlots(TArray<EEquipmentSlot>
 	return OpenSlots;
 }
 
+bool UEquipmentComponent::GetEquippedSlot(AEquippable* Equippable, EEquipmentSlot& OutSlot) const
+{
+	const EEquipmentSlot* SlotPtr = Equippable ? Equipment.FindKey(Equippable) : nullptr;
+	if (SlotPtr)
+	{
+		OutSlot = *SlotPtr;
+	}
+	return SlotPtr != nullptr;
+}
+
 FName UEquipmentComponent::GetNameForWeaponSocket(EWeaponSocketType WeaponSocketType)
 {
 	FName WeaponName = FName();
@@ -305,6 +323,47 @@ void UEquipmentComponent::MulticastOnItemUnequipped_Implementation(AEquippable*
 	OnItemUnequipped.Broadcast(Equippable, EquipmentSlot);
 }
 
+void UEquipmentComponent::GetSlotsToClearForEquip(AEquippable* Equippable, EEquipmentSlot Slot, const TMap<EEquipmentSlot, AEquippable*>& InEquipment, TArray<EEquipmentSlot>& OutSlots) const
+{
+	OutSlots.Reset();
+	if (InEquipment.FindRef(Slot))
+	{
+		OutSlots.Add(Slot);
+	}
+
+	AWeapon* Weapon = Cast<AWeapon>(Equippable);
+	if (Weapon)
+	{
+		EEquipmentSlot OtherHandSlot = Slot;
+		if (Weapon->GetWeaponHand() == EWeaponHand::TwoHand)
+		{
+			if (Slot == EEquipmentSlot::WeaponLoadoutOneMainHand)
+			{
+				OtherHandSlot = EEquipmentSlot::WeaponLoadoutOneOffHand;
+			}
+			else if (Slot == EEquipmentSlot::WeaponLoadoutTwoMainHand)
+			{
+				OtherHandSlot = EEquipmentSlot::WeaponLoadoutTwoOffHand;
+			}
+		}
+		else if (Slot == EEquipmentSlot::WeaponLoadoutOneOffHand)
+		{
+			OtherHandSlot = EEquipmentSlot::WeaponLoadoutOneMainHand;
+		}
+		else if (Slot == EEquipmentSlot::WeaponLoadoutTwoOffHand)
+		{
+			OtherHandSlot = EEquipmentSlot::WeaponLoadoutTwoMainHand;
+		}
+
+		// The main hand only has to be emptied for off hand items if it holds a two handed weapon
+		AWeapon* OtherHandWeapon = Cast<AWeapon>(InEquipment.FindRef(OtherHandSlot));
+		if (OtherHandSlot != Slot && OtherHandWeapon && (Weapon->GetWeaponHand() == EWeaponHand::TwoHand || OtherHandWeapon->GetWeaponHand() == EWeaponHand::TwoHand))
+		{
+			OutSlots.Add(OtherHandSlot);
+		}
+	}
+}
+
 AWeapon* UEquipmentComponent::GetOtherHandWeaponToUnequip(AWeapon* Weapon, EEquipmentSlot EquipmentSlot)
 {
 	// If equipping a two handed weapon, unequip anything in the off hand slot. If equipping an offhand, unequip any equipped two hander in the main hand slot.
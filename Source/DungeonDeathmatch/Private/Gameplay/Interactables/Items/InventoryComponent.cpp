@@ -8,30 +8,119 @@
 
 #include <DrawDebugHelpers.h>
 
+/** Most ops a client may send in one batch */
+#define MAX_INVENTORY_OPS	16
+
+FInventoryOp FInventoryOp::MakeMove(AItem* InItem, int32 InContainerId, FInventoryGridPair InOriginSlot)
+{
+	FInventoryOp Op;
+	Op.Type = EInventoryOpType::Move;
+	Op.Item = InItem;
+	Op.ContainerId = InContainerId;
+	Op.OriginSlot = InOriginSlot;
+	return Op;
+}
+
+FInventoryOp FInventoryOp::MakeSwap(AItem* InItem, int32 InContainerId, FInventoryGridPair InOriginSlot)
+{
+	FInventoryOp Op = MakeMove(InItem, InContainerId, InOriginSlot);
+	Op.Type = EInventoryOpType::Swap;
+	return Op;
+}
+
+FInventoryOp FInventoryOp::MakeEquip(AItem* InItem, EEquipmentSlot InEquipmentSlot)
+{
+	FInventoryOp Op;
+	Op.Type = EInventoryOpType::Equip;
+	Op.Item = InItem;
+	Op.EquipmentSlot = InEquipmentSlot;
+	return Op;
+}
+
+FInventoryOp FInventoryOp::MakeUnequip(AItem* InItem, EEquipmentSlot InEquipmentSlot, int32 InContainerId /*= INDEX_NONE*/, FInventoryGridPair InOriginSlot /*= FInventoryGridPair()*/)
+{
+	FInventoryOp Op = MakeMove(InItem, InContainerId, InOriginSlot);
+	Op.Type = EInventoryOpType::Unequip;
+	Op.EquipmentSlot = InEquipmentSlot;
+	return Op;
+}
+
+FInventoryOp FInventoryOp::MakeDrop(AItem* InItem)
+{
+	FInventoryOp Op;
+	Op.Type = EInventoryOpType::Drop;
+	Op.Item = InItem;
+	return Op;
+}
+
+void FInventoryItemEntry::PreReplicatedRemove(const FInventoryItemArray& InArraySerializer)
+{
+	if (InArraySerializer.OwningComponent)
+	{
+		InArraySerializer.OwningComponent->OnItemEntryRemoved(*this);
+	}
+}
+
+void FInventoryItemEntry::PostReplicatedAdd(const FInventoryItemArray& InArraySerializer)
+{
+	if (InArraySerializer.OwningComponent)
+	{
+		InArraySerializer.OwningComponent->OnItemEntryAdded(*this);
+	}
+}
+
+void FInventoryItemEntry::PostReplicatedChange(const FInventoryItemArray& InArraySerializer)
+{
+	if (InArraySerializer.OwningComponent)
+	{
+		InArraySerializer.OwningComponent->OnItemEntryChanged(*this);
+	}
+}
+
 UInventoryComponent::UInventoryComponent()
 {
 	bReplicates = true;
 	PrimaryComponentTick.bCanEverTick = true;
 
-	InventoryGridSize.Row = 5;
-	InventoryGridSize.Column = 6;
+	FInventoryContainer Backpack;
+	Backpack.ContainerName = FText::FromString("Backpack");
+	Backpack.GridSize = FInventoryGridPair(6, 5);
+	Containers.Add(Backpack);
+	bBestFitPlacement = false;
+
+	ItemEntries.OwningComponent = this;
 }
 
 void UInventoryComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	InventoryGrid = TArray<FInventoryGridSlot>();
-	InventoryGrid.AddDefaulted(InventoryGridSize.Row * InventoryGridSize.Column);
+	// Items replicated to the owning client before BeginPlay have already set up their containers
+	for (FInventoryContainer& Container : Containers)
+	{
+		if (!Container.IsGridInitialized())
+		{
+			Container.InitGrid();
+		}
+	}
 }
 
 void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(UInventoryComponent, Items);
-	DOREPLIFETIME(UInventoryComponent, InventoryGrid);
-	DOREPLIFETIME(UInventoryComponent, InventoryGridSize);
+	// Only the owner ever sees the inventory grid
+	DOREPLIFETIME_CONDITION(UInventoryComponent, ItemEntries, COND_OwnerOnly);
+}
+
+TArray<FInventoryGridSlot> UInventoryComponent::GetInventoryGrid(int32 ContainerId)
+{
+	return Containers.IsValidIndex(ContainerId) ? Containers[ContainerId].Grid : TArray<FInventoryGridSlot>();
+}
+
+FInventoryGridPair UInventoryComponent::GetInventoryGridSize(int32 ContainerId)
+{
+	return Containers.IsValidIndex(ContainerId) ? Containers[ContainerId].GridSize : FInventoryGridPair();
 }
 
 FVector UInventoryComponent::GetItemDropLocation()
@@ -39,6 +128,46 @@ FVector UInventoryComponent::GetItemDropLocation()
 	return GetOwner()->GetActorLocation() + GetOwner()->GetActorRotation().RotateVector(ItemDropRelativeLocation);
 }
 
+bool UInventoryComponent::GetItemLocation(AItem* Item, int32& OutContainerId, FInventoryGridPair& OutOriginSlot) const
+{
+	const FInventoryItemLocation* Location = ItemLocations.Find(Item);
+	if (Location)
+	{
+		OutContainerId = Location->ContainerId;
+		OutOriginSlot = Location->OriginSlot;
+	}
+	return Location != nullptr;
+}
+
+bool UInventoryComponent::IsGridAreaFree(int32 ContainerId, FInventoryGridPair OriginSlot, FInventoryGridPair Size) const
+{
+	return Containers.IsValidIndex(ContainerId) && Containers[ContainerId].Occupancy.IsAreaFree(OriginSlot.Column, OriginSlot.Row, Size.Column, Size.Row);
+}
+
+bool UInventoryComponent::FindFreeOriginSlot(FInventoryGridPair Size, int32& OutContainerId, FInventoryGridPair& OutOriginSlot) const
+{
+	for (int32 ContainerId = 0; ContainerId < Containers.Num(); ContainerId++)
+	{
+		// Containers that are full or too small are skipped without building any masks
+		const FInventoryContainer& Container = Containers[ContainerId];
+		if (!Container.bAcceptsAutoPlacement || Container.NumFreeSlots < Size.Column * Size.Row || Size.Column > Container.GridSize.Column || Size.Row > Container.GridSize.Row)
+		{
+			continue;
+		}
+
+		int32 Column = 0;
+		int32 Row = 0;
+		bool Result = bBestFitPlacement ? Container.Occupancy.FindBestFit(Size.Column, Size.Row, Column, Row) : Container.Occupancy.FindFirstFit(Size.Column, Size.Row, Column, Row);
+		if (Result)
+		{
+			OutContainerId = ContainerId;
+			OutOriginSlot = FInventoryGridPair(Column, Row);
+			return true;
+		}
+	}
+	return false;
+}
+
 void UInventoryComponent::ServerRequestAddItemToInventory_Implementation(AItem* Item)
 {
 	bool WasItemAdded = RequestAddItem(Item);
@@ -54,16 +183,16 @@ bool UInventoryComponent::ServerRequestAddItemToInventory_Validate(AItem* Item)
 	return Result;
 }
 
-void UInventoryComponent::ServerRequestAddItemToInventoryAtLocation_Implementation(AItem* Item, FInventoryGridPair OriginSlot)
+void UInventoryComponent::ServerRequestAddItemToInventoryAtLocation_Implementation(AItem* Item, int32 ContainerId, FInventoryGridPair OriginSlot)
 {
-	bool WasItemAdded = RequestAddItem(Item, OriginSlot);
+	bool WasItemAdded = RequestAddItem(Item, ContainerId, OriginSlot);
 	if (WasItemAdded)
 	{
 		Item->ServerDespawn();
 	}
 }
 
-bool UInventoryComponent::ServerRequestAddItemToInventoryAtLocation_Validate(AItem* Item, FInventoryGridPair OriginSlot)
+bool UInventoryComponent::ServerRequestAddItemToInventoryAtLocation_Validate(AItem* Item, int32 ContainerId, FInventoryGridPair OriginSlot)
 {
 	bool Result = ValidateItem(Item);
 	return Result;
@@ -75,105 +204,162 @@ bool UInventoryComponent::RequestAddItem(AItem* Item)
 
 	if (Item && GetOwner() && GetOwner()->HasAuthority())
 	{
-		// Go through every grid slot and it's surrounding slots to see if the item will fit.
-		FInventoryGridPair ItemSize = Item->GetGridSize();
-		if (ItemSize.Row <= InventoryGridSize.Row && ItemSize.Column <= InventoryGridSize.Column)
+		// The occupancy masks give every origin slot the item fits at in one pass, instead of testing the item's footprint at every slot
+		int32 ContainerId = INDEX_NONE;
+		FInventoryGridPair OriginSlot;
+		if (FindFreeOriginSlot(Item->GetGridSize(), ContainerId, OriginSlot))
 		{
-			for (int GridRowIndex = 0; GridRowIndex <= InventoryGridSize.Row; GridRowIndex++)
-			{
-				for (int GridColumnIndex = 0; GridColumnIndex <= InventoryGridSize.Column; GridColumnIndex++)
-				{
-					FInventoryGridPair OriginSlot = FInventoryGridPair(GridRowIndex, GridColumnIndex);
-					Result = RequestAddItem(Item, OriginSlot);
-					if (Result)
-					{
-						break;
-					}
-				}
-				if (Result)
-				{
-					break;
-				}
-			}
+			AddItem(Item, ContainerId, OriginSlot);
+			Result = true;
 		}
 	}
 
 	return Result;
 }
 
-bool UInventoryComponent::RequestAddItem(AItem* Item, FInventoryGridPair OriginSlot)
+bool UInventoryComponent::RequestAddItem(AItem* Item, int32 ContainerId, FInventoryGridPair OriginSlot)
 {
-	bool Result = true;
+	bool Result = false;
 
 	if (Item && GetOwner() && GetOwner()->HasAuthority())
 	{
-		FInventoryGridPair ItemSize = Item->GetGridSize();
-		uint8 ItemRowExtent = OriginSlot.Row + ItemSize.Row;
-		uint8 ItemColumnExtent = OriginSlot.Column + ItemSize.Column;
-
-		// Go through the selected grid slots once to determine if there is more than one item in the selection area, and if it is within the grid bounds
-		for (int GridRowIndex = OriginSlot.Row; GridRowIndex < ItemRowExtent; GridRowIndex++)
-		{
-			for (int GridColumnIndex = OriginSlot.Column; GridColumnIndex < ItemColumnExtent; GridColumnIndex++)
-			{
-				uint8 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumnIndex;
-				if (GridSlotIndex >= 0 && GridSlotIndex < InventoryGrid.Num())
-				{
-					FInventoryGridSlot& GridSlot = InventoryGrid[GridSlotIndex];
-					if (GridSlot.Item)
-					{
-						Result = false;
-						break;
-					}
-				}
-				else
-				{
-					Result = false;
-					break;
-				}
-			}
-			if (!Result)
-			{
-				break;
-			}
-		}
-
-		if (Result)
+		// Fails for invalid containers and selections that are out of the grid bounds or overlap another item
+		if (IsGridAreaFree(ContainerId, OriginSlot, Item->GetGridSize()))
 		{
-			AddItem(Item, OriginSlot);
+			AddItem(Item, ContainerId, OriginSlot);
+			Result = true;
 		}
 	}
 
 	return Result;
 }
 
-void UInventoryComponent::AddItem(AItem* Item, FInventoryGridPair &OriginSlot)
+void UInventoryComponent::AddItem(AItem* Item, int32 ContainerId, FInventoryGridPair &OriginSlot)
 {
-	Items.Add(Item);
+	// Entries are added and removed together with Items, so every item's index in Items is also the index of its entry
+	AddItemLocation(Item, ContainerId, OriginSlot);
+	const int32 EntryIndex = ItemEntries.Entries.Add(FInventoryItemEntry(Item, ContainerId, OriginSlot));
+	ItemEntries.MarkItemDirty(ItemEntries.Entries[EntryIndex]);
+
+	Item->SetOwner(GetOwner());
+	OnItemAdded.Broadcast(Item, ContainerId, OriginSlot);
+}
+
+void UInventoryComponent::AddItemLocation(AItem* Item, int32 ContainerId, const FInventoryGridPair& OriginSlot)
+{
+	FInventoryItemLocation Location;
+	Location.ContainerId = ContainerId;
+	Location.OriginSlot = OriginSlot;
+	Location.Size = Item->GetGridSize();
+	Location.ItemIndex = Items.Add(Item);
+	ItemLocations.Add(Item, Location);
+
+	PlaceItemInGrid(Item, ContainerId, OriginSlot);
+}
+
+bool UInventoryComponent::RemoveItemLocation(AItem* Item, FInventoryItemLocation& OutLocation)
+{
+	FInventoryItemLocation* Location = ItemLocations.Find(Item);
+	if (!Location)
+	{
+		return false;
+	}
+
+	OutLocation = *Location;
+	ItemLocations.Remove(Item);
+	ClearItemFromGrid(Item, OutLocation);
+
+	Items.RemoveAtSwap(OutLocation.ItemIndex);
+	if (OutLocation.ItemIndex < Items.Num())
+	{
+		ItemLocations.FindChecked(Items[OutLocation.ItemIndex]).ItemIndex = OutLocation.ItemIndex;
+	}
+	return true;
+}
+
+void UInventoryComponent::PlaceItemInGrid(AItem* Item, int32 ContainerId, const FInventoryGridPair& OriginSlot)
+{
+	if (!Containers.IsValidIndex(ContainerId))
+	{
+		return;
+	}
+
+	FInventoryContainer& Container = Containers[ContainerId];
+	if (!Container.IsGridInitialized())
+	{
+		Container.InitGrid();
+	}
 
-	// Update the grid data
 	FInventoryGridPair ItemSize = Item->GetGridSize();
-	uint8 ItemRowExtent = OriginSlot.Row + ItemSize.Row;
-	uint8 ItemColumnExtent = OriginSlot.Column + ItemSize.Column;
+	int32 ItemRowExtent = FMath::Min(OriginSlot.Row + ItemSize.Row, Container.GridSize.Row);
+	int32 ItemColumnExtent = FMath::Min(OriginSlot.Column + ItemSize.Column, Container.GridSize.Column);
 
-	for (int GridRowIndex = OriginSlot.Row; GridRowIndex < ItemRowExtent; GridRowIndex++)
+	for (int32 GridRowIndex = FMath::Max(OriginSlot.Row, 0); GridRowIndex < ItemRowExtent; GridRowIndex++)
 	{
-		for (int GridColumIndex = OriginSlot.Column; GridColumIndex < ItemColumnExtent; GridColumIndex++)
+		for (int32 GridColumIndex = FMath::Max(OriginSlot.Column, 0); GridColumIndex < ItemColumnExtent; GridColumIndex++)
 		{
-			uint8 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
-			FInventoryGridSlot& GridSlot = InventoryGrid[GridSlotIndex];
+			FInventoryGridSlot& GridSlot = Container.Grid[Container.GetGridSlotIndex(FInventoryGridPair(GridColumIndex, GridRowIndex))];
+			Container.NumFreeSlots -= GridSlot.Item ? 0 : 1;
 			GridSlot.Item = Item;
 			GridSlot.ItemOriginGridLocation = OriginSlot;
 		}
 	}
+	Container.Occupancy.FillArea(OriginSlot.Column, OriginSlot.Row, ItemSize.Column, ItemSize.Row);
+}
+
+void UInventoryComponent::OnItemEntryAdded(const FInventoryItemEntry& Entry)
+{
+	// Item references to actors the client doesn't know yet arrive as null, the entry is changed again once they resolve
+	if (!Entry.Item)
+	{
+		return;
+	}
 
-	Item->SetOwner(GetOwner());
-	MulticastOnItemAdded(Item, OriginSlot);
+	// Items the client already predicted at this location are left alone, items predicted elsewhere are moved
+	const FInventoryItemLocation* Location = ItemLocations.Find(Entry.Item);
+	if (Location && Location->ContainerId == Entry.ContainerId && Location->OriginSlot == Entry.OriginSlot)
+	{
+		return;
+	}
+	if (Location)
+	{
+		OnItemEntryRemoved(Entry);
+	}
+
+	AddItemLocation(Entry.Item, Entry.ContainerId, Entry.OriginSlot);
+	OnItemAdded.Broadcast(Entry.Item, Entry.ContainerId, Entry.OriginSlot);
+}
+
+void UInventoryComponent::OnItemEntryRemoved(const FInventoryItemEntry& Entry)
+{
+	FInventoryItemLocation Location;
+	if (Entry.Item && RemoveItemLocation(Entry.Item, Location))
+	{
+		OnItemRemoved.Broadcast(Entry.Item, Location.ContainerId, Location.OriginSlot);
+	}
 }
 
-void UInventoryComponent::MulticastOnItemAdded_Implementation(AItem* Item, FInventoryGridPair OriginSlot)
+void UInventoryComponent::OnItemEntryChanged(const FInventoryItemEntry& Entry)
 {
-	OnItemAdded.Broadcast(Item, OriginSlot);
+	OnItemEntryAdded(Entry);
+}
+
+void UInventoryComponent::RebuildFromEntries()
+{
+	TArray<AItem*> ItemsToRemove = Items;
+	for (AItem* Item : ItemsToRemove)
+	{
+		FInventoryItemLocation Location;
+		if (RemoveItemLocation(Item, Location))
+		{
+			OnItemRemoved.Broadcast(Item, Location.ContainerId, Location.OriginSlot);
+		}
+	}
+
+	for (const FInventoryItemEntry& Entry : ItemEntries.Entries)
+	{
+		OnItemEntryAdded(Entry);
+	}
 }
 
 void UInventoryComponent::ServerRequestRemoveItemFromInventory_Implementation(AItem* Item)
@@ -193,49 +379,466 @@ bool UInventoryComponent::RequestRemoveItem(AItem* Item)
 
 	if (GetOwner() && GetOwner()->HasAuthority())
 	{
-		for (int32 ItemIndex = 0; ItemIndex < Items.Num(); ItemIndex++)
+		const FInventoryItemLocation* Location = ItemLocations.Find(Item);
+		if (Location)
+		{
+			RemoveItem(Location->ItemIndex);
+			Result = true;
+		}
+	}
+
+	return Result;
+}
+
+void UInventoryComponent::SetItemLocation(AItem* Item, int32 ContainerId, const FInventoryGridPair& OriginSlot)
+{
+	FInventoryItemLocation& Location = ItemLocations.FindChecked(Item);
+	Location.ContainerId = ContainerId;
+	Location.OriginSlot = OriginSlot;
+	Location.Size = Item->GetGridSize();
+	PlaceItemInGrid(Item, ContainerId, OriginSlot);
+
+	if (GetOwner() && GetOwner()->HasAuthority())
+	{
+		FInventoryItemEntry& Entry = ItemEntries.Entries[Location.ItemIndex];
+		Entry.ContainerId = ContainerId;
+		Entry.OriginSlot = OriginSlot;
+		ItemEntries.MarkItemDirty(Entry);
+	}
+}
+
+void UInventoryComponent::RemoveItem(int32 ItemIndex)
+{
+	AItem* ItemToRemove = Items[ItemIndex];
+
+	FInventoryItemLocation Location;
+	RemoveItemLocation(ItemToRemove, Location);
+	ItemEntries.Entries.RemoveAtSwap(ItemIndex);
+	ItemEntries.MarkArrayDirty();
+
+	ItemToRemove->SetOwner(nullptr);
+	OnItemRemoved.Broadcast(ItemToRemove, Location.ContainerId, Location.OriginSlot);
+}
+
+void UInventoryComponent::ClearItemFromGrid(AItem* Item, const FInventoryItemLocation& Location)
+{
+	if (!Containers.IsValidIndex(Location.ContainerId) || !Containers[Location.ContainerId].IsGridInitialized())
+	{
+		return;
+	}
+
+	FInventoryContainer& Container = Containers[Location.ContainerId];
+	int32 ItemRowExtent = FMath::Min(Location.OriginSlot.Row + Location.Size.Row, Container.GridSize.Row);
+	int32 ItemColumnExtent = FMath::Min(Location.OriginSlot.Column + Location.Size.Column, Container.GridSize.Column);
+
+	for (int32 GridRowIndex = FMath::Max(Location.OriginSlot.Row, 0); GridRowIndex < ItemRowExtent; GridRowIndex++)
+	{
+		for (int32 GridColumIndex = FMath::Max(Location.OriginSlot.Column, 0); GridColumIndex < ItemColumnExtent; GridColumIndex++)
 		{
-			if (Items[ItemIndex] == Item)
+			// Slots another item was already placed over by a replicated move are left to that item
+			FInventoryGridSlot& GridSlot = Container.Grid[Container.GetGridSlotIndex(FInventoryGridPair(GridColumIndex, GridRowIndex))];
+			if (GridSlot.Item == Item)
+			{
+				Container.NumFreeSlots++;
+				GridSlot.Item = nullptr;
+				GridSlot.ItemOriginGridLocation = FInventoryGridPair(GridColumIndex, GridRowIndex);
+				Container.Occupancy.ClearArea(GridColumIndex, GridRowIndex, 1, 1);
+			}
+		}
+	}
+}
+
+bool UInventoryComponent::ExecuteInventoryOps(const TArray<FInventoryOp>& Ops)
+{
+	bool Result = false;
+
+	if (GetOwner() && Ops.Num() > 0)
+	{
+		// The owning client runs the same simulation as the server, so it shows the result without waiting for the server
+		TMap<AItem*, FInventoryItemLocation> ChangedLocations;
+		TMap<EEquipmentSlot, AEquippable*> NewEquipment;
+		Result = SimulateInventoryOps(Ops, ChangedLocations, NewEquipment);
+		if (Result)
+		{
+			ApplyInventoryState(ChangedLocations, NewEquipment, GetEquipmentComponent());
+			if (!GetOwner()->HasAuthority())
+			{
+				ServerExecuteInventoryOps(Ops);
+			}
+		}
+	}
+
+	return Result;
+}
+
+void UInventoryComponent::ServerExecuteInventoryOps_Implementation(const TArray<FInventoryOp>& Ops)
+{
+	bool WereOpsApplied = ExecuteInventoryOps(Ops);
+	if (!WereOpsApplied)
+	{
+		ClientRejectInventoryOps();
+	}
+}
+
+bool UInventoryComponent::ServerExecuteInventoryOps_Validate(const TArray<FInventoryOp>& Ops)
+{
+	bool Result = Ops.Num() <= MAX_INVENTORY_OPS;
+	for (const FInventoryOp& Op : Ops)
+	{
+		Result = Result && (!Op.Item || ValidateItem(Op.Item));
+	}
+	return Result;
+}
+
+void UInventoryComponent::ClientRejectInventoryOps_Implementation()
+{
+	UE_LOG(LogTemp, Log, TEXT("UInventoryComponent::ClientRejectInventoryOps - Server rejected inventory ops of %s, rebuilding from replicated items."), *GetOwner()->GetName());
+	RebuildFromEntries();
+}
+
+bool UInventoryComponent::SimulateInventoryOps(const TArray<FInventoryOp>& Ops, TMap<AItem*, FInventoryItemLocation>& OutChangedLocations, TMap<EEquipmentSlot, AEquippable*>& OutEquipment)
+{
+	UEquipmentComponent* EquipmentComponent = GetEquipmentComponent();
+	OutEquipment.Reset();
+	if (EquipmentComponent)
+	{
+		OutEquipment = EquipmentComponent->Equipment;
+	}
+
+	// The ops run on the real grids so they use the same placement queries as single adds and moves. Every lift and placement is
+	// recorded and undone in reverse afterwards, so a batch only touches the footprints of its items no matter how big the grids are.
+	SimulationChanges.Reset();
+
+	bool Result = true;
+	for (int32 OpIndex = 0; OpIndex < Ops.Num() && Result; OpIndex++)
+	{
+		Result = SimulateInventoryOp(Ops[OpIndex], EquipmentComponent, OutEquipment);
+	}
+
+	OutChangedLocations.Reset();
+	for (const FInventorySimulationChange& Change : SimulationChanges)
+	{
+		if (!OutChangedLocations.Contains(Change.Item))
+		{
+			const FInventoryItemLocation* Location = ItemLocations.Find(Change.Item);
+			OutChangedLocations.Add(Change.Item, Location ? *Location : FInventoryItemLocation());
+		}
+	}
+
+	for (int32 ChangeIndex = SimulationChanges.Num() - 1; ChangeIndex >= 0; ChangeIndex--)
+	{
+		const FInventorySimulationChange& Change = SimulationChanges[ChangeIndex];
+		if (Change.bWasPlaced)
+		{
+			ItemLocations.Remove(Change.Item);
+			ClearItemFromGrid(Change.Item, Change.Location);
+		}
+		else
+		{
+			ItemLocations.Add(Change.Item, Change.Location);
+			PlaceItemInGrid(Change.Item, Change.Location.ContainerId, Change.Location.OriginSlot);
+		}
+	}
+	SimulationChanges.Reset();
+
+	return Result;
+}
+
+bool UInventoryComponent::SimulateInventoryOp(const FInventoryOp& Op, UEquipmentComponent* EquipmentComponent, TMap<EEquipmentSlot, AEquippable*>& Equipment)
+{
+	bool Result = false;
+	FInventoryItemLocation OldLocation;
+
+	switch (Op.Type)
+	{
+	case EInventoryOpType::Move:
+		Result = LiftItem(Op.Item, OldLocation) && TryPlaceItem(Op.Item, Op.ContainerId, Op.OriginSlot);
+		break;
+	case EInventoryOpType::Swap:
+		if (LiftItem(Op.Item, OldLocation))
+		{
+			AItem* OtherItem = GetSingleItemInArea(Op.ContainerId, Op.OriginSlot, Op.Item->GetGridSize());
+			FInventoryItemLocation OtherLocation;
+			Result = OtherItem && LiftItem(OtherItem, OtherLocation) && TryPlaceItem(Op.Item, Op.ContainerId, Op.OriginSlot);
+			Result = Result && (TryPlaceItem(OtherItem, OldLocation.ContainerId, OldLocation.OriginSlot) || TryPlaceItem(OtherItem, INDEX_NONE, FInventoryGridPair()));
+		}
+		break;
+	case EInventoryOpType::Equip:
+		{
+			AEquippable* Equippable = Cast<AEquippable>(Op.Item);
+			if (!Equippable || !EquipmentComponent || !EquipmentComponent->GetAllSlotsForEquippable(Equippable).Contains(Op.EquipmentSlot))
 			{
-				RemoveItem(ItemIndex);
-				Result = true;
 				break;
 			}
+
+			// Equipment moved from another slot is taken straight out of that slot, anything else has to come from the inventory
+			const EEquipmentSlot* EquippedSlot = Equipment.FindKey(Equippable);
+			const bool WasEquipped = EquippedSlot != nullptr;
+			const EEquipmentSlot SourceSlot = WasEquipped ? *EquippedSlot : Op.EquipmentSlot;
+			if (WasEquipped)
+			{
+				Equipment.Remove(SourceSlot);
+				Result = true;
+			}
+			else
+			{
+				Result = LiftItem(Equippable, OldLocation);
+			}
+
+			// Replaced equipment moves into the slot the equipped item came from if it can, otherwise it is put back where the
+			// equipped item was in the inventory or in the first free slot. The op fails rather than dropping it if it fits nowhere.
+			TArray<EEquipmentSlot> SlotsToClear;
+			if (Result)
+			{
+				EquipmentComponent->GetSlotsToClearForEquip(Equippable, Op.EquipmentSlot, Equipment, SlotsToClear);
+			}
+			for (EEquipmentSlot SlotToClear : SlotsToClear)
+			{
+				AEquippable* ReplacedEquippable = Equipment.FindAndRemoveChecked(SlotToClear);
+				TArray<EEquipmentSlot> SourceSlotsToClear;
+				if (WasEquipped && SourceSlot != Op.EquipmentSlot && EquipmentComponent->GetAllSlotsForEquippable(ReplacedEquippable).Contains(SourceSlot))
+				{
+					EquipmentComponent->GetSlotsToClearForEquip(ReplacedEquippable, SourceSlot, Equipment, SourceSlotsToClear);
+					if (SourceSlotsToClear.Num() == 0)
+					{
+						Equipment.Add(SourceSlot, ReplacedEquippable);
+						continue;
+					}
+				}
+				Result = Result && (TryPlaceItem(ReplacedEquippable, OldLocation.ContainerId, OldLocation.OriginSlot) || TryPlaceItem(ReplacedEquippable, INDEX_NONE, FInventoryGridPair()));
+			}
+
+			if (Result)
+			{
+				Equipment.Add(Op.EquipmentSlot, Equippable);
+			}
+		}
+		break;
+	case EInventoryOpType::Unequip:
+		if (Op.Item && Equipment.FindRef(Op.EquipmentSlot) == Op.Item)
+		{
+			// Items unequipped to the first free slot are dropped if they fit nowhere, items unequipped to a slot have to fit there
+			Equipment.Remove(Op.EquipmentSlot);
+			Result = TryPlaceItem(Op.Item, Op.ContainerId, Op.OriginSlot) || Op.ContainerId == INDEX_NONE;
+		}
+		break;
+	case EInventoryOpType::Drop:
+		{
+			// Items that are neither in the inventory nor equipped after the batch are dropped when it is applied
+			const EEquipmentSlot* EquippedSlot = Equipment.FindKey(Cast<AEquippable>(Op.Item));
+			if (Op.Item && EquippedSlot)
+			{
+				Equipment.Remove(*EquippedSlot);
+				Result = true;
+			}
+			else
+			{
+				Result = LiftItem(Op.Item, OldLocation);
+			}
 		}
+		break;
+	default:
+		break;
 	}
 
 	return Result;
 }
 
-void UInventoryComponent::RemoveItem(int32 ItemIndex)
+bool UInventoryComponent::LiftItem(AItem* Item, FInventoryItemLocation& OutLocation)
 {
-	AItem* ItemToRemove = Items[ItemIndex];
-	Items.RemoveAtSwap(ItemIndex);
+	const FInventoryItemLocation* Location = ItemLocations.Find(Item);
+	if (!Location)
+	{
+		return false;
+	}
+
+	OutLocation = *Location;
+	ItemLocations.Remove(Item);
+	ClearItemFromGrid(Item, OutLocation);
+	SimulationChanges.Add(FInventorySimulationChange(Item, OutLocation, false));
+	return true;
+}
 
-	// Find first slot containing the item, this will be the origin to broadcast
-	FInventoryGridPair OriginSlot;
-	bool OriginFound = false;
-	for (int GridRowIndex = 0; GridRowIndex < InventoryGridSize.Row; GridRowIndex++)
+bool UInventoryComponent::TryPlaceItem(AItem* Item, int32 ContainerId, const FInventoryGridPair& OriginSlot)
+{
+	bool Result = false;
+
+	if (Item)
+	{
+		FInventoryItemLocation Location;
+		Location.ContainerId = ContainerId;
+		Location.OriginSlot = OriginSlot;
+		Location.Size = Item->GetGridSize();
+		if (ContainerId == INDEX_NONE)
+		{
+			Result = FindFreeOriginSlot(Location.Size, Location.ContainerId, Location.OriginSlot);
+		}
+		else
+		{
+			Result = IsGridAreaFree(ContainerId, OriginSlot, Location.Size);
+		}
+
+		if (Result)
+		{
+			ItemLocations.Add(Item, Location);
+			PlaceItemInGrid(Item, Location.ContainerId, Location.OriginSlot);
+			SimulationChanges.Add(FInventorySimulationChange(Item, Location, true));
+		}
+	}
+
+	return Result;
+}
+
+AItem* UInventoryComponent::GetSingleItemInArea(int32 ContainerId, const FInventoryGridPair& OriginSlot, const FInventoryGridPair& Size) const
+{
+	if (!Containers.IsValidIndex(ContainerId) || !Containers[ContainerId].IsGridInitialized())
+	{
+		return nullptr;
+	}
+
+	const FInventoryContainer& Container = Containers[ContainerId];
+	int32 AreaRowExtent = FMath::Min(OriginSlot.Row + Size.Row, Container.GridSize.Row);
+	int32 AreaColumnExtent = FMath::Min(OriginSlot.Column + Size.Column, Container.GridSize.Column);
+
+	AItem* Result = nullptr;
+	for (int32 GridRowIndex = FMath::Max(OriginSlot.Row, 0); GridRowIndex < AreaRowExtent; GridRowIndex++)
+	{
+		for (int32 GridColumIndex = FMath::Max(OriginSlot.Column, 0); GridColumIndex < AreaColumnExtent; GridColumIndex++)
+		{
+			AItem* SlotItem = Container.Grid[Container.GetGridSlotIndex(FInventoryGridPair(GridColumIndex, GridRowIndex))].Item;
+			if (SlotItem && Result && SlotItem != Result)
+			{
+				return nullptr;
+			}
+			Result = SlotItem ? SlotItem : Result;
+		}
+	}
+	return Result;
+}
+
+void UInventoryComponent::ApplyInventoryState(const TMap<AItem*, FInventoryItemLocation>& ChangedLocations, const TMap<EEquipmentSlot, AEquippable*>& NewEquipment, UEquipmentComponent* EquipmentComponent)
+{
+	const bool bIsServer = GetOwner()->HasAuthority();
+
+	TArray<AEquippable*> NewEquippedItems;
+	NewEquipment.GenerateValueArray(NewEquippedItems);
+
+	TArray<AItem*> LeavingItems;
+	TArray<AItem*> MovedItems;
+	TArray<AItem*> EnteringItems;
+	for (const TPair<AItem*, FInventoryItemLocation>& ChangedLocation : ChangedLocations)
+	{
+		const FInventoryItemLocation* OldLocation = ItemLocations.Find(ChangedLocation.Key);
+		const FInventoryItemLocation& NewLocation = ChangedLocation.Value;
+		if (!OldLocation)
+		{
+			if (NewLocation.ContainerId != INDEX_NONE)
+			{
+				EnteringItems.Add(ChangedLocation.Key);
+			}
+		}
+		else if (NewLocation.ContainerId == INDEX_NONE)
+		{
+			LeavingItems.Add(ChangedLocation.Key);
+		}
+		else if (NewLocation.ContainerId != OldLocation->ContainerId || NewLocation.OriginSlot != OldLocation->OriginSlot)
+		{
+			MovedItems.Add(ChangedLocation.Key);
+		}
+	}
+
+	// Equipment coming off is unequipped before it enters the inventory, so it never has two owners
+	TArray<AEquippable*> UnequippedItems;
+	if (bIsServer && EquipmentComponent)
+	{
+		TMap<EEquipmentSlot, AEquippable*> OldEquipment = EquipmentComponent->Equipment;
+		for (const TPair<EEquipmentSlot, AEquippable*>& EquippedItem : OldEquipment)
+		{
+			if (NewEquipment.FindRef(EquippedItem.Key) != EquippedItem.Value && EquipmentComponent->RequestUnequipItem(EquippedItem.Value, EquippedItem.Key))
+			{
+				UnequippedItems.Add(EquippedItem.Value);
+			}
+		}
+	}
+
+	for (AItem* Item : LeavingItems)
+	{
+		if (bIsServer)
+		{
+			// Items leaving the inventory without being equipped were dropped
+			if (RequestRemoveItem(Item) && !NewEquippedItems.Contains(Item))
+			{
+				Item->ServerSpawnAtLocation(GetItemDropLocation());
+			}
+		}
+		else
+		{
+			FInventoryItemLocation Location;
+			RemoveItemLocation(Item, Location);
+			OnItemRemoved.Broadcast(Item, Location.ContainerId, Location.OriginSlot);
+		}
+	}
+
+	// Every moved item is lifted before any of them is placed again, so swapped items never overwrite each other's slots
+	for (AItem* Item : MovedItems)
+	{
+		const FInventoryItemLocation& Location = ItemLocations.FindChecked(Item);
+		ClearItemFromGrid(Item, Location);
+		OnItemRemoved.Broadcast(Item, Location.ContainerId, Location.OriginSlot);
+	}
+	for (AItem* Item : MovedItems)
+	{
+		const FInventoryItemLocation& NewLocation = ChangedLocations.FindChecked(Item);
+		SetItemLocation(Item, NewLocation.ContainerId, NewLocation.OriginSlot);
+		OnItemAdded.Broadcast(Item, NewLocation.ContainerId, NewLocation.OriginSlot);
+	}
+
+	for (AItem* Item : EnteringItems)
 	{
-		for (int GridColumIndex = 0; GridColumIndex < InventoryGridSize.Column; GridColumIndex++)
+		FInventoryItemLocation NewLocation = ChangedLocations.FindChecked(Item);
+		if (bIsServer)
 		{
-			uint8 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
-			FInventoryGridSlot& GridSlot = InventoryGrid[GridSlotIndex];
-			if (GridSlot.Item && GridSlot.Item == ItemToRemove)
+			AddItem(Item, NewLocation.ContainerId, NewLocation.OriginSlot);
+		}
+		else
+		{
+			AddItemLocation(Item, NewLocation.ContainerId, NewLocation.OriginSlot);
+			OnItemAdded.Broadcast(Item, NewLocation.ContainerId, NewLocation.OriginSlot);
+		}
+	}
+
+	if (bIsServer && EquipmentComponent)
+	{
+		for (const TPair<EEquipmentSlot, AEquippable*>& EquippedItem : NewEquipment)
+		{
+			if (EquipmentComponent->GetEquipmentInSlot(EquippedItem.Key) != EquippedItem.Value && EquipmentComponent->RequestEquipItem(EquippedItem.Value, EquippedItem.Key))
 			{
-				if (!OriginFound)
+				// Don't "despawn" weapons since they need to be directly attached to the character mesh
+				if (!Cast<AWeapon>(EquippedItem.Value))
 				{
-					OriginSlot = FInventoryGridPair(GridColumIndex, GridRowIndex);
-					OriginFound = true;
+					EquippedItem.Value->ServerDespawn();
 				}
-				GridSlot.Item = nullptr;
-				GridSlot.ItemOriginGridLocation = FInventoryGridPair(GridColumIndex, GridRowIndex);
+			}
+		}
+
+		// Unequipped items that made it into the inventory are hidden again, the ones that fit nowhere are dropped
+		for (AEquippable* Equippable : UnequippedItems)
+		{
+			if (ChangedLocations.FindRef(Equippable).ContainerId != INDEX_NONE)
+			{
+				Equippable->ServerDespawn();
+			}
+			else if (!NewEquippedItems.Contains(Equippable))
+			{
+				Equippable->ServerSpawnAtLocation(GetItemDropLocation());
 			}
 		}
 	}
+}
 
-	ItemToRemove->SetOwner(nullptr);
-	MulticastOnItemRemoved(ItemToRemove, OriginSlot);
+UEquipmentComponent* UInventoryComponent::GetEquipmentComponent() const
+{
+	return GetOwner() ? Cast<UEquipmentComponent>(GetOwner()->GetComponentByClass(UEquipmentComponent::StaticClass())) : nullptr;
 }
 
 bool UInventoryComponent::ValidateItem(AItem* Item)
@@ -249,11 +852,6 @@ bool UInventoryComponent::ValidateItem(AItem* Item)
 	return Result;
 }
 
-void UInventoryComponent::MulticastOnItemRemoved_Implementation(AItem* Item, FInventoryGridPair OriginSlot)
-{
-	OnItemRemoved.Broadcast(Item, OriginSlot);
-}
-
 void UInventoryComponent::ServerRequestPickUpItem_Implementation(AItem* Item)
 {
 	bool WasItemAdded = false;
@@ -0,0 +1,240 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "InventoryOccupancy.h"
+
+namespace
+{
+	int32 CountSetBits(uint64 Bits)
+	{
+		Bits = Bits - ((Bits >> 1) & 0x5555555555555555ull);
+		Bits = (Bits & 0x3333333333333333ull) + ((Bits >> 2) & 0x3333333333333333ull);
+		Bits = (Bits + (Bits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return (int32)((Bits * 0x0101010101010101ull) >> 56);
+	}
+
+	/** Index of the lowest set bit, Bits must not be 0 */
+	int32 GetLowestSetBit(uint64 Bits)
+	{
+		const uint32 LowBits = (uint32)Bits;
+		return LowBits != 0 ? (int32)FMath::CountTrailingZeros(LowBits) : 32 + (int32)FMath::CountTrailingZeros((uint32)(Bits >> 32));
+	}
+
+	/** ANDs a row of words with itself shifted down by Shift columns, so bit c stays set only if bit c + Shift was set as well */
+	void AndShiftedRow(uint64* Words, int32 NumWords, int32 Shift)
+	{
+		const int32 WordShift = Shift / 64;
+		const int32 BitShift = Shift % 64;
+		// Every word only reads itself and the words after it, so the row can be updated in place front to back
+		for (int32 WordIndex = 0; WordIndex < NumWords; WordIndex++)
+		{
+			const int32 SourceIndex = WordIndex + WordShift;
+			const uint64 Low = SourceIndex < NumWords ? Words[SourceIndex] : 0;
+			const uint64 High = SourceIndex + 1 < NumWords ? Words[SourceIndex + 1] : 0;
+			Words[WordIndex] &= BitShift == 0 ? Low : (Low >> BitShift) | (High << (64 - BitShift));
+		}
+	}
+}
+
+FInventoryOccupancy::FInventoryOccupancy()
+{
+	NumColumns = 0;
+	NumRows = 0;
+	WordsPerRow = 0;
+}
+
+void FInventoryOccupancy::Init(int32 InNumColumns, int32 InNumRows)
+{
+	NumColumns = FMath::Max(InNumColumns, 0);
+	NumRows = FMath::Max(InNumRows, 0);
+	WordsPerRow = (NumColumns + 63) / 64;
+	RowMasks.Reset();
+	RowMasks.SetNumZeroed(WordsPerRow * NumRows);
+}
+
+void FInventoryOccupancy::Reset()
+{
+	FMemory::Memzero(RowMasks.GetData(), RowMasks.Num() * sizeof(uint64));
+}
+
+bool FInventoryOccupancy::IsSlotOccupied(int32 Column, int32 Row) const
+{
+	if (Column < 0 || Column >= NumColumns || Row < 0 || Row >= NumRows)
+	{
+		return false;
+	}
+	return (RowMasks[Row * WordsPerRow + Column / 64] & (1ull << (Column % 64))) != 0;
+}
+
+bool FInventoryOccupancy::IsAreaFree(int32 Column, int32 Row, int32 Width, int32 Height) const
+{
+	if (Width <= 0 || Height <= 0 || Column < 0 || Row < 0 || Column + Width > NumColumns || Row + Height > NumRows)
+	{
+		return false;
+	}
+
+	const int32 FirstWord = Column / 64;
+	const int32 LastWord = (Column + Width - 1) / 64;
+	for (int32 RowIndex = Row; RowIndex < Row + Height; RowIndex++)
+	{
+		const uint64* Words = &RowMasks[RowIndex * WordsPerRow];
+		for (int32 WordIndex = FirstWord; WordIndex <= LastWord; WordIndex++)
+		{
+			if (Words[WordIndex] & GetWordMask(WordIndex, Column, Width))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void FInventoryOccupancy::FillArea(int32 Column, int32 Row, int32 Width, int32 Height)
+{
+	SetArea(Column, Row, Width, Height, true);
+}
+
+void FInventoryOccupancy::ClearArea(int32 Column, int32 Row, int32 Width, int32 Height)
+{
+	SetArea(Column, Row, Width, Height, false);
+}
+
+void FInventoryOccupancy::SetArea(int32 Column, int32 Row, int32 Width, int32 Height, bool bOccupied)
+{
+	const int32 MinColumn = FMath::Max(Column, 0);
+	const int32 MaxColumn = FMath::Min(Column + Width, NumColumns);
+	const int32 MinRow = FMath::Max(Row, 0);
+	const int32 MaxRow = FMath::Min(Row + Height, NumRows);
+	if (MinColumn >= MaxColumn || MinRow >= MaxRow)
+	{
+		return;
+	}
+
+	const int32 FirstWord = MinColumn / 64;
+	const int32 LastWord = (MaxColumn - 1) / 64;
+	for (int32 RowIndex = MinRow; RowIndex < MaxRow; RowIndex++)
+	{
+		uint64* Words = &RowMasks[RowIndex * WordsPerRow];
+		for (int32 WordIndex = FirstWord; WordIndex <= LastWord; WordIndex++)
+		{
+			const uint64 Mask = GetWordMask(WordIndex, MinColumn, MaxColumn - MinColumn);
+			Words[WordIndex] = bOccupied ? Words[WordIndex] | Mask : Words[WordIndex] & ~Mask;
+		}
+	}
+}
+
+void FInventoryOccupancy::BuildFitMasks(int32 Width, int32 Height, TArray<uint64>& OutFitMasks) const
+{
+	OutFitMasks.Reset();
+	OutFitMasks.SetNumZeroed(WordsPerRow * NumRows);
+	if (Width <= 0 || Height <= 0 || Width > NumColumns || Height > NumRows)
+	{
+		return;
+	}
+
+	// Free slots of every row, then doubling shifts leave a bit set only where Width free slots start. Columns past the end of
+	// the grid are never free, so runs can't reach past the last column.
+	TArray<uint64> RowRuns;
+	RowRuns.SetNumUninitialized(WordsPerRow * NumRows);
+	for (int32 RowIndex = 0; RowIndex < NumRows; RowIndex++)
+	{
+		uint64* Runs = &RowRuns[RowIndex * WordsPerRow];
+		for (int32 WordIndex = 0; WordIndex < WordsPerRow; WordIndex++)
+		{
+			Runs[WordIndex] = ~RowMasks[RowIndex * WordsPerRow + WordIndex] & GetWordMask(WordIndex, 0, NumColumns);
+		}
+		for (int32 RunLength = 1; RunLength < Width; )
+		{
+			const int32 Shift = FMath::Min(RunLength, Width - RunLength);
+			AndShiftedRow(Runs, WordsPerRow, Shift);
+			RunLength += Shift;
+		}
+	}
+
+	// An item fits at an origin if the runs of every row it covers start there
+	for (int32 RowIndex = 0; RowIndex + Height <= NumRows; RowIndex++)
+	{
+		uint64* FitMask = &OutFitMasks[RowIndex * WordsPerRow];
+		for (int32 WordIndex = 0; WordIndex < WordsPerRow; WordIndex++)
+		{
+			uint64 Fits = RowRuns[RowIndex * WordsPerRow + WordIndex];
+			for (int32 CoveredRow = RowIndex + 1; CoveredRow < RowIndex + Height && Fits != 0; CoveredRow++)
+			{
+				Fits &= RowRuns[CoveredRow * WordsPerRow + WordIndex];
+			}
+			FitMask[WordIndex] = Fits;
+		}
+	}
+}
+
+bool FInventoryOccupancy::FindFirstFit(int32 Width, int32 Height, int32& OutColumn, int32& OutRow) const
+{
+	TArray<uint64> FitMasks;
+	BuildFitMasks(Width, Height, FitMasks);
+	for (int32 MaskIndex = 0; MaskIndex < FitMasks.Num(); MaskIndex++)
+	{
+		if (FitMasks[MaskIndex] != 0)
+		{
+			OutRow = MaskIndex / WordsPerRow;
+			OutColumn = (MaskIndex % WordsPerRow) * 64 + GetLowestSetBit(FitMasks[MaskIndex]);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FInventoryOccupancy::FindBestFit(int32 Width, int32 Height, int32& OutColumn, int32& OutRow) const
+{
+	TArray<uint64> FitMasks;
+	BuildFitMasks(Width, Height, FitMasks);
+
+	const int32 MaxContacts = (Width + Height) * 2;
+	int32 BestContacts = -1;
+	for (int32 MaskIndex = 0; MaskIndex < FitMasks.Num() && BestContacts < MaxContacts; MaskIndex++)
+	{
+		uint64 Fits = FitMasks[MaskIndex];
+		while (Fits != 0 && BestContacts < MaxContacts)
+		{
+			const int32 Bit = GetLowestSetBit(Fits);
+			Fits &= Fits - 1;
+
+			const int32 Row = MaskIndex / WordsPerRow;
+			const int32 Column = (MaskIndex % WordsPerRow) * 64 + Bit;
+			const int32 Contacts = CountContacts(Column, Row, Width, Height);
+			if (Contacts > BestContacts)
+			{
+				BestContacts = Contacts;
+				OutColumn = Column;
+				OutRow = Row;
+			}
+		}
+	}
+	return BestContacts >= 0;
+}
+
+int32 FInventoryOccupancy::CountContacts(int32 Column, int32 Row, int32 Width, int32 Height) const
+{
+	int32 Contacts = 0;
+
+	// Slots beside the area, one bit test per row on each side
+	for (int32 RowIndex = Row; RowIndex < Row + Height; RowIndex++)
+	{
+		Contacts += Column == 0 || IsSlotOccupied(Column - 1, RowIndex) ? 1 : 0;
+		Contacts += Column + Width == NumColumns || IsSlotOccupied(Column + Width, RowIndex) ? 1 : 0;
+	}
+
+	// Slots above and below the area, one masked word at a time
+	for (int32 RowIndex : { Row - 1, Row + Height })
+	{
+		if (RowIndex < 0 || RowIndex >= NumRows)
+		{
+			Contacts += Width;
+			continue;
+		}
+		for (int32 WordIndex = Column / 64; WordIndex <= (Column + Width - 1) / 64; WordIndex++)
+		{
+			Contacts += CountSetBits(RowMasks[RowIndex * WordsPerRow + WordIndex] & GetWordMask(WordIndex, Column, Width));
+		}
+	}
+
+	return Contacts;
+}
@@ -136,41 +136,34 @@ void UEquipmentSlotWidget::ProcessItemDragAndDrop()
 			UDraggableItemWidget* SelectedItemWidget = Controller->GetSelectedItem();
 			UDraggableItemWidget* ClickedItemWidget = Controller->GetClickedItem();
 			if (DraggedItemWidget && bCanFitDraggedItem) {
+				// Equipping or replacing equipment. Replaced equipment moves to the dragged item's old slot or the inventory in the same
+				// op, which fails and leaves everything in place if it fits nowhere.
 				AEquippable* ItemToEquip = Cast<AEquippable>(DraggedItemWidget->GetItem());
-				if (SelectedItemWidget)
+				if (ItemToEquip && SourceInventoryComponent)
 				{
-					// Replacing equipment
-					AEquippable* ItemToUnequip = Cast<AEquippable>(SelectedItemWidget->GetItem());
-					if (ItemToEquip && ItemToUnequip)
+					// Equipment dragged from another slot is moved straight from that slot
+					EEquipmentSlot EquippedSlot;
+					bool IsItemEquipped = SourceEquipmentComponent->GetEquippedSlot(ItemToEquip, EquippedSlot);
+					if (!IsItemEquipped || EquippedSlot != SlotType)
 					{
-						Controller->StopDraggingItem(false);
-						SelectedItemWidget->StartDragging();
-						SourceEquipmentComponent->ServerUnequipItem(ItemToUnequip, SlotType);
-						SourceEquipmentComponent->ServerEquipItemToSlot(ItemToEquip, SlotType);
-						UGameplayStatics::PlaySound2D(GetWorld(), ItemToEquip->GetInteractionSound());
-						Controller->SetSelectedItem(EquippedItemWidget);
+						TArray<FInventoryOp> Ops;
+						Ops.Add(FInventoryOp::MakeEquip(ItemToEquip, SlotType));
+						SourceInventoryComponent->ExecuteInventoryOps(Ops);
 					}
+					UGameplayStatics::PlaySound2D(GetWorld(), ItemToEquip->GetInteractionSound());
 				}
-				else
+				Controller->StopDraggingItem(false);
+				Controller->SetSelectedItem(nullptr);
+				if (SlotHighlight)
 				{
-					// Equipping a new item
-					SourceEquipmentComponent->ServerEquipItemToSlot(ItemToEquip, SlotType);
-					UGameplayStatics::PlaySound2D(GetWorld(), ItemToEquip->GetInteractionSound());
-					Controller->StopDraggingItem(false);
-					Controller->SetSelectedItem(nullptr);
-					if (SlotHighlight)
-					{
-						SlotHighlight->SetVisibility(ESlateVisibility::Collapsed);
-					}
+					SlotHighlight->SetVisibility(ESlateVisibility::Collapsed);
 				}
 			}
 			else if (ClickedItemWidget && !DraggedItemWidget)
 			{
-				// Unequipping an item
-				AEquippable* ItemToUnequip = Cast<AEquippable>(ClickedItemWidget->GetItem());
-				if (ItemToUnequip)
+				// Dragging an equipped item, which stays equipped until it is dropped
+				if (Cast<AEquippable>(ClickedItemWidget->GetItem()))
 				{
-					SourceEquipmentComponent->ServerUnequipItem(ItemToUnequip, SlotType);
 					ClickedItemWidget->StartDragging();
 					UGameplayStatics::PlaySound2D(GetWorld(), BeginDragSound);
 				}
@@ -181,6 +174,12 @@ void UEquipmentSlotWidget::ProcessItemDragAndDrop()
 
 void UEquipmentSlotWidget::OnBeginItemDrag(AItem* Item)
 {
+	// Hide the item while it is being dragged out of this slot, it stays equipped until it is dropped
+	if (EquippedItemWidget && EquippedItemWidget->GetItem() == Item)
+	{
+		EquippedItemWidget->SetVisibility(ESlateVisibility::Collapsed);
+	}
+
 	// Get the equipment type and determine if it can go in this slot. If so, highlight the slot.
 	bCanFitDraggedItem = false;
 	AArmor* Armor = Cast<AArmor>(Item);
@@ -287,6 +286,12 @@ void UEquipmentSlotWidget::OnEndItemDrag(AItem* Item)
 	{
 		SlotBorder->SetColorAndOpacity(DefaultBorderColor);
 	}
+
+	// Show the item again if it is still equipped in this slot
+	if (EquippedItemWidget && EquippedItemWidget->GetItem() == Item)
+	{
+		EquippedItemWidget->SetVisibility(ESlateVisibility::Visible);
+	}
 }
 
 void UEquipmentSlotWidget::OnItemEquipped(AEquippable* Equippable, EEquipmentSlot Slot)
@@ -520,18 +525,16 @@ FReply UEquipmentSlotWidget::NativeOnPreviewMouseButtonDown(const FGeometry& InG
 			}
 			else if (InMouseEvent.GetEffectingButton() == EKeys::MiddleMouseButton)
 			{
-				if (SourceEquipmentComponent)
+				if (SourceEquipmentComponent && SourceInventoryComponent)
 				{
 					UDraggableItemWidget* SelectedItemWidget = Controller->GetSelectedItem();
 					// Unequip item and drop it
 					AEquippable* ItemToDrop = Cast<AEquippable>(SelectedItemWidget->GetItem());
 					if (ItemToDrop)
 					{
-						SourceEquipmentComponent->ServerUnequipItem(ItemToDrop, SlotType);
-						if (SourceInventoryComponent)
-						{
-							SourceInventoryComponent->ServerRequestDropItem(ItemToDrop, false);
-						}
+						TArray<FInventoryOp> Ops;
+						Ops.Add(FInventoryOp::MakeDrop(ItemToDrop));
+						SourceInventoryComponent->ExecuteInventoryOps(Ops);
 						UGameplayStatics::PlaySound2D(GetWorld(), ItemToDrop->GetInteractionSound());
 						Controller->SetSelectedItem(nullptr);
 						ADungeonHUD* HUD = Cast<ADungeonHUD>(Controller->GetHUD());
@@ -544,14 +547,16 @@ FReply UEquipmentSlotWidget::NativeOnPreviewMouseButtonDown(const FGeometry& InG
 			}
 			else if (InMouseEvent.GetEffectingButton() == EKeys::RightMouseButton)
 			{
-				if (SourceEquipmentComponent)
+				if (SourceEquipmentComponent && SourceInventoryComponent)
 				{
 					UDraggableItemWidget* SelectedItemWidget = Controller->GetSelectedItem();
-					// Unequip item and attempt to move it to the character's inventory
+					// Unequip item and attempt to move it to the character's inventory, it is dropped if it fits nowhere
 					AEquippable* ItemToUnequip = Cast<AEquippable>(SelectedItemWidget->GetItem());
 					if (ItemToUnequip)
 					{
-						SourceEquipmentComponent->ServerUnequipItem(ItemToUnequip, SlotType, true);
+						TArray<FInventoryOp> Ops;
+						Ops.Add(FInventoryOp::MakeUnequip(ItemToUnequip, SlotType));
+						SourceInventoryComponent->ExecuteInventoryOps(Ops);
 						UGameplayStatics::PlaySound2D(GetWorld(), ItemToUnequip->GetInteractionSound());
 						Controller->SetSelectedItem(nullptr);
 						ADungeonHUD* HUD = Cast<ADungeonHUD>(Controller->GetHUD());
@@ -182,27 +182,9 @@ void UInGameOverlayWidget::StartDragAndDropOperation(AItem* Item)
 
 void UInGameOverlayWidget::StopDragAndDropOperation(bool WasCanceled)
 {
+	// Canceled drags need no cleanup, the dragged item never left the inventory or equipment
 	DropItemScreenButton->SetVisibility(ESlateVisibility::Collapsed);
 
-	if (WasCanceled)
-	{
-		ADungeonPlayerController* PlayerController = Cast<ADungeonPlayerController>(GetOwningPlayer());
-		if (PlayerController)
-		{
-			UDraggableItemWidget* DraggedItemWidget = PlayerController->GetDraggedItem();
-			if (DraggedItemWidget && DraggedItemWidget->GetItem())
-			{
-				UInventoryComponent* InventoryComponent = Cast<UInventoryComponent>(PlayerController->GetPawn()->GetComponentByClass(UInventoryComponent::StaticClass()));
-				if (InventoryComponent)
-				{
-					AItem* DraggedItem = DraggedItemWidget->GetItem();
-					UGameplayStatics::PlaySound2D(DraggedItem->GetWorld(), DraggedItem->GetInteractionSound());
-					InventoryComponent->ServerRequestDropItem(DraggedItem, false);
-				}
-			}
-		}
-	}
-
 	if (DragAndDropItem)
 	{
 		DragAndDropItem->StopDragAndDropOperation();	
@@ -224,8 +206,11 @@ void UInGameOverlayWidget::CheckForItemDrop()
 			UInventoryComponent* InventoryComponent = Cast<UInventoryComponent>(PlayerController->GetPawn()->GetComponentByClass(UInventoryComponent::StaticClass()));
 			if (InventoryComponent)
 			{
+				// The dragged item is still in the inventory or equipment, the drop op takes it out of either
 				AItem* DraggedItem = DraggedItemWidget->GetItem();
-				InventoryComponent->ServerRequestDropItem(DraggedItem, false);
+				TArray<FInventoryOp> Ops;
+				Ops.Add(FInventoryOp::MakeDrop(DraggedItem));
+				InventoryComponent->ExecuteInventoryOps(Ops);
 				UGameplayStatics::PlaySound2D(DraggedItem->GetWorld(), DraggedItem->GetInteractionSound());
 			}
 			PlayerController->StopDraggingItem(true);
@@ -23,6 +23,7 @@
 UInventoryGridWidget::UInventoryGridWidget(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
+	ContainerId = 0;
 	InventoryGridSize = FInventoryGridPair(6, 5);
 	InitializeGrid();
 }
@@ -50,7 +51,7 @@ void UInventoryGridWidget::BindToSource(AActor* Source)
 
 	if (SourceInventoryComponent)
 	{
-		InventoryGridSize = SourceInventoryComponent->GetInventoryGridSize();
+		InventoryGridSize = SourceInventoryComponent->GetInventoryGridSize(ContainerId);
 		SourceInventoryComponent->OnItemAdded.RemoveDynamic(this, &UInventoryGridWidget::AddItem);
 		SourceInventoryComponent->OnItemRemoved.RemoveDynamic(this, &UInventoryGridWidget::RemoveItem);
 	}
@@ -58,25 +59,32 @@ void UInventoryGridWidget::BindToSource(AActor* Source)
 	SourceInventoryComponent = Cast<UInventoryComponent>(Source->GetComponentByClass(UInventoryComponent::StaticClass()));
 	if (SourceInventoryComponent)
 	{
-		InventoryGridSize = SourceInventoryComponent->GetInventoryGridSize();
+		InventoryGridSize = SourceInventoryComponent->GetInventoryGridSize(ContainerId);
 		SourceInventoryComponent->OnItemAdded.AddDynamic(this, &UInventoryGridWidget::AddItem);
 		SourceInventoryComponent->OnItemRemoved.AddDynamic(this, &UInventoryGridWidget::RemoveItem);
 	}
 
 	SourceEquipmentComponent = Cast<UEquipmentComponent>(Source->GetComponentByClass(UEquipmentComponent::StaticClass()));
 
+	ADungeonPlayerController* Controller = Cast<ADungeonPlayerController>(GetOwningPlayer());
+	if (Controller)
+	{
+		Controller->OnBeginItemDrag.AddUniqueDynamic(this, &UInventoryGridWidget::OnBeginItemDrag);
+		Controller->OnEndItemDrag.AddUniqueDynamic(this, &UInventoryGridWidget::OnEndItemDrag);
+	}
+
 	InitializeGrid();
 
 	if (SourceInventoryComponent)
 	{
 		TArray<AItem*> AddedSourceItems;
-		TArray<FInventoryGridSlot> SourceInventoryGrid = SourceInventoryComponent->GetInventoryGrid();
+		TArray<FInventoryGridSlot> SourceInventoryGrid = SourceInventoryComponent->GetInventoryGrid(ContainerId);
 		for (FInventoryGridSlot& GridSlot : SourceInventoryGrid)
 		{
 			AItem* SlotItem = GridSlot.Item;
 			if (SlotItem && !AddedSourceItems.Contains(SlotItem))
 			{
-				AddItem(SlotItem, GridSlot.ItemOriginGridLocation);
+				AddItem(SlotItem, ContainerId, GridSlot.ItemOriginGridLocation);
 				AddedSourceItems.Add(SlotItem);
 			}
 		}
@@ -97,7 +105,7 @@ void UInventoryGridWidget::InitializeGrid()
 	{
 		for (int GridColumIndex = 0; GridColumIndex < InventoryGridSize.Column; GridColumIndex++)
 		{
-			uint8 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
+			int32 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
 			FString GridSlotString = FString("InventorySlot");
 			GridSlotString.AppendInt(GridSlotIndex);
 			FName GridSlotName = FName(*GridSlotString);
@@ -114,20 +122,20 @@ void UInventoryGridWidget::InitializeGrid()
 	}
 }
 
-void UInventoryGridWidget::AddItem(AItem* Item, FInventoryGridPair OriginGridSlot)
+void UInventoryGridWidget::AddItem(AItem* Item, int32 ItemContainerId, FInventoryGridPair OriginGridSlot)
 {
-	if (!ValidateWidgets()) return;
+	if (!ValidateWidgets() || ItemContainerId != ContainerId) return;
 
 	// Update the grid widget
 	FInventoryGridPair ItemSize = Item->GetGridSize();
-	uint8 ItemRowExtent = OriginGridSlot.Row + ItemSize.Row;
-	uint8 ItemColumnExtent = OriginGridSlot.Column + ItemSize.Column;
+	int32 ItemRowExtent = OriginGridSlot.Row + ItemSize.Row;
+	int32 ItemColumnExtent = OriginGridSlot.Column + ItemSize.Column;
 
 	for (int GridRowIndex = OriginGridSlot.Row; GridRowIndex < ItemRowExtent; GridRowIndex++)
 	{
 		for (int GridColumIndex = OriginGridSlot.Column; GridColumIndex < ItemColumnExtent; GridColumIndex++)
 		{
-			uint8 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
+			int32 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
 			if (GridSlotIndex < InventorySlots.Num())
 			{
 				UInventoryGridSlotWidget* GridSlot = InventorySlots[GridSlotIndex];
@@ -162,21 +170,22 @@ void UInventoryGridWidget::AddItem(AItem* Item, FInventoryGridPair OriginGridSlo
 	}
 }
 
-void UInventoryGridWidget::RemoveItem(AItem* Item, FInventoryGridPair OriginGridSlot)
+void UInventoryGridWidget::RemoveItem(AItem* Item, int32 ItemContainerId, FInventoryGridPair OriginGridSlot)
 {
-	if (!ValidateWidgets()) return;
+	if (!ValidateWidgets() || ItemContainerId != ContainerId) return;
 
 	// Update the grid widget
 	FInventoryGridPair ItemSize = Item->GetGridSize();
-	uint8 ItemRowExtent = OriginGridSlot.Row + ItemSize.Row;
-	uint8 ItemColumnExtent = OriginGridSlot.Column + ItemSize.Column;
+	int32 ItemRowExtent = OriginGridSlot.Row + ItemSize.Row;
+	int32 ItemColumnExtent = OriginGridSlot.Column + ItemSize.Column;
 
 	for (int GridRowIndex = OriginGridSlot.Row; GridRowIndex < ItemRowExtent; GridRowIndex++)
 	{
 		for (int GridColumIndex = OriginGridSlot.Column; GridColumIndex < ItemColumnExtent; GridColumIndex++)
 		{
-			uint8 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
-			if (GridSlotIndex < InventorySlots.Num())
+			int32 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
+			// Slots another item was already added over are left to that item
+			if (GridSlotIndex < InventorySlots.Num() && InventorySlots[GridSlotIndex]->GetItem() == Item)
 			{
 				UInventoryGridSlotWidget* GridSlot = InventorySlots[GridSlotIndex];
 				GridSlot->SetItem(nullptr);
@@ -198,20 +207,23 @@ void UInventoryGridWidget::RemoveItem(AItem* Item, FInventoryGridPair OriginGrid
 bool UInventoryGridWidget::ValidateGridSelection(AItem* Item)
 {
 	FInventoryGridPair ItemSize = Item->GetGridSize();
-	uint8 ItemRowExtent = SelectionOrigin.Row + ItemSize.Row;
-	uint8 ItemColumnExtent = SelectionOrigin.Column + ItemSize.Column;
+	int32 ItemRowExtent = SelectionOrigin.Row + ItemSize.Row;
+	int32 ItemColumnExtent = SelectionOrigin.Column + ItemSize.Column;
 
-	// Go through the selected grid slots once to determine if there is more than one item in the selection area
+	// Go through the selected grid slots once to determine if there is more than one item in the selection area. Free
+	// selections are answered by the inventory's occupancy masks without looking at the slots. The dragged item stays in the
+	// inventory until it is dropped, so its own slots count as free.
 	AItem* SelectedItem = nullptr;
 	bool SelectionValid = true;
-	for (int GridRowIndex = SelectionOrigin.Row; GridRowIndex < ItemRowExtent; GridRowIndex++)
+	bool SelectionFree = SourceInventoryComponent && SourceInventoryComponent->IsGridAreaFree(ContainerId, SelectionOrigin, ItemSize);
+	for (int GridRowIndex = SelectionOrigin.Row; GridRowIndex < ItemRowExtent && !SelectionFree; GridRowIndex++)
 	{
 		for (int GridColumIndex = SelectionOrigin.Column; GridColumIndex < ItemColumnExtent; GridColumIndex++)
 		{
-			uint8 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
+			int32 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
 			UInventoryGridSlotWidget* GridSlot = InventorySlots[GridSlotIndex];
 			AItem* ItemInSlot = GridSlot->GetItem();
-			if (ItemInSlot)
+			if (ItemInSlot && ItemInSlot != Item)
 			{
 				if (SelectedItem && SelectedItem != ItemInSlot)
 				{
@@ -235,7 +247,7 @@ bool UInventoryGridWidget::ValidateGridSelection(AItem* Item)
 	{
 		for (int GridColumIndex = SelectionOrigin.Column; GridColumIndex < ItemColumnExtent; GridColumIndex++)
 		{
-			uint8 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
+			int32 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
 			UInventoryGridSlotWidget* GridSlot = InventorySlots[GridSlotIndex];
 			GridSlot->BeginItemOverlap(SelectionValid);
 		}
@@ -266,7 +278,7 @@ void UInventoryGridWidget::ClearGridHighlights()
 	{
 		for (int GridColumIndex = 0; GridColumIndex < InventoryGridSize.Column; GridColumIndex++)
 		{
-			uint8 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
+			int32 GridSlotIndex = (GridRowIndex * InventoryGridSize.Column) + GridColumIndex;
 			UInventoryGridSlotWidget* GridSlot = InventorySlots[GridSlotIndex];
 			GridSlot->EndItemOverlap();
 		}
@@ -283,31 +295,47 @@ void UInventoryGridWidget::ProcessItemDragAndDrop()
 		UDraggableItemWidget* SelectedItemWidget = Controller->GetSelectedItem();
 		UDraggableItemWidget* ClickedItemWidget = Controller->GetClickedItem();
 		if (DraggedItemWidget && bIsSelectionValid) {
+			// Dragged items stay in the inventory or equipment until they are dropped, so every drop is a single batch of ops
+			AItem* DraggedItem = DraggedItemWidget->GetItem();
+			EEquipmentSlot DraggedItemSlot;
+			bool IsDraggedItemEquipped = SourceEquipmentComponent && SourceEquipmentComponent->GetEquippedSlot(Cast<AEquippable>(DraggedItem), DraggedItemSlot);
+			TArray<FInventoryOp> Ops;
 			if (SelectedItemWidget)
 			{
-				// Selecting a replacement item to drag
+				// Selecting a replacement item to drag. Equipment dropped onto an item is unequipped to a free slot and swapped from there.
 				Controller->StopDraggingItem(false);
-				SelectedItemWidget->StartDragging();
 				AItem* SelectedItem = SelectedItemWidget->GetItem();
-				if (SelectedItem)
+				if (DraggedItem && SelectedItem)
 				{
-					SourceInventoryComponent->ServerRequestRemoveItemFromInventory(SelectedItem);
-				}
-				AItem* DraggedItem = DraggedItemWidget->GetItem();
-				if (DraggedItem)
-				{
-					SourceInventoryComponent->ServerRequestAddItemToInventoryAtLocation(DraggedItem, SelectionOrigin);
+					if (IsDraggedItemEquipped)
+					{
+						Ops.Add(FInventoryOp::MakeUnequip(DraggedItem, DraggedItemSlot));
+					}
+					Ops.Add(FInventoryOp::MakeSwap(DraggedItem, ContainerId, SelectionOrigin));
+					SourceInventoryComponent->ExecuteInventoryOps(Ops);
 					UGameplayStatics::PlaySound2D(GetWorld(), DraggedItem->GetInteractionSound());
 				}
+
+				// The swapped item got a new widget if it was moved within this grid
+				UDraggableItemWidget** ReplacementWidgetPtr = DraggableItemWidgets.Find(SelectedItem);
+				UDraggableItemWidget* ReplacementWidget = ReplacementWidgetPtr ? *ReplacementWidgetPtr : SelectedItemWidget;
+				ReplacementWidget->StartDragging();
 				Controller->SetSelectedItem(nullptr);
 			}
 			else
 			{
 				// Trying to drop the item at the current location
-				AItem* DraggedItem = DraggedItemWidget->GetItem();
 				if (DraggedItem)
 				{
-					SourceInventoryComponent->ServerRequestAddItemToInventoryAtLocation(DraggedItem, SelectionOrigin);
+					if (IsDraggedItemEquipped)
+					{
+						Ops.Add(FInventoryOp::MakeUnequip(DraggedItem, DraggedItemSlot, ContainerId, SelectionOrigin));
+					}
+					else
+					{
+						Ops.Add(FInventoryOp::MakeMove(DraggedItem, ContainerId, SelectionOrigin));
+					}
+					SourceInventoryComponent->ExecuteInventoryOps(Ops);
 					UGameplayStatics::PlaySound2D(GetWorld(), DraggedItem->GetInteractionSound());
 				}
 				Controller->StopDraggingItem(false);
@@ -318,12 +346,30 @@ void UInventoryGridWidget::ProcessItemDragAndDrop()
 		{
 			// Selecting a new item to drag
 			ClickedItemWidget->StartDragging();
-			SourceInventoryComponent->ServerRequestRemoveItemFromInventory(ClickedItemWidget->GetItem());
 			UGameplayStatics::PlaySound2D(GetWorld(), BeginDragSound);
 		}
 	}
 }
 
+void UInventoryGridWidget::OnBeginItemDrag(AItem* Item)
+{
+	// Hide the dragged item while it follows the cursor, it stays in the grid until it is dropped
+	UDraggableItemWidget** WidgetPtr = DraggableItemWidgets.Find(Item);
+	if (WidgetPtr)
+	{
+		(*WidgetPtr)->SetVisibility(ESlateVisibility::Collapsed);
+	}
+}
+
+void UInventoryGridWidget::OnEndItemDrag(AItem* Item)
+{
+	UDraggableItemWidget** WidgetPtr = DraggableItemWidgets.Find(Item);
+	if (WidgetPtr)
+	{
+		(*WidgetPtr)->SetVisibility(ESlateVisibility::Visible);
+	}
+}
+
 void UInventoryGridWidget::NativeTick(const FGeometry& MyGeometry, float DeltaTime)
 {
 	if (bWereSlotsHighlightedLastFrame)
@@ -485,10 +531,18 @@ void UInventoryGridWidget::UseSelectedItem(ADungeonPlayerController* Controller,
 	AEquippable* Equippable = Cast<AEquippable>(SelectedItemWidget->GetItem());
 	if (Equippable)
 	{
-		SourceInventoryComponent->ServerRequestRemoveItemFromInventory(Equippable);
+		// Equip to the first open slot, or replace the item in the first valid slot, which goes back to the inventory
 		if (SourceEquipmentComponent)
 		{
-			SourceEquipmentComponent->ServerEquipItem(Equippable, true);
+			TArray<EEquipmentSlot> ValidEquipmentSlots = SourceEquipmentComponent->GetValidSlotsForEquippable(Equippable);
+			TArray<EEquipmentSlot> OpenEquipmentSlots = SourceEquipmentComponent->GetOpenSlotsForEquippable(Equippable);
+			if (ValidEquipmentSlots.Num() > 0)
+			{
+				EEquipmentSlot SlotToEquipItem = OpenEquipmentSlots.Num() > 0 ? OpenEquipmentSlots[0] : ValidEquipmentSlots[0];
+				TArray<FInventoryOp> Ops;
+				Ops.Add(FInventoryOp::MakeEquip(Equippable, SlotToEquipItem));
+				SourceInventoryComponent->ExecuteInventoryOps(Ops);
+			}
 		}
 		UGameplayStatics::PlaySound2D(GetWorld(), Equippable->GetInteractionSound());
 		Controller->SetSelectedItem(nullptr);
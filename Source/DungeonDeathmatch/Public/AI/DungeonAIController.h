@@ -12,6 +12,7 @@ class UBehaviorTreeComponent;
 class UBlackboardComponent;
 class UAISenseConfig_Sight;
 class UAISenseConfig_Hearing;
+class UDungeonRoomRouteComponent;
 
 UCLASS()
 class DUNGEONDEATHMATCH_API ADungeonAIController : public AAIController
@@ -58,11 +59,28 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Combat")
 	float TargetLostEndCombatTimer = 5.0f;
 
+	/** Acceptance radius of the doorways along a room route */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Navigation")
+	float RoomRouteWaypointRadius = 100.0f;
+
 private:
 	EAIState AIState;
 	bool bIsTargetVisible;
 	FTimerHandle TargetLostHandle;
 
+	/** Route component of the dungeon generator, looked up on the first room route */
+	TWeakObjectPtr<UDungeonRoomRouteComponent> RoomRouteComponent;
+
+	/** Doorways of the room route being followed, ending at the goal */
+	TArray<FVector> RoomRoute;
+	int32 RoomRouteIndex;
+	float RoomRouteAcceptanceRadius;
+	bool bIsFollowingRoomRoute;
+	bool bDidRoomRouteSucceed;
+
+	/** Set while a room route move is requested, since moves that finish immediately report completion before the request returns */
+	bool bIsRequestingRoomRouteMove;
+
 public:
 	ADungeonAIController();
 
@@ -82,6 +100,25 @@ public:
 
 	void ClearStimuli();
 
+	/**
+	 * Moves to a location through the doorways of the dungeon's rooms and corridors, with one short navmesh move per doorway
+	 * instead of a single path across the map. Falls back to a direct move outside of a generated dungeon.
+	 * Returns false if the goal can't be reached.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Navigation")
+	bool MoveToLocationViaRooms(const FVector& Goal, float AcceptanceRadius);
+
+	/** Stops following the current room route */
+	UFUNCTION(BlueprintCallable, Category = "Navigation")
+	void StopRoomRoute();
+
+	bool IsFollowingRoomRoute() const { return bIsFollowingRoomRoute; };
+
+	/** Did the last room route reach its goal? */
+	bool DidRoomRouteSucceed() const { return bDidRoomRouteSucceed; };
+
+	virtual void OnMoveCompleted(FAIRequestID RequestID, const FPathFollowingResult& Result) override;
+
 protected:
 	void SetAIState(EAIState State);
 
@@ -90,4 +127,9 @@ protected:
 
 	UFUNCTION()
 	void OnTargetLost();
+
+	/** Requests the move to the current room route waypoint, skipping waypoints the pawn is already at */
+	void MoveToNextRoomRouteWaypoint();
+
+	void FinishRoomRoute(bool bSucceeded);
 };
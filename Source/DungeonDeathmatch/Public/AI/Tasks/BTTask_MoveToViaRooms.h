@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
+#include "BTTask_MoveToViaRooms.generated.h"
+
+/**
+ * Moves to the actor or location in the blackboard key through the doorways of the generated dungeon, one short navmesh move
+ * per doorway. Meant for long moves such as walking to the next patrol point.
+ */
+UCLASS()
+class DUNGEONDEATHMATCH_API UBTTask_MoveToViaRooms : public UBTTask_BlackboardBase
+{
+	GENERATED_BODY()
+	
+protected:
+	UPROPERTY(EditAnywhere, Category = "Node", meta = (ClampMin = 0.0f))
+	float AcceptanceRadius;
+
+public:
+	UBTTask_MoveToViaRooms();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+protected:
+	virtual void TickTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+
+private:
+	virtual FString GetStaticDescription() const override;
+};
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DungeonBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless benchmark of the dungeon layout builder. Sweeps room counts, room grid sizes, tile counts and seeds, times every
+ * generation stage and writes the results to a CSV file. Every switch is optional, -RandomPlacement benchmarks the random
+ * rejection room placement instead of the Poisson-disc one:
+ *
+ * UE4Editor-Cmd DungeonDeathmatch.uproject -run=DungeonBenchmark -nullrhi -Rooms=10,50,200 -RoomGridSizes=50,100 -Tiles=100,10000 -Seeds=5 -Output=Benchmark.csv
+ */
+UCLASS()
+class DUNGEONDEATHMATCH_API UDungeonBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDungeonBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/** Parses a comma separated list of integers from a switch like -Rooms=10,50,200, or returns the defaults if the switch isn't present */
+	static TArray<int32> ParseIntList(const FString& Params, const TCHAR* Switch, const TArray<int32>& Defaults);
+};
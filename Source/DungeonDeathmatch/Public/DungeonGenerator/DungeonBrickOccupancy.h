@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Edge length of an occupancy brick in cells */
+#define OCCUPANCY_BRICK_SIZE	8
+
+/**
+ * Sparse 3D occupancy of the room grid used for room placement, stored as 8x8x8 cell bricks in a hash map. Only bricks that hold
+ * an occupied cell are allocated, so memory grows with the occupied volume rather than the bounding volume and the empty floors
+ * of tall grids cost nothing. Each brick packs one Z slice of 8x8 cells into a 64 bit word, so testing or filling a box touches
+ * one masked word per slice and brick, and a whole box query needs one hash probe per brick instead of one per cell.
+ */
+class DUNGEONDEATHMATCH_API FDungeonBrickOccupancy
+{
+private:
+	struct FBrick
+	{
+		/** One word per Z slice, bit Y * 8 + X is set for occupied cells */
+		uint64 Slices[OCCUPANCY_BRICK_SIZE];
+
+		FBrick()
+		{
+			FMemory::Memzero(Slices, sizeof(Slices));
+		}
+	};
+
+	/** Allocated bricks by packed brick coordinate */
+	TMap<uint64, FBrick> Bricks;
+
+	/** Half open bounds of every cell ever filled, used to reject queries outside of the occupied volume without probing */
+	FIntVector BoundsMin;
+	FIntVector BoundsMax;
+
+public:
+	FDungeonBrickOccupancy();
+
+	/** Clears every cell and frees the bricks */
+	void Reset();
+
+	bool IsCellOccupied(const FIntVector& Cell) const;
+
+	/** Returns true if any cell in the half open box [Min, Max) is occupied */
+	bool IsBoxOccupied(const FIntVector& Min, const FIntVector& Max) const;
+
+	/** Marks every cell in the half open box [Min, Max) as occupied */
+	void FillBox(const FIntVector& Min, const FIntVector& Max);
+
+	/** Returns the half open bounds of the occupied cells. Returns false if nothing is occupied. */
+	bool GetOccupiedBounds(FIntVector& OutMin, FIntVector& OutMax) const;
+
+	int32 GetNumBricks() const { return Bricks.Num(); };
+
+	/** Memory used by the bricks in bytes */
+	SIZE_T GetAllocatedSize() const { return Bricks.GetAllocatedSize(); };
+
+private:
+	/** Brick containing a cell. Arithmetic shifts round towards negative infinity, so negative cells land in the right brick. */
+	static FORCEINLINE FIntVector GetBrickCoordinate(const FIntVector& Cell)
+	{
+		return FIntVector(Cell.X >> 3, Cell.Y >> 3, Cell.Z >> 3);
+	}
+
+	/** Packs a brick coordinate into 21 bits per axis, which hashes far cheaper than an FIntVector key */
+	static FORCEINLINE uint64 GetBrickKey(const FIntVector& Brick)
+	{
+		const uint64 Mask = (1ull << 21) - 1;
+		return ((uint64)Brick.X & Mask) | (((uint64)Brick.Y & Mask) << 21) | (((uint64)Brick.Z & Mask) << 42);
+	}
+
+	/** Intersects the half open box [Min, Max) with a brick, in brick local cells */
+	static FORCEINLINE void GetBrickLocalBox(const FIntVector& Brick, const FIntVector& Min, const FIntVector& Max, FIntVector& OutLocalMin, FIntVector& OutLocalMax)
+	{
+		const FIntVector BrickOrigin = Brick * OCCUPANCY_BRICK_SIZE;
+		OutLocalMin = FIntVector(FMath::Max(Min.X - BrickOrigin.X, 0), FMath::Max(Min.Y - BrickOrigin.Y, 0), FMath::Max(Min.Z - BrickOrigin.Z, 0));
+		OutLocalMax = FIntVector(FMath::Min(Max.X - BrickOrigin.X, OCCUPANCY_BRICK_SIZE), FMath::Min(Max.Y - BrickOrigin.Y, OCCUPANCY_BRICK_SIZE), FMath::Min(Max.Z - BrickOrigin.Z, OCCUPANCY_BRICK_SIZE));
+	}
+
+	/** Returns the slice mask of the cells in [MinX, MaxX) x [MinY, MaxY) of a brick, in brick local cells */
+	static FORCEINLINE uint64 GetSliceMask(int32 MinX, int32 MaxX, int32 MinY, int32 MaxY)
+	{
+		// One bit per row in the range, multiplied by the row's X mask. Row masks are 8 bits wide, so the rows never carry.
+		const uint64 RowMask = ((1ull << (MaxX - MinX)) - 1) << MinX;
+		const int32 NumRows = MaxY - MinY;
+		const uint64 RowBits = (NumRows == OCCUPANCY_BRICK_SIZE ? ~0ull : ((1ull << (NumRows * 8)) - 1)) & 0x0101010101010101ull;
+		return (RowBits << (MinY * 8)) * RowMask;
+	}
+};
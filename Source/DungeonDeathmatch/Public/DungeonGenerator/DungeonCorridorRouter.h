@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "DungeonEnums.h"
+#include "DungeonGraph.h"
+#include "DungeonRoomSet.h"
+
+/**
+ * Routes corridors between connected rooms with A* on the room grid. Cells of other rooms are blocked, and stepping into a
+ * cell that already holds a corridor is discounted so routes merge into existing corridors instead of running next to them.
+ *
+ * Connections are routed in fixed size waves. The paths of a wave are searched in parallel against the corridors of all
+ * previous waves, then merged in connection order. A path that crosses or touches a corridor merged earlier in the same
+ * wave is routed again against the merged corridors, so it can reuse them. The wave size is fixed rather than derived from
+ * the core count, which keeps the result identical on every machine.
+ */
+class DUNGEONDEATHMATCH_API FDungeonCorridorRouter
+{
+private:
+	/** Per search working memory, sized to the grid once and reused across searches */
+	struct FSearchScratch
+	{
+		TArray<float> Costs;
+
+		TArray<int32> Parents;
+
+		/** Cells whose cost and parent were written in the search with this stamp */
+		TArray<uint32> VisitedStamps;
+
+		uint32 Stamp;
+
+		TArray<TPair<float, int32>> OpenSet;
+
+		FSearchScratch()
+		{
+			Stamp = 0;
+		}
+	};
+
+	FIntVector Origin;
+
+	FIntVector Dimensions;
+
+	/** Index of the room occupying each cell, or INDEX_NONE */
+	TArray<int32> CellRooms;
+
+	/** Non zero for cells already carved as a corridor */
+	TArray<uint8> CorridorCells;
+
+	/** Cell each room's corridors start from, in the middle of the room's floor */
+	TArray<int32> RoomAnchorCells;
+
+	float ReuseCost;
+
+	float VerticalCost;
+
+	int32 NumRerouted;
+
+	int32 NumFailed;
+
+public:
+	FDungeonCorridorRouter();
+
+	/** Sizes the grid to [InOrigin, InOrigin + InDimensions) and marks the cells of every room */
+	void Init(const FIntVector& InOrigin, const FIntVector& InDimensions, const FDungeonRoomSet& Rooms, float InReuseCost, float InVerticalCost);
+
+	/** Routes every connection, in order. OutPaths holds one cell path per connection, empty if no route exists. */
+	void RouteConnections(const TArray<FDungeonGraphEdge>& Connections, int32 WaveSize, TArray<TArray<FIntVector>>& OutPaths);
+
+	/** Returns the index of the room occupying a grid cell, or INDEX_NONE */
+	int32 GetRoomAt(const FIntVector& Cell) const;
+
+	/** Number of paths that were routed again during conflict resolution */
+	int32 GetNumRerouted() const { return NumRerouted; };
+
+	/** Number of connections no route was found for */
+	int32 GetNumFailed() const { return NumFailed; };
+
+private:
+	/** Runs A* from room A to room B, appending the cells of the path to OutPath. Paths leave and enter rooms horizontally. Returns false if there is no route. */
+	bool FindPath(int32 RoomA, int32 RoomB, FSearchScratch& Scratch, TArray<int32>& OutPath) const;
+
+	/** Marks the corridor cells of a path as carved */
+	void MergePath(const TArray<int32>& Path, uint32 WaveStamp, TArray<uint32>& WaveCells);
+
+	/** Does the path cross or touch a corridor cell merged earlier in the current wave? */
+	bool ConflictsWithWave(const TArray<int32>& Path, uint32 WaveStamp, const TArray<uint32>& WaveCells) const;
+
+	float GetHeuristic(int32 Cell, int32 GoalCell) const;
+
+	FORCEINLINE int32 GetCellIndex(int32 X, int32 Y, int32 Z) const
+	{
+		return (Z * Dimensions.Y + Y) * Dimensions.X + X;
+	}
+
+	FORCEINLINE FIntVector GetCellLocal(int32 Cell) const
+	{
+		return FIntVector(Cell % Dimensions.X, (Cell / Dimensions.X) % Dimensions.Y, Cell / (Dimensions.X * Dimensions.Y));
+	}
+};
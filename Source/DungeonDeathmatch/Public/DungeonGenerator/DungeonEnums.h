@@ -37,6 +37,32 @@ UENUM(BlueprintType) enum class ETileType : uint8 {
 	Replacement		UMETA(DisplayName = "Replacement")
 };
 
+UENUM(BlueprintType) enum class ERoomPlacementStrategy : uint8 {
+	/** Tries random locations until one is free, up to MaxPlacementAttempts times per room */
+	RandomRejection		UMETA(DisplayName = "Random Rejection"),
+	/** Seeds evenly spaced room centers with Poisson-disc sampling, then fits a room around each seed */
+	PoissonDisc			UMETA(DisplayName = "Poisson Disc")
+};
+
+UENUM(BlueprintType) enum class EVerticalConnectorType : uint8 {
+	/** Walkable stairs, for climbs of up to MaxStairsHeight floors */
+	Stairs		UMETA(DisplayName = "Stairs"),
+	/** Climbable shaft, for taller climbs */
+	Shaft		UMETA(DisplayName = "Shaft")
+};
+
+UENUM(BlueprintType) enum class EDungeonPlacementType : uint8 {
+	PlayerStart		UMETA(DisplayName = "Player Start"),
+	Chest			UMETA(DisplayName = "Chest"),
+	AISpawn			UMETA(DisplayName = "AI Spawn")
+};
+
+/** Bit of each cardinal direction in FTileData::ConnectionMask, in ECardinalDirection order */
+#define TILE_CONNECTION_NORTH	(1 << 0)
+#define TILE_CONNECTION_SOUTH	(1 << 1)
+#define TILE_CONNECTION_EAST	(1 << 2)
+#define TILE_CONNECTION_WEST	(1 << 3)
+
 USTRUCT()
 struct FTileData
 {
@@ -48,22 +74,27 @@ struct FTileData
 	UPROPERTY()
 	ETileType Type;
 
+	/** Location of the tile in the tile grid */
 	UPROPERTY()
-	TMap<ECardinalDirection, bool> Directions;
+	FIntVector Coordinate;
+
+	/** Connected directions, one TILE_CONNECTION_* bit per direction */
+	UPROPERTY()
+	uint8 ConnectionMask;
 
 	UPROPERTY()
 	ADungeonTile* TileActor;
 
 	FTileData(ETileType TileType = ETileType::Generic, bool ConnectedNorth = false, bool ConnectedSouth = false, bool ConnectedEast = false, bool ConnectedWest = false)
 	{
-		GUID = FGuid::NewGuid();
-
 		Type = TileType;
+		Coordinate = FIntVector(0, 0, 0);
 
-		Directions.Add(ECardinalDirection::North, ConnectedNorth);
-		Directions.Add(ECardinalDirection::South, ConnectedSouth);
-		Directions.Add(ECardinalDirection::East, ConnectedEast);
-		Directions.Add(ECardinalDirection::West, ConnectedWest);
+		ConnectionMask = 0;
+		SetConnected(ECardinalDirection::North, ConnectedNorth);
+		SetConnected(ECardinalDirection::South, ConnectedSouth);
+		SetConnected(ECardinalDirection::East, ConnectedEast);
+		SetConnected(ECardinalDirection::West, ConnectedWest);
 
 		TileActor = nullptr;
 	}
@@ -73,74 +104,40 @@ struct FTileData
 		return GUID == Other.GUID;
 	}
 
-	ETileConnection GetConnection()
+	static uint8 GetDirectionBit(ECardinalDirection Direction)
 	{
-		bool ConnectedNorth = Directions[ECardinalDirection::North];
-		bool ConnectedSouth = Directions[ECardinalDirection::South];
-		bool ConnectedEast = Directions[ECardinalDirection::East];
-		bool ConnectedWest = Directions[ECardinalDirection::West];
+		return 1 << (uint8)Direction;
+	}
 
-		if (ConnectedNorth && ConnectedSouth && ConnectedEast && ConnectedWest)
-		{
-			return ETileConnection::NSEW;
-		}
-		else if (ConnectedNorth && ConnectedSouth && ConnectedEast)
-		{
-			return ETileConnection::NSE;
-		}
-		else if (ConnectedNorth && ConnectedSouth && ConnectedWest)
-		{
-			return ETileConnection::NSW;
-		}
-		else if (ConnectedNorth && ConnectedEast && ConnectedWest)
-		{
-			return ETileConnection::NEW;
-		}
-		else if (ConnectedSouth && ConnectedEast && ConnectedWest)
-		{
-			return ETileConnection::SEW;
-		}
-		else if (ConnectedNorth && ConnectedSouth)
-		{
-			return ETileConnection::NS;
-		}
-		else if (ConnectedNorth && ConnectedEast)
-		{
-			return ETileConnection::NE;
-		}
-		else if (ConnectedNorth && ConnectedWest)
-		{
-			return ETileConnection::NW;
-		}
-		else if (ConnectedEast && ConnectedWest)
-		{
-		return ETileConnection::EW;
-		}
-		else if (ConnectedSouth && ConnectedEast)
-		{
-			return ETileConnection::SE;
-		}
-		else if (ConnectedSouth && ConnectedWest)
-		{
-			return ETileConnection::SW;
-		}
-		else if (ConnectedNorth)
-		{
-			return ETileConnection::N;
-		}
-		else if (ConnectedSouth)
-		{
-			return ETileConnection::S;
-		}
-		else if (ConnectedEast)
+	bool IsConnected(ECardinalDirection Direction) const
+	{
+		return (ConnectionMask & GetDirectionBit(Direction)) != 0;
+	}
+
+	void SetConnected(ECardinalDirection Direction, bool bIsConnected)
+	{
+		if (bIsConnected)
 		{
-			return ETileConnection::E;
+			ConnectionMask |= GetDirectionBit(Direction);
 		}
 		else
 		{
-			return ETileConnection::W;
+			ConnectionMask &= ~GetDirectionBit(Direction);
 		}
 	}
+
+	ETileConnection GetConnection() const
+	{
+		// Indexed by ConnectionMask. A tile without any connection is treated as a west facing dead end.
+		static const ETileConnection ConnectionLookup[16] =
+		{
+			ETileConnection::W,		ETileConnection::N,		ETileConnection::S,		ETileConnection::NS,
+			ETileConnection::E,		ETileConnection::NE,	ETileConnection::SE,	ETileConnection::NSE,
+			ETileConnection::W,		ETileConnection::NW,	ETileConnection::SW,	ETileConnection::NSW,
+			ETileConnection::EW,	ETileConnection::NEW,	ETileConnection::SEW,	ETileConnection::NSEW
+		};
+		return ConnectionLookup[ConnectionMask & 0xF];
+	}
 };
 
 USTRUCT()
@@ -268,57 +265,215 @@ private:
 	}
 };
 
-struct FDungeonConnectionPredicate
+/** A vertical run of corridor joining floors of the room grid, spawned as stairs or a shaft */
+USTRUCT(BlueprintType)
+struct FDungeonVerticalConnector
 {
-	bool operator()(const FDungeonConnection& A, const FDungeonConnection& B) const
+	GENERATED_BODY()
+
+	/** Lowest cell of the run in room grid cells */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FIntVector Bottom;
+
+	/** Number of floors the run climbs */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Height;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	EVerticalConnectorType Type;
+
+	/** Direction the corridor leaves the top of the run in, stairs are turned to face it */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	ECardinalDirection ExitDirection;
+
+	FDungeonVerticalConnector()
 	{
-		// Inverted compared to std::priority_queue - higher priorities float to the top
-		return A.GetWeight() < B.GetWeight();
+		Bottom = FIntVector(0, 0, 0);
+		Height = 1;
+		Type = EVerticalConnectorType::Stairs;
+		ExitDirection = ECardinalDirection::North;
 	}
 };
 
-USTRUCT()
-struct FDungeonConnectionSet
+/** A player start, chest or AI spawn placed in a room by the placement stage */
+USTRUCT(BlueprintType)
+struct FDungeonPlacement
 {
 	GENERATED_BODY()
 
-	UPROPERTY()
-	TSet<FDungeonRoom> Set;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	EDungeonPlacementType Type;
 
-	FDungeonConnectionSet()
-	{
+	/** Index of the room the placement is in */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Room;
 
-	}
+	/** Location on the room's floor in room grid units */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FVector Location;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float Yaw;
 
-	bool operator==(const FDungeonConnectionSet& Other) const
+	/** Index of the nearest player start placement among the player starts, the one whose share the placement counts towards */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Owner;
+
+	/** Connections between the room and the room of the nearest player start */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Distance;
+
+	FDungeonPlacement()
 	{
-		if (Set.Num() != Other.Set.Num())
-		{
-			return false;
-		}
+		Type = EDungeonPlacementType::PlayerStart;
+		Room = INDEX_NONE;
+		Location = FVector::ZeroVector;
+		Yaw = 0.0f;
+		Owner = INDEX_NONE;
+		Distance = 0;
+	}
+};
 
-		for (FDungeonRoom Room : Set)
-		{
-			if (!Other.Set.Contains(Room)) 
-			{
-				return false;
-			}
-		}
+/** Every input that affects the generated layout. Generating twice from the same parameters always produces the same layout. */
+USTRUCT(BlueprintType)
+struct FDungeonGenerationParams
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Seed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FIntVector RoomDungeonGridSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NumberOfRooms;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FIntVector RoomSizeMin;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FIntVector RoomSizeMax;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MinRoomDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	ERoomPlacementStrategy RoomPlacementStrategy;
+
+	/** Attempts per room of the random rejection placement strategy */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxPlacementAttempts;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bAddExtraConnections;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float AdditionalConnectionsRatio;
+
+	/** Extra connections are only added between rooms with fewer connections than this, 0 for no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxRoomConnections;
+
+	/** Longest loop in rooms an extra connection may close through the spanning tree, 0 for no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxLoopLength;
+
+	/** Should corridors be carved through the room grid for every connection? */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bCarveCorridors;
 
-		return true;
+	/** Cost multiplier for routing through an existing corridor, lower values merge more corridors */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float CorridorReuseCost;
+
+	/** Cost of a vertical corridor step relative to a horizontal one */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float CorridorVerticalCost;
+
+	/** Vertical corridor runs climbing up to this many floors become stairs, taller runs become shafts */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxStairsHeight;
+
+	/** Player starts to spread over the rooms, as far apart from each other as the connections allow */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NumPlayerStarts;
+
+	/** Chests shared out evenly between the player starts, at most one per room */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NumChests;
+
+	/** Chests are kept at least this many connections away from every player start */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MinChestDistance;
+
+	/** AI spawns shared out evenly between the player starts, in the rooms furthest from them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NumAISpawns;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FIntVector DungeonGridSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NumberOfTiles;
+
+	/** Should rooms and their connections be generated? */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bGenerateRooms;
+
+	/** Should the tile layout be generated? */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bGenerateTiles;
+
+	FDungeonGenerationParams()
+	{
+		Seed = 0;
+		RoomDungeonGridSize = FIntVector(50, 50, 10);
+		NumberOfRooms = 50;
+		RoomSizeMin = FIntVector(3, 3, 2);
+		RoomSizeMax = FIntVector(10, 10, 4);
+		MinRoomDistance = 5;
+		RoomPlacementStrategy = ERoomPlacementStrategy::PoissonDisc;
+		MaxPlacementAttempts = 1000;
+		bAddExtraConnections = true;
+		AdditionalConnectionsRatio = 0.25f;
+		MaxRoomConnections = 4;
+		MaxLoopLength = 8;
+		bCarveCorridors = true;
+		CorridorReuseCost = 0.5f;
+		CorridorVerticalCost = 4.0f;
+		MaxStairsHeight = 1;
+		NumPlayerStarts = 8;
+		NumChests = 16;
+		MinChestDistance = 1;
+		NumAISpawns = 8;
+		DungeonGridSize = FIntVector(50, 50, 1);
+		NumberOfTiles = 100;
+		bGenerateRooms = true;
+		bGenerateTiles = true;
 	}
+};
 
-	FDungeonConnectionSet Union(const FDungeonConnectionSet OtherSet) const
+/** Replicated description of the server's dungeon. Clients rebuild the layout from the params and verify it against the checksum. */
+USTRUCT()
+struct FDungeonReplicatedLayout
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FDungeonGenerationParams Params;
+
+	/** Checksum of the layout the server generated from Params */
+	UPROPERTY()
+	int32 Checksum;
+
+	/** Incremented by the server for every generated dungeon, so regenerating from identical params still replicates */
+	UPROPERTY()
+	int32 GenerationIndex;
+
+	FDungeonReplicatedLayout()
 	{
-		FDungeonConnectionSet UnionedSet;
-		UnionedSet.Set = Set;
-		for (FDungeonRoom Room : OtherSet.Set)
-		{
-			if (!UnionedSet.Set.Contains(Room))
-			{
-				UnionedSet.Set.Add(Room);
-			}
-		}
-		return UnionedSet;
+		Checksum = 0;
+		GenerationIndex = 0;
 	}
-};
\ No newline at end of file
+};
@@ -6,16 +6,98 @@
 #include "GameFramework/Actor.h"
 
 #include "DungeonEnums.h"
+#include "DungeonPortalGraph.h"
+#include "DungeonTileGraph.h"
+#include "DungeonTilePool.h"
 #include "DungeonGenerator.generated.h"
 
 class ADungeonTile;
+class AChest;
+class APlayerStart;
+class UHierarchicalInstancedStaticMeshComponent;
+class UDungeonPortalCullingComponent;
+class UDungeonRoomRouteComponent;
+class UDungeonNavigationComponent;
+class FDungeonLayoutBuilder;
+struct FDungeonLayout;
+
+/** A tile waiting to be spawned by the time sliced spawner */
+struct FPendingTileSpawn
+{
+	/** The tile graph the tile belongs to, either the tile layout or the corridors */
+	FDungeonTileGraph* TileGraph;
+
+	int32 TileIndex;
+
+	FVector Location;
+
+	/** Portal region of the tile, or INDEX_NONE */
+	int32 Region;
+};
+
+/* Event delegate for when an asynchronous dungeon generation has finished and its tiles started spawning */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnDungeonGeneratedSignature, ADungeonGenerator*, Generator);
+
+/* Event delegate for time sliced tile spawning progress, in the range [0, 1] */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnDungeonSpawnProgressSignature, ADungeonGenerator*, Generator, float, Progress);
+
+/* Event delegate for when every tile of the generated dungeon was spawned */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnDungeonSpawnedSignature, ADungeonGenerator*, Generator);
 
 UCLASS()
 class DUNGEONDEATHMATCH_API ADungeonGenerator : public AActor
 {
 	GENERATED_BODY()
+
+public:
+	/* Delegate called when an asynchronous generation has finished, for loading screen updates */
+	UPROPERTY(BlueprintAssignable, Category = "Dungeon")
+	FOnDungeonGeneratedSignature OnDungeonGenerated;
+
+	/* Delegate called every frame tiles were spawned by the time sliced spawner */
+	UPROPERTY(BlueprintAssignable, Category = "Dungeon")
+	FOnDungeonSpawnProgressSignature OnDungeonSpawnProgress;
+
+	/* Delegate called once every tile of the dungeon is in the world */
+	UPROPERTY(BlueprintAssignable, Category = "Dungeon")
+	FOnDungeonSpawnedSignature OnDungeonSpawned;
 	
 protected:
+	/** Hides the rooms and corridors the local player can't see through any doorway */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UDungeonPortalCullingComponent* PortalCullingComponent;
+
+	/** Routes AI through the rooms and corridors of the dungeon */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UDungeonRoomRouteComponent* RoomRouteComponent;
+
+	/** Batches the navmesh updates of spawning tiles per portal region */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UDungeonNavigationComponent* NavigationComponent;
+
+	/** Seed for the next generation. Generating from the same seed and parameters always produces the same layout. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon")
+	int32 Seed;
+
+	/** Should a new random seed be picked every time the dungeon is generated? The picked seed is written back to Seed. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon")
+	bool bRandomizeSeed;
+
+	/** Should the server generate a dungeon asynchronously when play begins? Clients always rebuild the server's dungeon. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon")
+	bool bGenerateOnBeginPlay;
+
+	/**
+	 * Should generated layouts be stored in and loaded from the layout cache in Saved/DungeonLayouts? Only used for fixed seeds,
+	 * the cache is skipped while bRandomizeSeed is set since every random seed would add another file that is never loaded again.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon")
+	bool bUseLayoutCache;
+
+	/** Seed and params of the server's dungeon. Only this is replicated, clients regenerate the layout and spawn their own tiles. Transient, so dungeons generated in the editor don't save it into the level. */
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_ReplicatedLayout)
+	FDungeonReplicatedLayout ReplicatedLayout;
+
 	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon")
 	FIntVector RoomDungeonGridSize;
 
@@ -37,6 +119,11 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon", meta = (ClampMin = 1.0f))
 	float MainRoomSizeFactor;
 
+	/** How rooms are placed in the room grid. Poisson-disc placement keeps a near constant cost per room on dense grids. */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon")
+	ERoomPlacementStrategy RoomPlacementStrategy;
+
+	/** Attempts per room of the random rejection placement strategy */
 	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon", meta = (ClampMin = 1))
 	int32 MaxPlacementAttempts;
 
@@ -51,7 +138,83 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon", meta = (ClampMin = 0.0f, ClampMax = 1.0f))
 	float AdditionalConnectionsRatio;
 
-	TMap<FIntVector, bool> RoomDungeonGrid;
+	/** Extra connections are only added between rooms with fewer connections than this, 0 for no limit */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon", meta = (ClampMin = 0, EditCondition = "bAddExtraConnections"))
+	int32 MaxRoomConnections;
+
+	/** Longest loop in rooms an extra connection may close, lower values keep loops local. 0 for no limit. */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon", meta = (ClampMin = 0, EditCondition = "bAddExtraConnections"))
+	int32 MaxLoopLength;
+
+	/** Should corridors be carved between connected rooms? */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon")
+	bool bCarveCorridors;
+
+	/** Cost multiplier for routing a corridor through an existing corridor, lower values merge more corridors */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon", meta = (ClampMin = 0.01f, ClampMax = 1.0f, EditCondition = "bCarveCorridors"))
+	float CorridorReuseCost;
+
+	/** Cost of a vertical corridor step relative to a horizontal one */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon", meta = (ClampMin = 1.0f, EditCondition = "bCarveCorridors"))
+	float CorridorVerticalCost;
+
+	/** Vertical corridor runs climbing up to this many floors become stairs, taller runs become shafts */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon", meta = (ClampMin = 0, EditCondition = "bCarveCorridors"))
+	int32 MaxStairsHeight;
+
+	/** Spawned once per floor climbed by a stairs connector, turned to face the corridor leaving the top */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon")
+	TSubclassOf<ADungeonTile> StairsTileClass;
+
+	/** Spawned once per floor climbed by a shaft connector */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon")
+	TSubclassOf<ADungeonTile> ShaftTileClass;
+
+	/** Corridor tiles between connected rooms, in room grid cells */
+	FDungeonTileGraph Corridors;
+
+	/** Stairs and shafts where corridors climb between floors */
+	UPROPERTY(VisibleAnywhere, Category = "Room Style Dungeon")
+	TArray<FDungeonVerticalConnector> VerticalConnectors;
+
+	/** Tile actors spawned for the vertical connectors */
+	UPROPERTY(Transient)
+	TArray<ADungeonTile*> VerticalConnectorActors;
+
+	/** Player starts to spread over the rooms, as far apart from each other as the connections allow */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon|Placement", meta = (ClampMin = 0))
+	int32 NumPlayerStarts;
+
+	/** Chests shared out evenly between the player starts, at most one per room */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon|Placement", meta = (ClampMin = 0))
+	int32 NumChests;
+
+	/** Chests are kept at least this many connections away from every player start */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon|Placement", meta = (ClampMin = 0))
+	int32 MinChestDistance;
+
+	/** AI spawns shared out evenly between the player starts, in the rooms furthest from them. Only exposed as transforms, see GetPlacementTransforms. */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon|Placement", meta = (ClampMin = 0))
+	int32 NumAISpawns;
+
+	/** Spawned by the server at every player start placement, none if unset */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon|Placement")
+	TSubclassOf<APlayerStart> PlayerStartClass;
+
+	/** Spawned by the server at every chest placement, none if unset */
+	UPROPERTY(EditAnywhere, Category = "Room Style Dungeon|Placement")
+	TSubclassOf<AChest> ChestClass;
+
+	/** Player starts, chests and AI spawns placed in the rooms, with the player starts first */
+	UPROPERTY(VisibleAnywhere, Category = "Room Style Dungeon|Placement")
+	TArray<FDungeonPlacement> Placements;
+
+	/** Player starts and chests spawned for the placements */
+	UPROPERTY(Transient)
+	TArray<AActor*> PlacementActors;
+
+	/** Rooms and corridor groups joined by their doorways */
+	FDungeonPortalGraph PortalGraph;
 
 	UPROPERTY(EditAnywhere, Category = "Tile Style Dungeon")
 	FIntVector DungeonGridSize;
@@ -62,7 +225,7 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Tile Style Dungeon", meta = (ClampMin = 1))
 	int32 NumberOfTiles;
 
-	TMap<FIntVector, FTileData> Tiles;
+	FDungeonTileGraph Tiles;
 
 	UPROPERTY(EditAnywhere, Category = "Tile Style Dungeon")
 	TSubclassOf<ADungeonTile> DeadEndTileClass;
@@ -79,10 +242,54 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Tile Style Dungeon")
 	TSubclassOf<ADungeonTile> FourWayTileClass;
 
+	/** Should tiles with a TileMesh that don't require an actor be drawn as mesh instances instead of being spawned? */
+	UPROPERTY(EditAnywhere, Category = "Tile Style Dungeon")
+	bool bUseInstancedTileMeshes;
+
+	/** Should tiles be spawned over several frames in game worlds, instead of all at once? */
+	UPROPERTY(EditAnywhere, Category = "Tile Style Dungeon")
+	bool bTimeSliceTileSpawning;
+
+	/** Time in milliseconds the time sliced spawner may spend spawning tiles each frame. At least one tile is spawned per frame. */
+	UPROPERTY(EditAnywhere, Category = "Tile Style Dungeon", meta = (ClampMin = 0.1f, EditCondition = "bTimeSliceTileSpawning"))
+	float TileSpawnBudgetMs;
+
+	/** Should tile actors of a destroyed dungeon be deactivated and reused by the next one in game worlds, instead of being destroyed? */
+	UPROPERTY(EditAnywhere, Category = "Tile Style Dungeon")
+	bool bPoolTileActors;
+
+	/** Extra pooled tiles kept per class when trimming, as a fraction of the most tiles of that class the last dungeon used */
+	UPROPERTY(EditAnywhere, Category = "Tile Style Dungeon", meta = (ClampMin = 0.0f, EditCondition = "bPoolTileActors"))
+	float TilePoolSlack;
+
+	/** Deactivated tile actors per tile class */
+	UPROPERTY(Transient)
+	TMap<UClass*, FDungeonTilePool> TilePools;
+
+	/** One instanced mesh component per instanced tile class and portal region, every rotation of a class is drawn by the same component */
+	UPROPERTY(Transient)
+	TArray<UHierarchicalInstancedStaticMeshComponent*> TileMeshComponents;
+
 private:
-	FIntVector RoomSizeTotal;
 	FIntVector RoomSizeAverage;
 
+	/** The builder of the asynchronous generation in flight, if any */
+	TSharedPtr<FDungeonLayoutBuilder, ESPMode::ThreadSafe> ActiveBuilder;
+
+	FDungeonTilePoolStats TilePoolStats;
+
+	/** Incremented for every generation request, so results of superseded asynchronous generations are discarded */
+	int32 GenerationRequestId;
+
+	/** Tiles still to be spawned by the time sliced spawner, ordered outward from the spawn origin */
+	TArray<FPendingTileSpawn> PendingTileSpawns;
+
+	/** Index of the next tile in PendingTileSpawns to spawn */
+	int32 NextPendingTileSpawn;
+
+	/** Index into TileMeshComponents for every tile class and portal region */
+	TMap<TPair<UClass*, int32>, int32> TileMeshComponentIndices;
+
 public:	
 	// Sets default values for this actor's properties
 	ADungeonGenerator();
@@ -91,7 +298,9 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
+public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
@@ -101,23 +310,125 @@ public:
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Dungeon")
 	void GenerateRoomBasedDungeon();
 
+	/** Generates rooms, connections and the tile layout on a worker thread, then spawns the tiles on the game thread and broadcasts OnDungeonGenerated */
+	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Dungeon")
+	void GenerateDungeonAsync();
+
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Dungeon")
 	void DestroyDungeon();
 
+	/** Is an asynchronous generation currently running? */
+	UFUNCTION(BlueprintPure, Category = "Dungeon")
+	bool IsGenerating() const;
+
+	/** Progress of the running asynchronous generation in the range [0, 1], for loading screens */
+	UFUNCTION(BlueprintPure, Category = "Dungeon")
+	float GetGenerationProgress() const;
+
+	/** Is the time sliced spawner still adding tiles to the world? */
+	UFUNCTION(BlueprintPure, Category = "Dungeon")
+	bool IsSpawningTiles() const;
+
+	/** Progress of the time sliced spawner in the range [0, 1] */
+	UFUNCTION(BlueprintPure, Category = "Dungeon")
+	float GetTileSpawnProgress() const;
+
+	/** Counters of the tile actor pools */
+	UFUNCTION(BlueprintPure, Category = "Dungeon")
+	FDungeonTilePoolStats GetTilePoolStats() const { return TilePoolStats; };
+
+	/** Destroys every pooled tile actor */
+	UFUNCTION(BlueprintCallable, Category = "Dungeon")
+	void EmptyTilePools();
+
+	/** Returns the world transforms of every placement of a type, on the room floor and facing the placement's yaw */
+	UFUNCTION(BlueprintPure, Category = "Dungeon")
+	TArray<FTransform> GetPlacementTransforms(EDungeonPlacementType Type) const;
+
+	/** Gathers every property that affects the generated layout */
+	UFUNCTION(BlueprintPure, Category = "Dungeon")
+	FDungeonGenerationParams GetGenerationParams() const;
+
+	/**
+	 * Reads the generation params of the -Generator= class, ADungeonGenerator by default, and applies -Mode=Tiles, Rooms or All
+	 * from a commandlet's command line. Returns false and logs an error if the class can't be loaded or the mode is unknown.
+	 */
+	static bool ParseCommandletGenerationParams(const FString& CommandLine, FDungeonGenerationParams& OutParams);
+
 protected:
+	UFUNCTION()
+	void OnRep_ReplicatedLayout();
+
+	/**
+	 * Builds a layout from the given params on a worker thread, from the layout cache if bAllowCache is set and the cache is used.
+	 * If bVerifyChecksum is set, the result is checked against ExpectedChecksum before spawning.
+	 */
+	void StartAsyncGeneration(const FDungeonGenerationParams& Params, bool bVerifyChecksum, int32 ExpectedChecksum, bool bAllowCache = true);
+
+	/** Builds a layout on the game thread, from the layout cache if it is used */
+	void BuildLayout(FDungeonLayoutBuilder& Builder);
+
+	/** Returns true if layouts should go through the layout cache, which is only the case for fixed seeds */
+	bool ShouldUseLayoutCache() const;
+
+	/** Publishes the params and layout checksum of a dungeon the server just generated to the clients */
+	void ReplicateLayout(const FDungeonGenerationParams& Params, int32 Checksum);
+
 	TSubclassOf<ADungeonTile> GetTileClass(ETileType Type);
 
-	void GenerateRooms();
+	/** Picks the tile class and rotation matching the connections of a tile */
+	void GetTileClassAndRotation(ETileConnection Connection, TSubclassOf<ADungeonTile>& OutTileClass, FRotator& OutRotation) const;
 
-	void GenerateRoom();
+	/** Returns the world location of the center of a tile */
+	FVector GetTileLocation(const FIntVector& Coordinate) const;
 
-	void BuildConnections();
+	/** Returns the world location of the center of a corridor tile's floor */
+	FVector GetCorridorTileLocation(const FIntVector& Coordinate) const;
 
-	void DrawDebugDungeon();
+	/** Returns the instanced mesh component for a tile class in a portal region, creating it if needed. Tiles outside of every region use INDEX_NONE. */
+	UHierarchicalInstancedStaticMeshComponent* GetTileMeshComponent(TSubclassOf<ADungeonTile> TileClass, int32 Region);
+
+	/** Takes a tile actor from the pool of its class and moves it into place, or spawns one if the pool is empty */
+	ADungeonTile* AcquireTileActor(TSubclassOf<ADungeonTile> TileClass, const FTransform& Transform);
+
+	/** Returns a tile actor to the pool of its class, or destroys it if pooling is disabled */
+	void ReleaseTileActor(ADungeonTile* TileActor);
 
-	void GenerateTileLayout();
+	/** Destroys pooled tile actors beyond each pool's high water mark plus TilePoolSlack, then resets the high water marks */
+	void TrimTilePools();
 
+	/** Adds a single tile to the world, either as a mesh instance or as an actor, and registers it for culling with its portal region */
+	void SpawnTile(FTileData& TileData, const FVector& Location, const FVector& Size, int32 Region);
+
+	/** Returns the portal region of a tile, or INDEX_NONE if it isn't culled */
+	int32 GetTileRegion(const FDungeonTileGraph& TileGraph, const FTileData& TileData) const;
+
+	/** Picks a new seed if bRandomizeSeed is set */
+	void UpdateSeed();
+
+	/** Takes ownership of a generated layout's rooms, connections, tiles and portal graph */
+	void ApplyLayout(FDungeonLayout&& Layout);
+
+	/** Called on the game thread once the worker thread has finished building a layout */
+	void OnAsyncGenerationComplete(FDungeonLayoutBuilder& Builder, double GenerationTime, bool bVerifyChecksum, int32 ExpectedChecksum);
+
+	void DrawDebugDungeon();
+
+	/** Spawns every tile immediately */
 	void SpawnTileLayout();
 
-	FVector GetRandomPointInSphere(float Radius);
+	/** Spawns one stairs or shaft tile per floor climbed by every vertical connector */
+	void SpawnVerticalConnectors();
+
+	/** Spawns the player start and chest actors of the placements, on the server of game worlds only */
+	void SpawnPlacements();
+
+	/** Starts adding the tiles to the world, time sliced in game worlds if enabled or all at once otherwise */
+	void BeginTileSpawning();
+
+	/** Spawns pending tiles until the frame budget is used up, returns true once every tile has been spawned */
+	bool SpawnPendingTiles();
+
+	/** Returns the location of the first player start, or the center of the tile grid if there is none */
+	FVector GetTileSpawnOrigin() const;
 };
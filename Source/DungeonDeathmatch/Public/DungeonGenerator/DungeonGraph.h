@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Undirected weighted edge between two room indices */
+struct FDungeonGraphEdge
+{
+	int32 A;
+	int32 B;
+	float Weight;
+
+	FDungeonGraphEdge(int32 InA = INDEX_NONE, int32 InB = INDEX_NONE, float InWeight = 0.0f)
+	{
+		A = FMath::Min(InA, InB);
+		B = FMath::Max(InA, InB);
+		Weight = InWeight;
+	}
+
+	bool operator<(const FDungeonGraphEdge& Other) const
+	{
+		if (Weight != Other.Weight)
+		{
+			return Weight < Other.Weight;
+		}
+		// Tie break on the indices so sorting is stable across platforms and runs
+		return A != Other.A ? A < Other.A : B < Other.B;
+	}
+
+	bool operator==(const FDungeonGraphEdge& Other) const
+	{
+		return A == Other.A && B == Other.B;
+	}
+};
+
+/** Disjoint set forest over integer indices, using path compression and union by rank */
+class DUNGEONDEATHMATCH_API FDungeonUnionFind
+{
+private:
+	TArray<int32> Parents;
+	TArray<uint8> Ranks;
+	int32 NumSets;
+
+public:
+	FDungeonUnionFind(int32 NumElements = 0);
+
+	void Reset(int32 NumElements);
+
+	/** Returns the representative index of the set containing Element */
+	int32 Find(int32 Element);
+
+	/** Merges the sets containing A and B. Returns false if they were already in the same set. */
+	bool Union(int32 A, int32 B);
+
+	int32 GetNumSets() const { return NumSets; };
+};
+
+/** Graph helpers used by the dungeon generator to build room connections */
+class DUNGEONDEATHMATCH_API FDungeonGraph
+{
+public:
+	/**
+	 * Builds the Delaunay triangulation of the given points and returns its unique edges, weighted by point distance.
+	 * Uses the XY plane only, unless bTetrahedralize is set in which case a 3D Delaunay tetrahedralization is built.
+	 * Falls back to a 2D triangulation or the complete graph when the point set is too small or degenerate.
+	 */
+	static TArray<FDungeonGraphEdge> Triangulate(const TArray<FVector>& Points, bool bTetrahedralize);
+
+	/** Returns every edge of the complete graph over the points. Only intended for small or degenerate point sets. */
+	static TArray<FDungeonGraphEdge> BuildCompleteGraph(const TArray<FVector>& Points);
+
+	/**
+	 * Runs Kruskal's algorithm over the candidate edges. Edges that are part of the minimum spanning forest are added to OutTreeEdges,
+	 * every other edge is added to OutRemainingEdges in ascending weight order. Returns the number of disconnected components left.
+	 */
+	static int32 BuildMinimumSpanningTree(int32 NumNodes, TArray<FDungeonGraphEdge> CandidateEdges, TArray<FDungeonGraphEdge>& OutTreeEdges, TArray<FDungeonGraphEdge>& OutRemainingEdges);
+
+private:
+	static TArray<FDungeonGraphEdge> Triangulate2D(const TArray<FVector>& Points);
+
+	static TArray<FDungeonGraphEdge> Tetrahedralize3D(const TArray<FVector>& Points);
+
+	static void AddUniqueEdges(const TArray<uint64>& EdgeKeys, const TArray<FVector>& Points, TArray<FDungeonGraphEdge>& OutEdges);
+};
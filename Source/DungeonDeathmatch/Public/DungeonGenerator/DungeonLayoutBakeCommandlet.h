@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DungeonLayoutBakeCommandlet.generated.h"
+
+/**
+ * Pre-bakes dungeon layouts into the layout cache, so servers load them instead of generating them. The params are taken from
+ * a generator class, the native ADungeonGenerator unless -Generator= names a blueprint. -Mode= picks which generation function
+ * the layouts are baked for: Tiles for GenerateDungeon, Rooms for GenerateRoomBasedDungeon or All for GenerateDungeonAsync.
+ *
+ * UE4Editor-Cmd DungeonDeathmatch.uproject -run=DungeonLayoutBake -nullrhi -Seeds=1,2,3 -Generator=/Game/Blueprints/BP_DungeonGenerator.BP_DungeonGenerator_C -Mode=All
+ */
+UCLASS()
+class DUNGEONDEATHMATCH_API UDungeonLayoutBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDungeonLayoutBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <HAL/ThreadSafeCounter.h>
+
+#include "DungeonBrickOccupancy.h"
+#include "DungeonOccupancyGrid.h"
+#include "DungeonEnums.h"
+#include "DungeonGraph.h"
+#include "DungeonPortalGraph.h"
+#include "DungeonRoomSet.h"
+#include "DungeonTileGraph.h"
+
+/** The pure data result of a dungeon generation, with no actors or world references */
+struct FDungeonLayout
+{
+	/** Seed the layout was built from, also used to create reproducible room GUIDs for the output */
+	int32 Seed;
+
+	FDungeonRoomSet Rooms;
+
+	/** Room index pairs of every connection, weighted by the distance between the room centers */
+	TArray<FDungeonGraphEdge> Connections;
+
+	FDungeonTileGraph Tiles;
+
+	/** Corridor tiles carved between connected rooms, in room grid cells */
+	FDungeonTileGraph Corridors;
+
+	/** Stairs and shafts where corridors climb between floors */
+	TArray<FDungeonVerticalConnector> VerticalConnectors;
+
+	/** Player starts, chests and AI spawns, with the player starts first */
+	TArray<FDungeonPlacement> Placements;
+
+	/** Rooms and corridor groups joined by their doorways, for visibility culling */
+	FDungeonPortalGraph PortalGraph;
+
+	FIntVector RoomSizeAverage;
+
+	FDungeonLayout()
+	{
+		Seed = 0;
+		RoomSizeAverage = FIntVector(0, 0, 0);
+	}
+
+	/** Returns a checksum of the rooms, connections and tiles, used to verify that a client rebuilt the same layout as the server */
+	uint32 GetChecksum() const;
+
+	/** Creates the room and connection structs exposed on the generator, with GUIDs that are the same for every build of the layout */
+	void CreateRoomOutput(TArray<FDungeonRoom>& OutRooms, TArray<FDungeonConnection>& OutConnections) const;
+};
+
+/** Timings and counters of a single builder run, for profiling and benchmarks */
+struct FDungeonGenerationStats
+{
+	/** Time spent in each stage, in seconds */
+	double RoomsTime;
+	double ConnectionsTime;
+	double SpawnsTime;
+	double CorridorsTime;
+	double TilesTime;
+
+	/** Number of room locations tested against the occupancy volume */
+	int32 PlacementAttempts;
+
+	/** Number of rooms that could not be placed, within MaxPlacementAttempts or because every seed was used up */
+	int32 FailedPlacements;
+
+	/** Number of room centers seeded by the Poisson-disc placement strategy */
+	int32 PlacementSeeds;
+
+	/** Number of corridors routed again because they ran into a corridor routed in parallel */
+	int32 ReroutedCorridors;
+
+	/** Number of connections no corridor route was found for */
+	int32 FailedCorridors;
+
+	/** Was the layout read from the layout cache instead of being built? */
+	bool bLoadedFromCache;
+
+	FDungeonGenerationStats()
+	{
+		RoomsTime = 0.0;
+		ConnectionsTime = 0.0;
+		SpawnsTime = 0.0;
+		CorridorsTime = 0.0;
+		TilesTime = 0.0;
+		PlacementAttempts = 0;
+		FailedPlacements = 0;
+		PlacementSeeds = 0;
+		ReroutedCorridors = 0;
+		FailedCorridors = 0;
+		bLoadedFromCache = false;
+	}
+};
+
+/**
+ * Builds a dungeon layout from a set of generation parameters. Every random decision is drawn from a stream seeded by the
+ * parameters, and nothing here touches the world or any UObject, so a builder can safely run on a worker thread.
+ */
+class DUNGEONDEATHMATCH_API FDungeonLayoutBuilder
+{
+private:
+	FDungeonGenerationParams Params;
+
+	FRandomStream RandomStream;
+
+	FDungeonLayout Layout;
+
+	/** Occupied room cells, used to reject overlapping room placements in large or tall room grids */
+	FDungeonBrickOccupancy RoomOccupancy;
+
+	/** Occupied room cells of room grids small enough for a dense volume, whose summed-volume table makes every test O(1) */
+	FDungeonOccupancyGrid DenseRoomOccupancy;
+
+	bool bUseDenseRoomOccupancy;
+
+	FIntVector RoomSizeTotal;
+
+	FDungeonGenerationStats Stats;
+
+	/** Generation progress in thousandths, readable from any thread */
+	FThreadSafeCounter ProgressPermille;
+
+public:
+	FDungeonLayoutBuilder(const FDungeonGenerationParams& InParams);
+
+	/** Runs every generation stage enabled in the params, in order */
+	void Build();
+
+	/** Loads the layout from the layout cache if it holds one for the params, otherwise builds it and adds it to the cache */
+	void BuildCached();
+
+	/** Places rooms in the room grid with the placement strategy of the params */
+	void GenerateRooms();
+
+	/** Connects the generated rooms with a minimum spanning tree plus optional extra connections */
+	void BuildConnections();
+
+	/**
+	 * Places player starts, chests and AI spawns in the rooms, using distances in connections from a multi-source BFS over the
+	 * room graph. Player starts are spread by farthest point sampling, then every room is assigned to its nearest player start
+	 * and chests and AI spawns are handed out to the player starts in turn, nearest rooms first for chests and furthest rooms
+	 * first for AI spawns, so every player gets the same share at the same distance wherever the layout allows it.
+	 */
+	void PlaceSpawns();
+
+	/** Routes a corridor through the room grid for every connection, and builds the vertical connectors and the portal graph of rooms and corridors */
+	void CarveCorridors();
+
+	/** Grows the tile layout out from the center of the tile grid */
+	void GenerateTileLayout();
+
+	const FDungeonGenerationParams& GetParams() const { return Params; };
+
+	const FDungeonLayout& GetLayout() const { return Layout; };
+
+	const FDungeonGenerationStats& GetStats() const { return Stats; };
+
+	/** Moves the generated layout out of the builder */
+	FDungeonLayout&& ConsumeLayout() { return MoveTemp(Layout); };
+
+	/** Returns overall generation progress in the range [0, 1]. Safe to call from any thread. */
+	float GetProgress() const { return ProgressPermille.GetValue() / 1000.0f; };
+
+private:
+	/**
+	 * Adds up to AdditionalConnectionsRatio extra connections from the candidate edges left out of the spanning tree. Each pick
+	 * takes the shortest unused candidate of a random room that keeps both rooms within MaxRoomConnections and closes a loop no
+	 * longer than MaxLoopLength through the tree.
+	 */
+	void AddExtraConnections(const TArray<FDungeonGraphEdge>& TreeEdges, const TArray<FDungeonGraphEdge>& RemainingEdges);
+
+	/** Returns a placement on the floor of a room. Player starts take the room's center cell, anything else a random cell not used by an earlier placement. */
+	FDungeonPlacement MakePlacement(EDungeonPlacementType Type, int32 Room, TArray<TArray<FIntVector>>& UsedRoomCells);
+
+	/** Turns the vertical steps of the corridor paths into one stairs or shaft connector per vertical run */
+	void BuildVerticalConnectors(const TArray<TArray<FIntVector>>& Paths);
+
+	/** Attempts to place a single random room, returns false if no free location was found within MaxPlacementAttempts */
+	bool GenerateRoom();
+
+	/** Places rooms around Poisson-disc sampled seeds until NumberOfRooms are placed or the seeds run out */
+	void GenerateRoomsAtSeeds();
+
+	/** Samples room centers in the room grid that are at least a padded average room size apart, in random order */
+	void GeneratePoissonDiscSeeds(TArray<FVector>& OutSeeds);
+
+	/** Attempts to fit a room around a seed, shrinking it towards RoomSizeMin if it doesn't fit. Returns false if even that fails. */
+	bool GenerateRoomAtSeed(const FVector& RoomSeed);
+
+	FIntVector GetRandomRoomSize();
+
+	/** Returns true if a room at Location with Size keeps MinRoomDistance to every placed room */
+	bool IsRoomLocationFree(const FIntVector& Location, const FIntVector& Size) const;
+
+	void AddRoom(const FIntVector& Location, const FIntVector& Size);
+
+	/** Reseeds the random stream for a stage, so each stage's output only depends on the seed and not on which stages ran before it */
+	void BeginStage(uint32 StageIndex);
+
+	/** Creates a GUID from the random stream, so generated GUIDs are reproducible as well */
+	FGuid NewGuid();
+
+	void SetProgress(float Progress);
+};
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "DungeonEnums.h"
+
+struct FDungeonLayout;
+class FDungeonTileGraph;
+
+/**
+ * On-disk cache of generated dungeon layouts in Saved/DungeonLayouts, one versioned binary file per set of generation params.
+ * Layouts only depend on their params, so a cached layout is identical to a freshly built one and loading it skips generation.
+ * Files from an older DUNGEON_LAYOUT_CACHE_VERSION or for different params are never used.
+ */
+class DUNGEONDEATHMATCH_API FDungeonLayoutCache
+{
+public:
+	/** Loads the cached layout for the params. Returns false if there is none or the file is outdated or damaged. */
+	static bool Load(const FDungeonGenerationParams& Params, FDungeonLayout& OutLayout);
+
+	/** Writes a layout built from the params to the cache, replacing any previous file */
+	static bool Save(const FDungeonGenerationParams& Params, const FDungeonLayout& Layout);
+
+	/** Returns the cache file of the params */
+	static FString GetCacheFilePath(const FDungeonGenerationParams& Params);
+
+	/** Reads or writes a layout in the cache's binary format, without the file header */
+	static void SerializeLayout(FArchive& Ar, FDungeonLayout& Layout);
+
+private:
+	/** Reads or writes every generation param that affects the layout */
+	static void SerializeParams(FArchive& Ar, FDungeonGenerationParams& Params);
+
+	static void SerializeTileGraph(FArchive& Ar, FDungeonTileGraph& TileGraph);
+
+	/** Returns the file header, which is a magic number, the version and the params the layout was built from */
+	static TArray<uint8> MakeHeader(const FDungeonGenerationParams& Params);
+
+	/** Returns a hash of the serialized params, used as the cache file name */
+	static uint32 GetParamsHash(const FDungeonGenerationParams& Params);
+};
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "DungeonNavigationComponent.generated.h"
+
+class UPrimitiveComponent;
+
+/* Event delegate for when the navmesh of every spawned region has been built, with the seconds it took after the first region was released */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnDungeonNavigationReadySignature, float, BuildTime);
+
+/**
+ * Batches the runtime navmesh updates of a spawning dungeon. Tiles are kept out of the navigation octree while they are spawned
+ * over several frames, and every portal region is handed to the navigation system in one go once its last tile is in place. The
+ * dynamic navmesh then only rebuilds the navmesh tiles under that region's bounds, once and on its worker threads, instead of
+ * rebuilding the same navmesh tiles every frame as neighbouring tiles trickle in. Regions are released in spawn order, so the
+ * area around the players becomes navigable first.
+ *
+ * Needs a RecastNavMesh with dynamic runtime generation and a navmesh bounds volume covering the dungeon in the level.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class DUNGEONDEATHMATCH_API UDungeonNavigationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	/* Delegate called once the navmesh of the spawned dungeon is fully built */
+	UPROPERTY(BlueprintAssignable, Category = "Navigation")
+	FOnDungeonNavigationReadySignature OnNavigationReady;
+
+protected:
+	/** Should tiles only update the navmesh once their whole region has spawned? Otherwise every tile dirties the navmesh as it spawns. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation")
+	bool bDeferNavigationUpdates;
+
+private:
+	/** Components kept out of navigation for every region, with the tiles outside of every region in the last slot */
+	TArray<TArray<TWeakObjectPtr<UPrimitiveComponent>>> RegionComponents;
+
+	/** Tiles still to be spawned in every region, same slots as RegionComponents */
+	TArray<int32> RegionPendingTiles;
+
+	int32 NumReleasedRegions;
+
+	/** Are navigation updates currently being deferred? Only in game worlds with a navigation system. */
+	bool bIsDeferring;
+
+	/** Is the navigation system still building the released regions? */
+	bool bIsWaitingForNavigation;
+
+	double FirstReleaseTime;
+
+	/** Frame the last region was released in */
+	uint64 LastReleaseFrame;
+
+public:
+	// Sets default values for this component's properties
+	UDungeonNavigationComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Starts deferring navigation updates for a dungeon about to be spawned. Releases anything still deferred from the last one. */
+	void BeginDeferredUpdates(int32 NumRegions);
+
+	/** Counts a tile that will be spawned in a region, so the region is released once all of them are spawned */
+	void AddPendingTile(int32 Region);
+
+	/** Called after a tile of a region was spawned, releases the region if it was the last one */
+	void OnTileSpawned(int32 Region);
+
+	/** Keeps a tile mesh component out of navigation until its region is released. Call before registering the component. */
+	void DeferComponent(int32 Region, UPrimitiveComponent* Component);
+
+	/** Keeps the navigation relevant components of a tile actor out of navigation until its region is released */
+	void DeferActor(int32 Region, AActor* Actor);
+
+	/** Releases every region that is still deferred, for when the whole dungeon has been spawned */
+	void ReleaseAllRegions();
+
+	/** Releases everything deferred and stops deferring, without waiting for the navmesh */
+	void Reset();
+
+	/** Has the navmesh of the spawned dungeon been built? */
+	UFUNCTION(BlueprintPure, Category = "Navigation")
+	bool IsNavigationReady() const;
+
+private:
+	/** Returns the slot of a region in RegionComponents, tiles outside of every region use the last slot */
+	int32 GetRegionSlot(int32 Region) const;
+
+	/** Lets the components of a region affect navigation again, which dirties their bounds in the navmesh */
+	void ReleaseRegion(int32 Slot);
+};
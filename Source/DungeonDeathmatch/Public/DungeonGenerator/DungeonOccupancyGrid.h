@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Dense bit-packed 3D occupancy volume used for room placement. Each row along X is packed into 64 bit words, so box fills and
+ * overlap tests touch one word per 64 cells. A summed-volume table of the occupied cells is kept alongside the bits and rebuilt
+ * lazily, which turns box overlap tests into eight lookups regardless of the size of the box.
+ */
+class DUNGEONDEATHMATCH_API FDungeonOccupancyGrid
+{
+private:
+	/** Grid coordinate of the first cell in the volume */
+	FIntVector Origin;
+
+	/** Number of cells along each axis */
+	FIntVector Dimensions;
+
+	int32 WordsPerRow;
+
+	TArray<uint64> Words;
+
+	/** Inclusive prefix sums of occupied cells, padded by one cell on each axis so lookups don't need bounds checks */
+	mutable TArray<int32> SummedVolume;
+
+	mutable bool bIsSummedVolumeDirty;
+
+	/** Word-level query cost spent since the last change, used to decide when rebuilding the summed-volume table pays off */
+	mutable int64 DirtyQueryCost;
+
+public:
+	FDungeonOccupancyGrid();
+
+	/** Sizes the volume to cover [InOrigin, InOrigin + InDimensions) and clears it */
+	void Init(const FIntVector& InOrigin, const FIntVector& InDimensions);
+
+	/** Clears every cell without resizing the volume */
+	void Reset();
+
+	FIntVector GetOrigin() const { return Origin; };
+
+	FIntVector GetDimensions() const { return Dimensions; };
+
+	bool IsCellOccupied(const FIntVector& Cell) const;
+
+	/** Returns true if any cell in the half open box [Min, Max) is occupied. Cells outside of the volume are treated as free. */
+	bool IsBoxOccupied(const FIntVector& Min, const FIntVector& Max) const;
+
+	/** Returns the number of occupied cells in the half open box [Min, Max) */
+	int32 CountOccupied(const FIntVector& Min, const FIntVector& Max) const;
+
+	/** Marks every cell in the half open box [Min, Max) as occupied. Cells outside of the volume are ignored. */
+	void FillBox(const FIntVector& Min, const FIntVector& Max);
+
+	/** Rebuilds the summed-volume table now, so following box queries are O(1) */
+	void BuildSummedVolume() const;
+
+private:
+	/** Converts a world grid box to local cell coordinates clamped to the volume. Returns false if the box is empty after clamping. */
+	bool ClampBox(const FIntVector& Min, const FIntVector& Max, FIntVector& OutMin, FIntVector& OutMax) const;
+
+	bool IsLocalBoxOccupiedWords(const FIntVector& LocalMin, const FIntVector& LocalMax) const;
+
+	int32 CountLocalBoxSummed(const FIntVector& LocalMin, const FIntVector& LocalMax) const;
+
+	FORCEINLINE int32 GetRowIndex(int32 Y, int32 Z) const
+	{
+		return (Z * Dimensions.Y + Y) * WordsPerRow;
+	}
+
+	FORCEINLINE int32 GetSummedIndex(int32 X, int32 Y, int32 Z) const
+	{
+		return (Z * (Dimensions.Y + 1) + Y) * (Dimensions.X + 1) + X;
+	}
+
+	/** Returns a mask of the bits in [FirstBit, LastBit] of a single word */
+	static FORCEINLINE uint64 GetWordMask(int32 FirstBit, int32 LastBit)
+	{
+		uint64 HighMask = LastBit >= 63 ? ~0ull : ((1ull << (LastBit + 1)) - 1);
+		uint64 LowMask = ~((1ull << FirstBit) - 1);
+		return HighMask & LowMask;
+	}
+};
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "DungeonPortalCullingComponent.generated.h"
+
+class FDungeonPortalGraph;
+class UPrimitiveComponent;
+class APlayerController;
+
+/**
+ * Hides the parts of a generated dungeon the local player can't see. Every frame the regions of the dungeon's portal graph are
+ * flood filled from the region the camera is in, only passing through portals inside the camera's view cone. Tiles, items and
+ * chests in regions that weren't reached are hidden for the local player's view only, so gameplay visibility is left untouched.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class DUNGEONDEATHMATCH_API UDungeonPortalCullingComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+protected:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Culling")
+	bool bEnableCulling;
+
+	/** Angle in degrees added to the camera's field of view when testing portals, so portals at the edge of the screen aren't culled early */
+	UPROPERTY(EditAnywhere, Category = "Culling", meta = (ClampMin = 0.0f, ClampMax = 90.0f))
+	float PortalAngleMargin;
+
+	/** How often items and chests are sorted into regions again, in seconds, since they can move around */
+	UPROPERTY(EditAnywhere, Category = "Culling", meta = (ClampMin = 0.0f))
+	float DynamicActorRefreshInterval;
+
+private:
+	const FDungeonPortalGraph* PortalGraph;
+
+	/** World size of a room grid cell */
+	FVector CellSize;
+
+	/** Tile components and actors of every region, registered once when the dungeon is spawned */
+	TArray<TArray<TWeakObjectPtr<UPrimitiveComponent>>> RegionComponents;
+	TArray<TArray<TWeakObjectPtr<AActor>>> RegionActors;
+
+	/** Items and chests of every region, sorted again every DynamicActorRefreshInterval */
+	TArray<TArray<TWeakObjectPtr<AActor>>> RegionDynamicActors;
+
+	/** Regions currently hidden from CullingController's view */
+	TArray<bool> HiddenRegions;
+
+	/** Components and actors that should be hidden from CullingController's view */
+	TSet<TWeakObjectPtr<UPrimitiveComponent>> CulledComponents;
+	TSet<TWeakObjectPtr<AActor>> CulledActors;
+
+	/** Components and actors last added to CullingController's hidden lists */
+	TSet<TWeakObjectPtr<UPrimitiveComponent>> AppliedComponents;
+	TSet<TWeakObjectPtr<AActor>> AppliedActors;
+
+	/** Whether the culled sets changed since they were last copied into CullingController's hidden lists */
+	bool bCulledSetsDirty;
+
+	/** The local player controller whose view the regions are hidden from */
+	TWeakObjectPtr<APlayerController> CullingController;
+
+	float TimeSinceDynamicActorRefresh;
+
+public:	
+	// Sets default values for this component's properties
+	UDungeonPortalCullingComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Starts culling against a new portal graph, or stops culling if it is null. Clears every registered component and actor. */
+	void SetPortalGraph(const FDungeonPortalGraph* InPortalGraph, const FVector& InCellSize);
+
+	/** Registers a tile mesh component that should be hidden with its region */
+	void RegisterRegionComponent(int32 Region, UPrimitiveComponent* Component);
+
+	/** Registers a tile actor that should be hidden with its region */
+	void RegisterRegionActor(int32 Region, AActor* Actor);
+
+	/** Returns the region containing a world location, or INDEX_NONE */
+	int32 FindRegionAtLocation(const FVector& Location) const;
+
+	/** Number of regions currently hidden from the local player */
+	UFUNCTION(BlueprintPure, Category = "Culling")
+	int32 GetNumHiddenRegions() const;
+
+private:
+	/** Flood fills the regions visible from the camera. Returns false if the camera isn't inside the dungeon. */
+	bool FindVisibleRegions(const FVector& CameraLocation, const FRotator& CameraRotation, float FOVAngle, TArray<bool>& OutVisibleRegions) const;
+
+	bool IsPortalVisible(const FBox& Bounds, const FVector& CameraLocation, const FVector& CameraForward, float CosHalfAngle) const;
+
+	/** Sorts every item and chest into the region it is in, except items attached to or owned by a character */
+	void RefreshDynamicActors();
+
+	void SetRegionHidden(int32 Region, bool bIsHidden);
+
+	void SetActorsHidden(const TArray<TWeakObjectPtr<AActor>>& Actors, bool bIsHidden);
+
+	/**
+	 * Copies the culled sets into CullingController's hidden lists. The lists are arrays, so they are rebuilt once in a single pass
+	 * instead of adding and removing every actor on its own.
+	 */
+	void ApplyCulledSets();
+
+	/** Unhides every region and clears them from CullingController's hidden lists */
+	void ShowAllRegions();
+};
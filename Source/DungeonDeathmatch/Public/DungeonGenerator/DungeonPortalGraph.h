@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "DungeonEnums.h"
+#include "DungeonRoomSet.h"
+#include "DungeonTileGraph.h"
+
+/** Doorway between two regions of a dungeon */
+struct FDungeonPortal
+{
+	int32 RegionA;
+	int32 RegionB;
+
+	/** Doorway rectangle in room grid units. The box is flat along the axis the doorway faces. */
+	FBox Bounds;
+
+	FDungeonPortal(int32 InRegionA = INDEX_NONE, int32 InRegionB = INDEX_NONE, const FBox& InBounds = FBox(ForceInit))
+	{
+		RegionA = InRegionA;
+		RegionB = InRegionB;
+		Bounds = InBounds;
+	}
+
+	/** Returns the region on the other side of the portal */
+	int32 GetOtherRegion(int32 Region) const
+	{
+		return Region == RegionA ? RegionB : RegionA;
+	}
+};
+
+/**
+ * Splits a generated dungeon into regions joined by portals. Every room is a region, numbered like the room list, and every
+ * connected group of corridor tiles is a region numbered after the rooms. Portals are the doorways where corridors enter rooms.
+ */
+class DUNGEONDEATHMATCH_API FDungeonPortalGraph
+{
+private:
+	/** Room volumes in room grid cells, as half open boxes [Min, Max) */
+	TArray<TPair<FIntVector, FIntVector>> RoomBounds;
+
+	int32 NumRegions;
+
+	/** Region of every corridor tile, keyed by its cell */
+	TMap<FIntVector, int32> CorridorCellRegions;
+
+	/** Room of every cell inside a room, keyed by its cell */
+	TMap<FIntVector, int32> RoomCellRooms;
+
+	TArray<FDungeonPortal> Portals;
+
+	/** Indices into Portals for every region */
+	TArray<TArray<int32>> RegionPortals;
+
+	/** Center of every region in room grid units, the average cell center for corridor regions */
+	TArray<FVector> RegionCenters;
+
+public:
+	FDungeonPortalGraph();
+
+	/** Rebuilds the regions and portals for a set of rooms and the corridors carved between them */
+	void Build(const FDungeonRoomSet& Rooms, const FDungeonTileGraph& Corridors);
+
+	void Empty();
+
+	int32 GetNumRegions() const { return NumRegions; };
+
+	int32 GetNumRooms() const { return RoomBounds.Num(); };
+
+	const TArray<FDungeonPortal>& GetPortals() const { return Portals; };
+
+	const TArray<int32>& GetRegionPortals(int32 Region) const { return RegionPortals[Region]; };
+
+	const FVector& GetRegionCenter(int32 Region) const { return RegionCenters[Region]; };
+
+	/** Returns the region containing a room grid cell, or INDEX_NONE if the cell is outside of every room and corridor */
+	int32 FindRegion(const FIntVector& Cell) const;
+
+	/** Returns the region of a corridor tile, or INDEX_NONE */
+	int32 FindCorridorRegion(const FIntVector& Cell) const;
+
+private:
+	int32 FindRoom(const FIntVector& Cell) const;
+};
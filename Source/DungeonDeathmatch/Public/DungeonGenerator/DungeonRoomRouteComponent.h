@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "DungeonRoomRouteComponent.generated.h"
+
+class FDungeonPortalGraph;
+
+/**
+ * Coarse pathfinding over the rooms and corridors of a generated dungeon. When a dungeon is spawned, the shortest route between
+ * every pair of portal graph regions is precomputed as a next doorway table, so a route query is a walk through the table. AI
+ * breaks long moves into short navmesh moves between the doorways of a route instead of pathfinding across the whole map.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class DUNGEONDEATHMATCH_API UDungeonRoomRouteComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+private:
+	const FDungeonPortalGraph* PortalGraph;
+
+	/** World size of a room grid cell */
+	FVector CellSize;
+
+	int32 NumRegions;
+
+	/** Portal to walk through next, for every pair of regions indexed [From * NumRegions + To], INDEX_NONE if To can't be reached */
+	TArray<int32> NextPortals;
+
+	/** World location every portal is walked through, at the center of the doorway's floor */
+	TArray<FVector> PortalWaypoints;
+
+public:	
+	// Sets default values for this component's properties
+	UDungeonRoomRouteComponent();
+
+	/** Precomputes the routes of a new portal graph, or clears them if it is null */
+	void SetPortalGraph(const FDungeonPortalGraph* InPortalGraph, const FVector& InCellSize);
+
+	/**
+	 * Finds the doorways to walk through to get from Start to End, followed by End itself. If either location is outside of the
+	 * dungeon, or both are in the same room or corridor, the route is just End. Returns false if End can't be reached from Start.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Dungeon|Navigation")
+	bool FindRoomRoute(const FVector& Start, const FVector& End, TArray<FVector>& OutWaypoints) const;
+
+	/** Returns the portal graph region containing a world location, or INDEX_NONE */
+	int32 FindRegionAtLocation(const FVector& Location) const;
+
+	/** Returns the route component of the dungeon generator in a world, if there is one */
+	static UDungeonRoomRouteComponent* FindInWorld(UWorld* World);
+
+private:
+	/** Runs Dijkstra from every region over the doorways, recording the first doorway of every shortest route */
+	void BuildRouteTable();
+};
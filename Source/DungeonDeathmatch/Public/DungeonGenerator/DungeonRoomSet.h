@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Working set of generated rooms, stored as parallel arrays addressed by room index. Graph stages only read the locations or
+ * sizes they need, and nothing is copied into connections, which just refer to rooms by index.
+ */
+struct FDungeonRoomSet
+{
+	/** Minimum corner of every room in room grid cells */
+	TArray<FIntVector> Locations;
+
+	/** Size of every room in room grid cells */
+	TArray<FIntVector> Sizes;
+
+	int32 Num() const { return Locations.Num(); };
+
+	void Empty(int32 ExpectedNumRooms = 0)
+	{
+		Locations.Empty(ExpectedNumRooms);
+		Sizes.Empty(ExpectedNumRooms);
+	}
+
+	/** Adds a room and returns its index */
+	int32 Add(const FIntVector& Location, const FIntVector& Size)
+	{
+		Sizes.Add(Size);
+		return Locations.Add(Location);
+	}
+
+	/** Returns the end of a room's half open volume [Location, Location + Size) */
+	FIntVector GetMax(int32 Index) const
+	{
+		return Locations[Index] + Sizes[Index];
+	}
+
+	FVector GetCenter(int32 Index) const
+	{
+		return FVector(Locations[Index]) + FVector(Sizes[Index]) * 0.5f;
+	}
+};
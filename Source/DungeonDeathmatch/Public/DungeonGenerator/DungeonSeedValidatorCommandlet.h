@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DungeonSeedValidatorCommandlet.generated.h"
+
+/**
+ * Validates a range of seeds for a seed pool. Every seed is built headless and in parallel with the params of a generator class,
+ * each builder drawing from its own random stream, and checked for connectivity, rooms placed, tiles generated, dead end ratio and
+ * generation time. Seeds are ranked by quality into a CSV report, and seeds that are disconnected, degenerate or much slower than
+ * the median are flagged. -Pool= additionally writes the seeds that passed in rank order. Every switch but -Seeds= is optional:
+ *
+ * UE4Editor-Cmd DungeonDeathmatch.uproject -run=DungeonSeedValidator -nullrhi -Seeds=5000 -FirstSeed=0 -Generator=/Game/Blueprints/BP_DungeonGenerator.BP_DungeonGenerator_C
+ *     -Mode=All -MinRoomRatio=0.9 -MaxDeadEndRatio=0.3 -SlowFactor=3 -MaxMs=0 -Output=SeedReport.csv -Pool=SeedPool.txt -FailOnFlagged
+ */
+UCLASS()
+class DUNGEONDEATHMATCH_API UDungeonSeedValidatorCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDungeonSeedValidatorCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -7,10 +7,28 @@
 
 #include "DungeonTile.generated.h"
 
+class UStaticMesh;
+
 UCLASS()
 class DUNGEONDEATHMATCH_API ADungeonTile : public AActor
 {
 	GENERATED_BODY()
+
+protected:
+	/** Mesh drawn through the dungeon generator's instanced mesh components for tiles that aren't spawned as actors */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tile")
+	UStaticMesh* TileMesh;
+
+	/** Does this tile need its own actor for gameplay logic? Tiles without a TileMesh are always spawned as actors. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tile")
+	bool bRequiresActor;
+
+private:
+	/** Is the tile part of the current dungeon, as opposed to waiting in the generator's tile pool? */
+	bool bIsTileActive;
+
+	/** Was ticking enabled when the tile was deactivated? */
+	bool bWasTickEnabled;
 	
 public:	
 	// Sets default values for this actor's properties
@@ -24,4 +42,20 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	UStaticMesh* GetTileMesh() const { return TileMesh; };
+
+	bool GetRequiresActor() const { return bRequiresActor; };
+
+	/** Can this tile be drawn as a mesh instance instead of being spawned as an actor? */
+	bool CanBeInstanced() const { return TileMesh && !bRequiresActor; };
+
+	/** Activates a pooled tile for a new dungeon, or deactivates it by hiding it and turning off its collision and ticking */
+	virtual void SetTileActive(bool bIsActive);
+
+	bool IsTileActive() const { return bIsTileActive; };
+
+protected:
+	/** Called when a pooled tile is activated again for a new dungeon, for resetting any state from its previous use */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Tile")
+	void OnTileReused();
 };
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "DungeonEnums.h"
+
+/**
+ * Tiles of a dungeon stored in a flat array, so each tile has a stable integer index, with a hash from grid coordinate to
+ * index. Neighbor lookups are a single hash lookup and tiles are never moved or re-added to update them.
+ */
+class DUNGEONDEATHMATCH_API FDungeonTileGraph
+{
+private:
+	TArray<FTileData> Tiles;
+
+	TMap<FIntVector, int32> TileIndices;
+
+public:
+	/** Removes every tile, keeping enough memory for ExpectedNumTiles tiles */
+	void Empty(int32 ExpectedNumTiles = 0);
+
+	/** Adds a tile at its coordinate and returns its index, or INDEX_NONE if the coordinate is already taken */
+	int32 Add(const FTileData& Tile);
+
+	/** Returns the index of the tile at a coordinate, or INDEX_NONE if there is none */
+	int32 FindIndex(const FIntVector& Coordinate) const;
+
+	FTileData* Find(const FIntVector& Coordinate);
+
+	const FTileData* Find(const FIntVector& Coordinate) const;
+
+	bool Contains(const FIntVector& Coordinate) const { return TileIndices.Contains(Coordinate); };
+
+	int32 Num() const { return Tiles.Num(); };
+
+	FTileData& operator[](int32 Index) { return Tiles[Index]; };
+
+	const FTileData& operator[](int32 Index) const { return Tiles[Index]; };
+
+	TArray<FTileData>& GetTiles() { return Tiles; };
+
+	const TArray<FTileData>& GetTiles() const { return Tiles; };
+
+	/** Returns the index of the tile next to a tile in a direction, or INDEX_NONE if there is none */
+	int32 GetNeighborIndex(int32 Index, ECardinalDirection Direction) const;
+
+	/** Marks two neighboring tiles as connected to each other */
+	void Connect(int32 Index, ECardinalDirection Direction, int32 NeighborIndex);
+
+	/** Returns the grid offset of a step in a direction */
+	static FIntVector GetDirectionOffset(ECardinalDirection Direction);
+
+	static ECardinalDirection GetOppositeDirection(ECardinalDirection Direction);
+
+	/** Finds the direction of a single horizontal grid step. Returns false for any other offset. */
+	static bool GetDirectionFromOffset(const FIntVector& Offset, ECardinalDirection& OutDirection);
+};
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "DungeonTilePool.generated.h"
+
+class ADungeonTile;
+
+/** Deactivated tile actors of a single class, kept by the dungeon generator for reuse in the next dungeon */
+USTRUCT()
+struct FDungeonTilePool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<ADungeonTile*> FreeTiles;
+
+	/** Tiles of this class currently in use by the dungeon */
+	int32 NumActive;
+
+	/** Most tiles of this class in use at once since the pool was last trimmed */
+	int32 HighWaterMark;
+
+	FDungeonTilePool()
+	{
+		NumActive = 0;
+		HighWaterMark = 0;
+	}
+};
+
+/** Counters of the dungeon generator's tile actor pools, summed over every tile class */
+USTRUCT(BlueprintType)
+struct FDungeonTilePoolStats
+{
+	GENERATED_BODY()
+
+	/** Tile actors spawned because no pooled actor was available */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 NumSpawned;
+
+	/** Tile actors taken from a pool instead of being spawned */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 NumReused;
+
+	/** Tile actors returned to a pool when a dungeon was destroyed */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 NumReleased;
+
+	/** Pooled tile actors destroyed because a pool grew past its high water mark */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 NumTrimmed;
+
+	/** Tile actors currently waiting in a pool */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 NumPooled;
+
+	FDungeonTilePoolStats()
+	{
+		NumSpawned = 0;
+		NumReused = 0;
+		NumReleased = 0;
+		NumTrimmed = 0;
+		NumPooled = 0;
+	}
+};
@@ -59,6 +59,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Equipment")
 	TArray<EEquipmentSlot> GetOpenSlotsForEquippable(AEquippable* Equippable);
 
+	/** Returns the slot an equippable is equipped in. Returns false if it isn't equipped. */
+	UFUNCTION(BlueprintPure, Category = "Equipment")
+	bool GetEquippedSlot(AEquippable* Equippable, EEquipmentSlot& OutSlot) const;
+
 	UFUNCTION(Server, Reliable, WithValidation)
 	void ServerEquipItem(AEquippable* Equippable, bool TryMoveReplacementToInventory = false);
 
@@ -88,6 +92,15 @@ public:
 protected:
 	TArray<EEquipmentSlot> GetOpenSlots(TArray<EEquipmentSlot> Slots);
 
+	/** Gets every slot an equippable's armor slot or weapon hand allows, regardless of what is equipped */
+	TArray<EEquipmentSlot> GetAllSlotsForEquippable(AEquippable* Equippable);
+
+	/**
+	 * Gets the slots of an equipment mapping that have to be emptied to equip an item to a slot: the slot itself, the off hand
+	 * for two handed weapons and the main hand for off hand items when it holds a two handed weapon.
+	 */
+	void GetSlotsToClearForEquip(AEquippable* Equippable, EEquipmentSlot Slot, const TMap<EEquipmentSlot, AEquippable*>& InEquipment, TArray<EEquipmentSlot>& OutSlots) const;
+
 	/** Attempts to equip an item to the specified slot.  This function will only run on the server. */
 	bool RequestEquipItem(AEquippable* Equippable, EEquipmentSlot Slot);
 
@@ -4,11 +4,28 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
 
+#include "EquipmentGlobals.h"
 #include "InventoryGlobals.h"
+#include "InventoryOccupancy.h"
 #include "InventoryComponent.generated.h"
 
 class AItem;
+class AEquippable;
+class UInventoryComponent;
+class UEquipmentComponent;
+
+/** Kinds of steps of an inventory transaction */
+UENUM(BlueprintType)
+enum class EInventoryOpType : uint8
+{
+	Move		UMETA(DisplayName = "Move"),
+	Swap		UMETA(DisplayName = "Swap"),
+	Equip		UMETA(DisplayName = "Equip"),
+	Unequip		UMETA(DisplayName = "Unequip"),
+	Drop		UMETA(DisplayName = "Drop")
+};
 
 /** Struct that stores inventory grid slot information */
 USTRUCT(BlueprintType)
@@ -31,10 +48,229 @@ struct FInventoryGridSlot
 	}
 };
 
+/** An independent inventory grid, like a backpack, a belt pouch or a stash. Every container has its own slots and occupancy masks. */
+USTRUCT(BlueprintType)
+struct FInventoryContainer
+{
+	GENERATED_BODY()
+
+	/** Display name of the container */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FText ContainerName;
+
+	/** The number of rows and columns that make up the container's grid. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FInventoryGridPair GridSize;
+
+	/** Can items be added to this container without picking a slot, like when picking them up? Stashes should only be filled by hand. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	bool bAcceptsAutoPlacement;
+
+	/** The grid representation of items in the container and their placement */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Transient)
+	TArray<FInventoryGridSlot> Grid;
+
+	/** Per row bitmasks of the occupied grid slots, kept in sync with Grid */
+	FInventoryOccupancy Occupancy;
+
+	/** Number of free grid slots, so full containers are skipped without looking at their masks */
+	int32 NumFreeSlots;
+
+	FInventoryContainer()
+	{
+		GridSize = FInventoryGridPair(6, 5);
+		bAcceptsAutoPlacement = true;
+		NumFreeSlots = 0;
+	}
+
+	/** Allocates the grid slots and occupancy masks for the grid size */
+	void InitGrid()
+	{
+		Grid.Reset();
+		Grid.AddDefaulted(GridSize.Column * GridSize.Row);
+		Occupancy.Init(GridSize.Column, GridSize.Row);
+		NumFreeSlots = Grid.Num();
+	}
+
+	/** Has the grid been allocated for the grid size? */
+	bool IsGridInitialized() const
+	{
+		return Grid.Num() == GridSize.Column * GridSize.Row && Occupancy.GetNumColumns() == GridSize.Column && Occupancy.GetNumRows() == GridSize.Row;
+	}
+
+	bool IsValidSlot(const FInventoryGridPair& GridSlot) const
+	{
+		return GridSlot.Column >= 0 && GridSlot.Column < GridSize.Column && GridSlot.Row >= 0 && GridSlot.Row < GridSize.Row;
+	}
+
+	int32 GetGridSlotIndex(const FInventoryGridPair& GridSlot) const
+	{
+		return GridSlot.Row * GridSize.Column + GridSlot.Column;
+	}
+};
+
+/** Where an item is stored in the inventory */
+struct FInventoryItemLocation
+{
+	int32 ContainerId;
+
+	/** The coordinates of the item's upper left most grid slot */
+	FInventoryGridPair OriginSlot;
+
+	/** The item's grid size when it was placed, which is the footprint its grid slots are freed with */
+	FInventoryGridPair Size;
+
+	/** Index of the item in Items. On the server this is also the index of its entry in ItemEntries. */
+	int32 ItemIndex;
+
+	FInventoryItemLocation()
+	{
+		ContainerId = INDEX_NONE;
+		ItemIndex = INDEX_NONE;
+	}
+};
+
+/** An item lifted from or placed in the grids while simulating inventory ops, recorded so the simulation can be undone */
+struct FInventorySimulationChange
+{
+	AItem* Item;
+
+	/** The location the item was lifted from or placed at */
+	FInventoryItemLocation Location;
+
+	bool bWasPlaced;
+
+	FInventorySimulationChange(AItem* InItem = nullptr, const FInventoryItemLocation& InLocation = FInventoryItemLocation(), bool bInWasPlaced = false)
+	{
+		Item = InItem;
+		Location = InLocation;
+		bWasPlaced = bInWasPlaced;
+	}
+};
+
+/** Replicated entry for an item stored in the inventory */
+USTRUCT()
+struct FInventoryItemEntry : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AItem* Item;
+
+	/** Index of the container the item is stored in */
+	UPROPERTY()
+	int32 ContainerId;
+
+	/** The coordinates of the item's upper left most grid slot */
+	UPROPERTY()
+	FInventoryGridPair OriginSlot;
+
+	FInventoryItemEntry()
+	{
+		Item = nullptr;
+		ContainerId = INDEX_NONE;
+		OriginSlot = FInventoryGridPair();
+	}
+
+	FInventoryItemEntry(AItem* InItem, int32 InContainerId, FInventoryGridPair InOriginSlot)
+	{
+		Item = InItem;
+		ContainerId = InContainerId;
+		OriginSlot = InOriginSlot;
+	}
+
+	void PreReplicatedRemove(const struct FInventoryItemArray& InArraySerializer);
+	void PostReplicatedAdd(const struct FInventoryItemArray& InArraySerializer);
+	void PostReplicatedChange(const struct FInventoryItemArray& InArraySerializer);
+};
+
+/** Delta replicated list of the items in an inventory. Only added, changed and removed entries are sent, and each one fires a callback on the receiving client. */
+USTRUCT()
+struct FInventoryItemArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FInventoryItemEntry> Entries;
+
+	/** The inventory the entries belong to, which the replication callbacks are forwarded to */
+	UPROPERTY(NotReplicated)
+	UInventoryComponent* OwningComponent;
+
+	FInventoryItemArray()
+	{
+		OwningComponent = nullptr;
+	}
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FInventoryItemEntry, FInventoryItemArray>(Entries, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryItemArray> : public TStructOpsTypeTraitsBase2<FInventoryItemArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * A single step of an inventory transaction, see UInventoryComponent::ServerExecuteInventoryOps.
+ * Move: moves an item in the inventory to the origin slot of a container.
+ * Swap: moves an item in the inventory onto the one item covering the target area, which takes the moved item's old location,
+ * or the first free slot if it doesn't fit there.
+ * Equip: equips an item from the inventory or another equipment slot to the equipment slot. Replaced equipment takes the item's
+ * old equipment slot if it can be equipped there, otherwise its old location or the first free slot. The op fails if it fits nowhere.
+ * Unequip: unequips the item in the equipment slot to the origin slot of a container. With no container, the item takes the first
+ * free slot and is dropped if it fits nowhere.
+ * Drop: takes an item out of the inventory or the equipment and drops it into the world.
+ */
+USTRUCT(BlueprintType)
+struct FInventoryOp
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EInventoryOpType Type;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	AItem* Item;
+
+	/** Target container of moves, swaps and unequips. INDEX_NONE places moved and unequipped items in the first free slot. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ContainerId;
+
+	/** Target origin slot of moves, swaps and unequips */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FInventoryGridPair OriginSlot;
+
+	/** Target slot of equips, source slot of unequips */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EEquipmentSlot EquipmentSlot;
+
+	FInventoryOp()
+	{
+		Type = EInventoryOpType::Move;
+		Item = nullptr;
+		ContainerId = INDEX_NONE;
+		OriginSlot = FInventoryGridPair();
+		EquipmentSlot = EEquipmentSlot::Head;
+	}
+
+	static FInventoryOp MakeMove(AItem* InItem, int32 InContainerId, FInventoryGridPair InOriginSlot);
+	static FInventoryOp MakeSwap(AItem* InItem, int32 InContainerId, FInventoryGridPair InOriginSlot);
+	static FInventoryOp MakeEquip(AItem* InItem, EEquipmentSlot InEquipmentSlot);
+	static FInventoryOp MakeUnequip(AItem* InItem, EEquipmentSlot InEquipmentSlot, int32 InContainerId = INDEX_NONE, FInventoryGridPair InOriginSlot = FInventoryGridPair());
+	static FInventoryOp MakeDrop(AItem* InItem);
+};
+
 /* Event delegate for when an item is added to the inventory */
-DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnItemAddedSignature, AItem*, Item, FInventoryGridPair, OriginGridSlot);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnItemAddedSignature, AItem*, Item, int32, ContainerId, FInventoryGridPair, OriginGridSlot);
 /* Event delegate for when an item is removed from the inventory */
-DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnItemRemovedSignature, AItem*, Item, FInventoryGridPair, OriginGridSlot);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnItemRemovedSignature, AItem*, Item, int32, ContainerId, FInventoryGridPair, OriginGridSlot);
 
 /** Actor component that stores inventory items. */
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
@@ -44,6 +280,7 @@ class DUNGEONDEATHMATCH_API UInventoryComponent : public UActorComponent
 
 public:
 	friend class UEquipmentComponent;
+	friend struct FInventoryItemEntry;
 
 	/* Delegate called when an item is added (for UI updates) */
 	UPROPERTY(BlueprintAssignable, Category = "Inventory")
@@ -54,39 +291,82 @@ public:
 	FOnItemRemovedSignature OnItemRemoved;
 
 protected:
-	/* The list of items stored in the inventory */
-	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Inventory")
+	/* The list of items stored in the inventory, rebuilt from ItemEntries on the owning client */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Inventory")
 	TArray<AItem*> Items;
 
-	/* The grid representation of items in the inventory and their placement */
-	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Inventory")
-	TArray<FInventoryGridSlot> InventoryGrid;
+	/* The containers of the inventory, identified by their index. Grids are rebuilt from ItemEntries on the owning client. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
+	TArray<FInventoryContainer> Containers;
+
+	/* The items and their origin slots, delta replicated to the owning client only */
+	UPROPERTY(Replicated)
+	FInventoryItemArray ItemEntries;
+
+	/** Location of every item in Items, so removing, moving and finding an item only touches its own grid slots */
+	TMap<AItem*, FInventoryItemLocation> ItemLocations;
 
-	/* The number of rows and columns that make up the inventory grid. */
-	UPROPERTY(Replicated, EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
-	FInventoryGridPair InventoryGridSize;
+	/** Every lift and placement of the inventory op simulation in progress, in order */
+	TArray<FInventorySimulationChange> SimulationChanges;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory", meta = (MakeEditWidget = true))
 	FVector ItemDropRelativeLocation;
 
+	/** Should added items be placed where they touch the most items and grid edges? Packs the grid tighter than using the first free slot. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory")
+	bool bBestFitPlacement;
+
 public:	
 	UInventoryComponent();
 	
 	TArray<AItem*> GetItems() { return Items; };
 
-	TArray<FInventoryGridSlot> GetInventoryGrid() { return InventoryGrid; };
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 GetNumContainers() const { return Containers.Num(); };
+
+	/** Returns the grid slots of a container, or an empty array for invalid container ids */
+	TArray<FInventoryGridSlot> GetInventoryGrid(int32 ContainerId);
 
-	FInventoryGridPair GetInventoryGridSize() { return InventoryGridSize; };
+	/** Returns the grid size of a container, or an empty size for invalid container ids */
+	FInventoryGridPair GetInventoryGridSize(int32 ContainerId);
 
 	FVector GetItemDropLocation();
 
+	/** Returns the container and origin slot of an item. Returns false if the item isn't in the inventory. */
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	bool GetItemLocation(AItem* Item, int32& OutContainerId, FInventoryGridPair& OutOriginSlot) const;
+
+	/** Returns true if an item of the given size fits at the origin slot of a container without overlapping any item */
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	bool IsGridAreaFree(int32 ContainerId, FInventoryGridPair OriginSlot, FInventoryGridPair Size) const;
+
+	/**
+	 * Finds a free origin slot for an item of the given size in the first container that accepts automatic placement and has
+	 * room for it, using best fit placement if enabled. Returns false if the item fits nowhere.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	bool FindFreeOriginSlot(FInventoryGridPair Size, int32& OutContainerId, FInventoryGridPair& OutOriginSlot) const;
+
+	/**
+	 * Applies a batch of moves, swaps, equips, unequips and drops across the inventory and equipment as one transaction. The whole batch
+	 * is first simulated on the grids, then the grid changes it recorded are undone in reverse, and only if every op succeeded is
+	 * the result applied, so either every op is applied or none is. On the owning client, the result is predicted right away and
+	 * rebuilt from the replicated entries if the server rejects the batch.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool ExecuteInventoryOps(const TArray<FInventoryOp>& Ops);
+
+	/** Server side function that applies a batch of inventory ops, see ExecuteInventoryOps */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerExecuteInventoryOps(const TArray<FInventoryOp>& Ops);
+
 	/** Server side function that attempts to add an item to the actor's inventory. Used for items that are currently "despawned" and may only be visible from UI elements. */
 	UFUNCTION(Server, Reliable, WithValidation)
 	virtual void ServerRequestAddItemToInventory(AItem* Item);
 
-	/** Server side function that attempts to add an item to the actor's inventory at the specified location. Used for items that are currently "despawned" and may only be visible from UI elements. */
+	/** Server side function that attempts to add an item to the actor's inventory at the specified location of a container. Used for items that are currently "despawned" and may only be visible from UI elements. */
 	UFUNCTION(Server, Reliable, WithValidation)
-	virtual void ServerRequestAddItemToInventoryAtLocation(AItem* Item, FInventoryGridPair OriginSlot);
+	virtual void ServerRequestAddItemToInventoryAtLocation(AItem* Item, int32 ContainerId, FInventoryGridPair OriginSlot);
 
 	/** Server side function that attempts to pick up an item and add it to the actor's inventory. Used when interacting with items in the world. */
 	UFUNCTION(Server, Reliable, WithValidation, Category = "Inventory")
@@ -106,23 +386,74 @@ protected:
 	/** Attempts to add an item to the inventory and returns the result. Only runs on the server. */
 	bool RequestAddItem(AItem* Item);
 
-	/** Attempts to add an item to the inventory at the specified grid location and returns the result. Only runs on the server. */
-	bool RequestAddItem(AItem* Item, FInventoryGridPair OriginSlot);
-
-	UFUNCTION(NetMulticast, Reliable, Category = "Inventory")
-	void MulticastOnItemAdded(AItem* Item, FInventoryGridPair OriginSlot);
+	/** Attempts to add an item to the inventory at the specified grid location of a container and returns the result. Only runs on the server. */
+	bool RequestAddItem(AItem* Item, int32 ContainerId, FInventoryGridPair OriginSlot);
 
 	/** Attempts to remove an item from the inventory and returns the result. Only runs on the server. */
 	bool RequestRemoveItem(AItem* Item);
 
-	UFUNCTION(NetMulticast, Reliable, Category = "Inventory")
-	void MulticastOnItemRemoved(AItem* Item, FInventoryGridPair OriginSlot);
+	/** Sent to the owning client when the server rejected its inventory ops, to undo the predicted result */
+	UFUNCTION(Client, Reliable)
+	void ClientRejectInventoryOps();
 
 private:
-	void AddItem(AItem* Item, FInventoryGridPair &OriginSlot);
+	void AddItem(AItem* Item, int32 ContainerId, FInventoryGridPair &OriginSlot);
 
 	void RemoveItem(int32 ItemIndex);
 
+	/** Marks the grid slots of a container covered by an item as holding it */
+	void PlaceItemInGrid(AItem* Item, int32 ContainerId, const FInventoryGridPair& OriginSlot);
+
+	/** Frees the grid slots of an item's footprint at its location that still hold the item */
+	void ClearItemFromGrid(AItem* Item, const FInventoryItemLocation& Location);
+
+	/** Records a new location for an item whose old grid slots were already freed, and places it there */
+	void SetItemLocation(AItem* Item, int32 ContainerId, const FInventoryGridPair& OriginSlot);
+
+	/** Adds an item to Items and the grid of a container, and records its location */
+	void AddItemLocation(AItem* Item, int32 ContainerId, const FInventoryGridPair& OriginSlot);
+
+	/** Removes an item from Items and the grid, and forgets its location. Returns false if the item isn't in the inventory. */
+	bool RemoveItemLocation(AItem* Item, FInventoryItemLocation& OutLocation);
+
+	/** Called on the owning client when an item entry was replicated */
+	void OnItemEntryAdded(const FInventoryItemEntry& Entry);
+
+	/** Called on the owning client before an item entry is removed */
+	void OnItemEntryRemoved(const FInventoryItemEntry& Entry);
+
+	/** Called on the owning client when an item entry was moved, or its item reference could be resolved. Moves the client predicted are skipped. */
+	void OnItemEntryChanged(const FInventoryItemEntry& Entry);
+
+	/** Removes every item from the grids and adds them back from the replicated entries, undoing any predicted changes */
+	void RebuildFromEntries();
+
+	/**
+	 * Runs a batch of inventory ops on the grids and a copy of the equipment, then undoes the grid changes. Returns false if any op
+	 * fails, otherwise the new location of every item the batch touched and the equipment after the batch. Items that end up
+	 * outside of the inventory have a location with ContainerId INDEX_NONE.
+	 */
+	bool SimulateInventoryOps(const TArray<FInventoryOp>& Ops, TMap<AItem*, FInventoryItemLocation>& OutChangedLocations, TMap<EEquipmentSlot, AEquippable*>& OutEquipment);
+
+	bool SimulateInventoryOp(const FInventoryOp& Op, UEquipmentComponent* EquipmentComponent, TMap<EEquipmentSlot, AEquippable*>& Equipment);
+
+	/** Frees an item's grid slots and forgets its location during a simulation, recording it in SimulationChanges */
+	bool LiftItem(AItem* Item, FInventoryItemLocation& OutLocation);
+
+	/** Places an item at the origin slot of a container during a simulation, or in the first free slot for INDEX_NONE, recording it in SimulationChanges. Returns false if it doesn't fit. */
+	bool TryPlaceItem(AItem* Item, int32 ContainerId, const FInventoryGridPair& OriginSlot);
+
+	/** Returns the only item covering an area of a container, or null if the area is empty or covers more than one item */
+	AItem* GetSingleItemInArea(int32 ContainerId, const FInventoryGridPair& OriginSlot, const FInventoryGridPair& Size) const;
+
+	/**
+	 * Applies the changed locations and the equipment of a simulation. Items leaving the inventory are removed first and moved items are lifted before any of
+	 * them is placed again, so items can trade places. Equipment only changes on the server, clients wait for it to replicate.
+	 */
+	void ApplyInventoryState(const TMap<AItem*, FInventoryItemLocation>& ChangedLocations, const TMap<EEquipmentSlot, AEquippable*>& NewEquipment, UEquipmentComponent* EquipmentComponent);
+
+	UEquipmentComponent* GetEquipmentComponent() const;
+
 	bool ValidateItem(AItem* Item);
 
 };
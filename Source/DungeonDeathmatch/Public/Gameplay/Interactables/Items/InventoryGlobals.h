@@ -10,10 +10,10 @@ struct FInventoryGridPair
 	GENERATED_BODY()
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	uint8 Column;
+	int32 Column;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	uint8 Row;
+	int32 Row;
 
 	FInventoryGridPair()
 	{
@@ -21,9 +21,19 @@ struct FInventoryGridPair
 		Column = 0;
 	}
 
-	FInventoryGridPair(uint8 GridColumn, uint8 GridRow)
+	FInventoryGridPair(int32 GridColumn, int32 GridRow)
 	{
 		Column = GridColumn;
 		Row = GridRow;
 	}
+
+	bool operator==(const FInventoryGridPair& Other) const
+	{
+		return Column == Other.Column && Row == Other.Row;
+	}
+
+	bool operator!=(const FInventoryGridPair& Other) const
+	{
+		return !(*this == Other);
+	}
 };
\ No newline at end of file
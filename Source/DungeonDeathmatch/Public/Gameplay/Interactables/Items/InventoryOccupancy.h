@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Occupancy of an inventory grid stored as one bitmask per row, kept in sync with the grid slots by the inventory component.
+ * Testing whether an item fits at a slot masks one word per row it covers, and searching for a free slot builds a mask of every
+ * origin an item fits at with a few shifts and ANDs per row, instead of testing the item's whole footprint at every slot.
+ */
+class DUNGEONDEATHMATCH_API FInventoryOccupancy
+{
+private:
+	int32 NumColumns;
+	int32 NumRows;
+
+	/** Number of 64 bit words each row is stored in */
+	int32 WordsPerRow;
+
+	/** WordsPerRow words per row, bit Column % 64 of word Column / 64 is set for occupied slots */
+	TArray<uint64> RowMasks;
+
+public:
+	FInventoryOccupancy();
+
+	/** Resizes the grid and frees every slot */
+	void Init(int32 InNumColumns, int32 InNumRows);
+
+	/** Frees every slot */
+	void Reset();
+
+	bool IsSlotOccupied(int32 Column, int32 Row) const;
+
+	/** Returns true if the Width x Height area at (Column, Row) is inside the grid and has no occupied slot */
+	bool IsAreaFree(int32 Column, int32 Row, int32 Width, int32 Height) const;
+
+	/** Marks every slot of the Width x Height area at (Column, Row) as occupied, clipped to the grid */
+	void FillArea(int32 Column, int32 Row, int32 Width, int32 Height);
+
+	/** Marks every slot of the Width x Height area at (Column, Row) as free, clipped to the grid */
+	void ClearArea(int32 Column, int32 Row, int32 Width, int32 Height);
+
+	/** Finds the first free origin for a Width x Height item in row major order. Returns false if the item fits nowhere. */
+	bool FindFirstFit(int32 Width, int32 Height, int32& OutColumn, int32& OutRow) const;
+
+	/**
+	 * Finds the free origin for a Width x Height item that touches the most occupied slots and grid edges, which keeps free
+	 * space together for larger items. Ties go to the first origin in row major order. Returns false if the item fits nowhere.
+	 */
+	bool FindBestFit(int32 Width, int32 Height, int32& OutColumn, int32& OutRow) const;
+
+	int32 GetNumColumns() const { return NumColumns; };
+
+	int32 GetNumRows() const { return NumRows; };
+
+private:
+	/** Sets or clears the bits of the Width x Height area at (Column, Row), clipped to the grid */
+	void SetArea(int32 Column, int32 Row, int32 Width, int32 Height, bool bOccupied);
+
+	/** Builds WordsPerRow words per row with a bit set for every origin a Width x Height item fits at */
+	void BuildFitMasks(int32 Width, int32 Height, TArray<uint64>& OutFitMasks) const;
+
+	/** Counts the occupied slots and grid edges along the border of the Width x Height area at (Column, Row) */
+	int32 CountContacts(int32 Column, int32 Row, int32 Width, int32 Height) const;
+
+	/** Bits of the columns in [Column, Column + Width) that fall into a word of a row */
+	static FORCEINLINE uint64 GetWordMask(int32 WordIndex, int32 Column, int32 Width)
+	{
+		const int32 WordStart = WordIndex * 64;
+		const int32 First = FMath::Max(Column - WordStart, 0);
+		const int32 Last = FMath::Min(Column + Width - WordStart, 64);
+		if (First >= Last)
+		{
+			return 0;
+		}
+		const uint64 UpperBits = Last == 64 ? ~0ull : ((1ull << Last) - 1);
+		return UpperBits & ~((1ull << First) - 1);
+	}
+};
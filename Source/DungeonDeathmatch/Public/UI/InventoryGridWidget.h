@@ -28,6 +28,10 @@ class DUNGEONDEATHMATCH_API UInventoryGridWidget : public UUserWidget
 	GENERATED_BODY()
 
 protected:
+	/** The index of the source inventory's container this widget displays. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory")
+	int32 ContainerId;
+
 	/** The number of rows and columns that make up the inventory grid. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory")
 	FInventoryGridPair InventoryGridSize;
@@ -84,13 +88,13 @@ public:
 	void InitializeGrid();
 
 protected:
-	/** Adds an item to the inventory grid widget at the specified location */
+	/** Adds an item to the inventory grid widget at the specified location, if it was added to the widget's container */
 	UFUNCTION()
-	void AddItem(AItem* Item, FInventoryGridPair OriginGridSlot);
+	void AddItem(AItem* Item, int32 ItemContainerId, FInventoryGridPair OriginGridSlot);
 
-	/** Removes an item from the inventory grid widget at the specified location */
+	/** Removes an item from the inventory grid widget at the specified location, if it was removed from the widget's container */
 	UFUNCTION()
-	void RemoveItem(AItem* Item, FInventoryGridPair OriginGridSlot);
+	void RemoveItem(AItem* Item, int32 ItemContainerId, FInventoryGridPair OriginGridSlot);
 
 	/** Highlights grid slots underneath the currently dragged item, signaling where the item will be placed and if it is a valid location. */
 	bool ValidateGridSelection(AItem* Item);
@@ -98,9 +102,17 @@ protected:
 	/** Removes highlights from all grid slots */
 	void ClearGridHighlights();
 
-	/** Event for when a draggable item is dropped on top of the grid. Processes the validity of the drop and makes any necessary additions or replacements to the inventory. */
+	/** Event for when a draggable item is dropped on top of the grid. Processes the validity of the drop and sends the resulting moves, swaps or unequips to the inventory as one batch. */
 	void ProcessItemDragAndDrop();
 
+	/** Hides the widget of an item of this grid while it is being dragged */
+	UFUNCTION()
+	void OnBeginItemDrag(AItem* Item);
+
+	/** Shows the widget of a dragged item of this grid again, wherever it ended up */
+	UFUNCTION()
+	void OnEndItemDrag(AItem* Item);
+
 	virtual void NativeTick(const FGeometry& MyGeometry, float DeltaTime) override;
 	virtual void NativeOnMouseEnter(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
 	virtual void NativeOnMouseLeave(const FPointerEvent& InMouseEvent) override;